@@ -1,15 +1,35 @@
 #pragma once
 
 #include <crl-basic/gui/application.h>
+#include <crl-basic/utils/tripleBuffer.h>
 
 #include "loco/controller/KinematicTrackingController.h"
+#include "loco/gui/ContactScheduleVisualizer.h"
+#include "loco/gui/PlanRenderer.h"
+#include "loco/gui/RBRenderer.h"
 #include "loco/planner/GaitPlanner.h"
+#include "loco/planner/LocomotionPlan.h"
 #include "loco/planner/SimpleLocomotionTrajectoryPlanner.h"
+#include "loco/robot/RobotStateBuffer.h"
 #include "menu.h"
-#include "loco/shared/value_share.h"
 
 namespace locoApp {
 
+// what the UI asks of the planner, which the UI never touches itself, since
+// the simulation may be stepped on another thread
+struct PlannerInput {
+    double speedForward = 0;
+    double turningSpeed = 0;
+    bool incrementalReplanning = false;
+};
+
+// what the UI shows of the simulation, as the thread that steps it published it
+struct ProcessStats {
+    crl::loco::IK_SolveStats ik;
+    double simTime = 0;
+    int recomputedKnotCount = 0;
+};
+
 class App : public crl::gui::ShadowApplication {
 public:
     App() : crl::gui::ShadowApplication("Locomotion App") {
@@ -27,21 +47,36 @@ public:
     ~App() override = default;
 
     void process() override {
-        // add gait plan
-        controller_->planner->appendPeriodicGaitIfNeeded(gaitPlanner_->getPeriodicGait(robot_));
-
-        double simTime = 0;
-        while (simTime < 1.0 / targetFramerate) {
-            simTime += dt;
-            controller_->computeAndApplyControlSignals(dt);
-            controller_->advanceInTime(dt);
-        }
+        double dt = scheduler.getTimeStep();
+        pickUpPlannerInput();
+
+        // add gait plan (the planner thread does this itself)
+        if (!asynchronousPlanning)
+            controller_->planner->appendPeriodicGaitIfNeeded(*gaitPlanner_);
+
+        controller_->computeAndApplyControlSignals(dt);
+        controller_->advanceInTime(dt);
 
         // generate motion plan
         controller_->generateMotionTrajectories();
 
+        // hand the state over to drawing, which may happen on another thread
+        stateBuffer_->publish(*robot_);
+        publishStats();
+        if (drawDebugInfo)
+            publishPlan();
+    }
+
+    void prepareToDraw() override {
+        ShadowApplication::prepareToDraw();
+
+        // draw the latest complete state, in between the last two steps
+        stateBuffer_->update();
+        stateBuffer_->apply(*renderRobot_, processIsRunning ? scheduler.getInterpolationFactor() : 1.0);
+        plans_->update();
+
         // adjust light and camera
-        const auto &center = robot_->getTrunk()->getWorldCoordinates(crl::P3D());
+        const auto &center = renderRobot_->getTrunk()->getWorldCoordinates(crl::P3D());
         if (followRobotWithCamera) {
             camera.target.x = (float)center.x;
             camera.target.z = (float)center.z;
@@ -59,14 +94,15 @@ public:
     }
 
     void drawShadowCastingObjects(const crl::gui::Shader &shader) override {
-        robot_->draw(shader);
+        crl::loco::RBRenderer::drawRobot(*renderRobot_, shader);
     }
 
     void drawObjectsWithoutShadows(const crl::gui::Shader &shader) override {
-        robot_->draw(shader);
+        crl::loco::RBRenderer::drawRobot(*renderRobot_, shader);
 
+        // as the simulation published it, since it may be stepped on another thread
         if (drawDebugInfo)
-            controller_->drawDebugInfo(&basicShader);
+            crl::loco::PlanRenderer::drawTrajectories(plans_->getFrontBuffer(), basicShader);
     }
 
     std::string getJointName() {
@@ -166,6 +202,7 @@ public:
     bool keyPressed(int key, int mods) override {
         if (key == GLFW_KEY_SPACE) {
             processIsRunning = !processIsRunning;
+            processCallback();
         }
         if (key == GLFW_KEY_ENTER) {
             if (!processIsRunning)
@@ -175,36 +212,36 @@ public:
         // joystick command
         bool dirty = false;
         double speedIncrement = 0.5;
+        const crl::loco::GaitParameters &gait = *planner_->gaitParameters;
         if (key == GLFW_KEY_UP) {
-            if (planner_->speedForward == 0.0) {
+            if (plannerInput_.speedForward == 0.0) {
                 // Directly set speed to initSpeed to avoid akward walking in place.
-                planner_->speedForward = initSpeed;
+                plannerInput_.speedForward = gait.getInitSpeed();
             } else {
-                planner_->speedForward = std::clamp(planner_->speedForward + speedIncrement, 0.0, maxSpeed);
+                plannerInput_.speedForward = std::clamp(plannerInput_.speedForward + speedIncrement, 0.0, gait.getMaxSpeed());
             }
             dirty = true;
         }
         if (key == GLFW_KEY_DOWN) {
-            if (planner_->speedForward - speedIncrement < initSpeed) {
+            if (plannerInput_.speedForward - speedIncrement < gait.getInitSpeed()) {
 
-                planner_->speedForward = 0.0;
+                plannerInput_.speedForward = 0.0;
             } else {
-                planner_->speedForward = std::clamp(planner_->speedForward - speedIncrement, 0.0, maxSpeed);
+                plannerInput_.speedForward = std::clamp(plannerInput_.speedForward - speedIncrement, 0.0, gait.getMaxSpeed());
             }
             dirty = true;
         }
         if (key == GLFW_KEY_LEFT) {
-            planner_->turningSpeed += 0.5;
+            plannerInput_.turningSpeed += 0.5;
             dirty = true;
         }
         if (key == GLFW_KEY_RIGHT) {
-            planner_->turningSpeed -= 0.5;
+            plannerInput_.turningSpeed -= 0.5;
             dirty = true;
         }
 
         if (dirty) {
-            planner_->appendPeriodicGaitIfNeeded(gaitPlanner_->getPeriodicGait(robot_));
-            controller_->generateMotionTrajectories();
+            publishPlannerInput();
             return true;
         }
 
@@ -488,6 +525,9 @@ public:
 
     void drawImGui() override {
         crl::gui::ShadowApplication::drawImGui();
+        // resizing the ground rebakes it, and the planners only have a copy
+        if (ground.getHeightField()->getVersion() != groundVersion_)
+            restart();
 
         ImGui::Begin("Main Menu");
         ImGui::Checkbox("Follow Robot with Camera", &followRobotWithCamera);
@@ -500,13 +540,46 @@ public:
                 robot_->showSkeleton = !robot_->showMeshes;
             }
             ImGui::Checkbox("Show end effectors", &robot_->showEndEffectors);
-            ImGui::Checkbox("Draw debug info", &drawDebugInfo);
+            renderRobot_->showMeshes = robot_->showMeshes;
+            renderRobot_->showSkeleton = robot_->showSkeleton;
+            renderRobot_->showEndEffectors = robot_->showEndEffectors;
+            // nothing gets published while the debug info is not drawn
+            if (ImGui::Checkbox("Draw debug info", &drawDebugInfo) && drawDebugInfo && !scheduler.isRunning())
+                publishPlan();
+        }
+        stats_->update();
+        const ProcessStats &processStats = stats_->getFrontBuffer();
+        if (ImGui::CollapsingHeader("IK")) {
+            const auto &stats = processStats.ik;
+            ImGui::Text("Iterations: %d (%d rejected)", stats.iterations, stats.rejectedSteps);
+            ImGui::Text("Residual: %.2e -> %.2e%s", stats.initialResidual, stats.finalResidual, stats.converged ? " (converged)" : "");
+            ImGui::Text("Lambda: %.2e", stats.lambda);
+            ImGui::Text("Solve time: %.3f ms", stats.solveTime * 1000.0);
+        }
+        if (ImGui::CollapsingHeader("Planner")) {
+            // the planner thread owns its planner, so these are only for planning in sync
+            if (!asynchronousPlanning) {
+                if (ImGui::Checkbox("Incremental replanning", &plannerInput_.incrementalReplanning))
+                    publishPlannerInput();
+                ImGui::Text("Knots recomputed: %d", processStats.recomputedKnotCount);
+            }
+            if (ImGui::Checkbox("Asynchronous planning", &asynchronousPlanning))
+                restart();
+            if (asynchronousPlanning) {
+                const auto &asyncPlanner = controller_->asyncPlanner;
+                ImGui::Text("Plan: %d (%.3f s old)", asyncPlanner->getPublishedPlanVersion(),
+                            processStats.simTime - asyncPlanner->getPublishedPlanGenerationTime());
+                double rate = controller_->asyncPlanner->getPlanningRate();
+                if (ImGui::InputDouble("Planning rate", &rate))
+                    controller_->asyncPlanner->setPlanningRate(std::max(rate, 1.0));
+            }
         }
 
         ImGui::End();
 
-        planner_->visualizeContactSchedule();
-        planner_->visualizeParameters();
+        // the contact schedule is read straight from the planner, so only while nothing steps it
+        if (!asynchronousPlanning && !scheduler.isRunning())
+            contactScheduleVisualizer_.visualize(planner_->cpm, planner_->getSimTime());
     }
 
     void drawImPlot() override {
@@ -523,6 +596,13 @@ public:
 
 private:
     void setupRobotAndController() {
+        // the process thread must not step the robot while it is replaced
+        bool processThreadWasRunning = scheduler.isRunning();
+        scheduler.stop();
+
+        // stops the planner thread, if there is one
+        controller_ = nullptr;
+
         std::cout << "Welcome to your Digital Bob Editor v  1.3 🦵" <<std::endl;
         std::cout << "********************************************************" <<std::endl;
         std::cout << ""  <<std::endl;
@@ -530,9 +610,7 @@ private:
         std::cout << ""  <<std::endl;
         std::cout << "********************************************************" <<std::endl;
         const auto &m = modelOptions[selectedModel];
-        const char *rbsFile = m.filePath.c_str();
-        robot_ = std::make_shared<crl::loco::LeggedRobot>(rbsFile);
-        robot_->setRootState(crl::P3D(0, m.baseTargetHeight, 0));
+        robot_ = loadRobot(m);
         if (m.type == ModelOption::Type::DOG) {
             robot_->showMeshes = false;
             robot_->showSkeleton = true;
@@ -541,38 +619,120 @@ private:
             gaitPlanner_ = std::make_shared<crl::loco::BipedalGaitPlanner>();
         }
 
-        // add legs
-        for (int i = 0; i < m.legs.size(); i++) {
-            robot_->addLimb(m.legs[i].first, m.legs[i].second);
-        }
+        // the robot that is drawn, in between the last two states of the simulated one
+        renderRobot_ = loadRobot(m);
+        renderRobot_->showMeshes = robot_->showMeshes;
+        renderRobot_->showSkeleton = robot_->showSkeleton;
+        stateBuffer_ = std::make_shared<crl::loco::RobotStateBuffer>();
+        stateBuffer_->publish(*robot_);
 
         // setup planner and controller
         planner_ = std::make_shared<crl::loco::SimpleLocomotionTrajectoryPlanner>(robot_);
         planner_->trunkHeight = m.baseTargetHeight;
         planner_->targetStepHeight = m.swingFootHeight;
         controller_ = std::make_shared<crl::loco::KinematicTrackingController>(planner_);
+        plannerInput_ = {planner_->speedForward, planner_->turningSpeed, planner_->incrementalReplanning};
+        plannerInputs_ = std::make_shared<crl::TripleBuffer<PlannerInput>>();
+
+        // the planners may run on other threads than the UI, which rebakes the
+        // ground in place, so they plan on a copy of it
+        auto plannedGround = std::make_shared<const crl::HeightField>(*ground.getHeightField());
+        groundVersion_ = ground.getHeightField()->getVersion();
+        planner_->setGround(plannedGround);
+
+        // the planner thread plans for a copy of the robot, with a planner of its own
+        if (asynchronousPlanning) {
+            auto plannerRobot = loadRobot(m);
+            auto threadPlanner = std::make_shared<crl::loco::SimpleLocomotionTrajectoryPlanner>(plannerRobot);
+            threadPlanner->trunkHeight = m.baseTargetHeight;
+            threadPlanner->targetStepHeight = m.swingFootHeight;
+            threadPlanner->setGround(plannedGround);
+            controller_->asyncPlanner = std::make_shared<crl::loco::AsynchronousPlanner>(threadPlanner, gaitPlanner_);
+        }
 
         // generate plan
-        planner_->appendPeriodicGaitIfNeeded(gaitPlanner_->getPeriodicGait(robot_));
+        if (!asynchronousPlanning)
+            planner_->appendPeriodicGaitIfNeeded(*gaitPlanner_);
         controller_->generateMotionTrajectories();
-        
+        plans_ = std::make_shared<crl::TripleBuffer<crl::loco::LocomotionPlan>>();
+        publishPlan();
+        stats_ = std::make_shared<crl::TripleBuffer<ProcessStats>>();
+        publishStats();
+
+        if (processThreadWasRunning)
+            scheduler.start([this]() { baseProcess(); });
+    }
+
+    // on the thread that steps the simulation: hands the plan being tracked
+    // over to drawing
+    void publishPlan() {
+        controller_->samplePlan(plans_->getBackBuffer(), scheduler.getTimeStep());
+        plans_->publish();
+    }
+
+    // on the thread that steps the simulation: hands what the UI shows over to it
+    void publishStats() {
+        ProcessStats &stats = stats_->getBackBuffer();
+        stats.ik = controller_->ikSolver->getLastSolveStats();
+        stats.simTime = planner_->getSimTime();
+        stats.recomputedKnotCount = planner_->getRecomputedKnotCount();
+        stats_->publish();
+    }
+
+    // UI: hands plannerInput_ over to the thread that steps the simulation,
+    // which picks it up at the start of its next step. If no other thread
+    // steps it, the UI picks it up right away, and replans
+    void publishPlannerInput() {
+        plannerInputs_->getBackBuffer() = plannerInput_;
+        plannerInputs_->publish();
+        if (scheduler.isRunning() || !pickUpPlannerInput())
+            return;
+        if (!asynchronousPlanning)
+            planner_->appendPeriodicGaitIfNeeded(*gaitPlanner_);
+        controller_->generateMotionTrajectories();
+        publishStats();
+        if (drawDebugInfo)
+            publishPlan();
+    }
+
+    // on the thread that steps the simulation: applies the latest input of
+    // the UI, if there is one it has not applied yet
+    bool pickUpPlannerInput() {
+        if (!plannerInputs_->update())
+            return false;
+        const PlannerInput &input = plannerInputs_->getFrontBuffer();
+        planner_->speedForward = input.speedForward;
+        planner_->turningSpeed = input.turningSpeed;
+        planner_->incrementalReplanning = input.incrementalReplanning;
+        return true;
     }
 
 public:
     // simulation
     std::shared_ptr<crl::loco::LeggedRobot> robot_ = nullptr;
     std::shared_ptr<crl::loco::GaitPlanner> gaitPlanner_ = nullptr;
-    std::shared_ptr<crl::loco::LocomotionTrajectoryPlanner> planner_ = nullptr;
+    std::shared_ptr<crl::loco::SimpleLocomotionTrajectoryPlanner> planner_ = nullptr;
     std::shared_ptr<crl::loco::KinematicTrackingController> controller_ = nullptr;
+    // the version of the ground the planners have a copy of
+    int groundVersion_ = 0;
+
+    // drawing: a copy of the robot, set to the states the simulation publishes
+    std::shared_ptr<crl::loco::LeggedRobot> renderRobot_ = nullptr;
+    std::shared_ptr<crl::loco::RobotStateBuffer> stateBuffer_ = nullptr;
+    std::shared_ptr<crl::TripleBuffer<crl::loco::LocomotionPlan>> plans_ = nullptr;
+    std::shared_ptr<crl::TripleBuffer<ProcessStats>> stats_ = nullptr;
+    crl::loco::ContactScheduleVisualizer contactScheduleVisualizer_;
 
-    // parameters
-    double dt = 1 / 60.0;
+    // input: kept by the UI, and handed over to the thread that steps the simulation
+    PlannerInput plannerInput_;
+    std::shared_ptr<crl::TripleBuffer<PlannerInput>> plannerInputs_ = nullptr;
 
     // options
     uint selectedModel = 0;
     bool followRobotWithCamera = true;
     bool uneven_terrain = false;
     bool drawDebugInfo = true;
+    bool asynchronousPlanning = false;
 };
 
 }  // namespace locoApp
@@ -1,9 +1,15 @@
+#pragma once
+
 #include <string.h>
 
+#include <algorithm>
+#include <cctype>
+#include <memory>
 #include <string>
 #include <vector>
 
 #include "crl-basic/utils/mathDefs.h"
+#include "loco/robot/LeggedRobot.h"
 
 namespace locoApp {
 
@@ -56,4 +62,36 @@ const std::vector<ModelOption> modelOptions = {
     },
 };
 
+/**
+ * returns the model option called name (in any case), or nullptr if there is
+ * none
+ */
+inline const ModelOption *findModelOption(const std::string &name) {
+    auto toLower = [](std::string s) {
+        std::transform(s.begin(), s.end(), s.begin(), [](unsigned char c) { return (char)tolower(c); });
+        return s;
+    };
+    for (const auto &option : modelOptions)
+        if (toLower(option.name) == toLower(name))
+            return &option;
+    return nullptr;
+}
+
+/**
+ * loads the robot of the model, with the limbs the app tracks, and puts its
+ * root at the target height of the model. Throws if a limb does not end in a
+ * rigid body with an end effector
+ */
+inline std::shared_ptr<crl::loco::LeggedRobot> loadRobot(const ModelOption &m) {
+    auto robot = std::make_shared<crl::loco::LeggedRobot>(m.filePath.c_str());
+    robot->setRootState(crl::P3D(0, m.baseTargetHeight, 0));
+    for (const auto &leg : m.legs) {
+        auto rb = robot->getRBByName(leg.second.c_str());
+        if (rb == nullptr || rb->rbProps.endEffectorPoints.empty())
+            crl::throwError("limb %s: %s has no rigid body %s with an end effector", leg.first.c_str(), m.filePath.c_str(), leg.second.c_str());
+        robot->addLimb(leg.first, rb);
+    }
+    return robot;
+}
+
 }  // namespace locoApp
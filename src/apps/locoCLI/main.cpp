@@ -0,0 +1,169 @@
+#include <crl-basic/utils/timer.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "loco/controller/KinematicTrackingController.h"
+#include "loco/planner/GaitPlanner.h"
+#include "loco/planner/SimpleLocomotionTrajectoryPlanner.h"
+#include "menu.h"
+
+/**
+ * Runs the locomotion pipeline of locoApp (gait planner, trajectory planner,
+ * kinematic tracking controller and IK) without a window or an OpenGL
+ * context, for a fixed amount of simulated time, and writes the state of the
+ * robot at every step to a CSV file. Meant for batch runs, profiling and
+ * regression checks on machines without a display.
+ */
+
+namespace {
+
+void printUsage(const char *exe) {
+    printf("usage: %s [options]\n", exe);
+    printf("  --model <name>      one of the models of locoApp (default bob)\n");
+    printf("  --rbs <file>        loads the robot from this file instead, with the\n");
+    printf("                      gait and heights of the model\n");
+    printf("  --limb <name>:<rb>  a limb ending in the rigid body rb. Repeat for every\n");
+    printf("                      limb; replaces the limbs of the model\n");
+    printf("  --seconds <s>       simulated time (default 10)\n");
+    printf("  --dt <s>            simulation step (default 1/60)\n");
+    printf("  --plan-dt <s>       time between two plans (default 1/60)\n");
+    printf("  --speed <m/s>       forward speed (default %g)\n", crl::loco::GaitParameters().getInitSpeed());
+    printf("  --out <file.csv>    writes the state of the robot at every step\n");
+}
+
+// the time, the pose of the root and the angles of all joints, one row per step
+void writeHeader(FILE *fp, crl::loco::LeggedRobot &robot) {
+    fprintf(fp, "t,x,y,z,qw,qx,qy,qz");
+    for (int i = 0; i < robot.getJointCount(); i++)
+        fprintf(fp, ",%s", robot.getJoint(i)->name.c_str());
+    fprintf(fp, "\n");
+}
+
+void writeState(FILE *fp, double t, crl::loco::LeggedRobot &robot) {
+    crl::P3D p = robot.getTrunk()->getWorldCoordinates(crl::P3D());
+    crl::Quaternion q = robot.getTrunk()->getOrientation();
+    fprintf(fp, "%.6lf,%.9lf,%.9lf,%.9lf,%.9lf,%.9lf,%.9lf,%.9lf", t, p.x, p.y, p.z, q.w(), q.x(), q.y(), q.z());
+    for (int i = 0; i < robot.getJointCount(); i++)
+        fprintf(fp, ",%.9lf", robot.getJoint(i)->getCurrentJointAngle());
+    fprintf(fp, "\n");
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+    std::string modelName = "bob";
+    std::string rbsFile;
+    std::vector<std::pair<std::string, std::string>> limbs;
+    double seconds = 10;
+    double dt = 1 / 60.0;
+    double planDt = 1 / 60.0;
+    double speed = crl::loco::GaitParameters().getInitSpeed();
+    std::string outFile;
+
+    for (int i = 1; i < argc; i++) {
+        bool hasValue = i + 1 < argc;
+        if (strcmp(argv[i], "--model") == 0 && hasValue)
+            modelName = argv[++i];
+        else if (strcmp(argv[i], "--rbs") == 0 && hasValue)
+            rbsFile = argv[++i];
+        else if (strcmp(argv[i], "--limb") == 0 && hasValue && strchr(argv[i + 1], ':') != nullptr) {
+            std::string limb = argv[++i];
+            limbs.emplace_back(limb.substr(0, limb.find(':')), limb.substr(limb.find(':') + 1));
+        }
+        else if (strcmp(argv[i], "--seconds") == 0 && hasValue)
+            seconds = atof(argv[++i]);
+        else if (strcmp(argv[i], "--dt") == 0 && hasValue)
+            dt = atof(argv[++i]);
+        else if (strcmp(argv[i], "--plan-dt") == 0 && hasValue)
+            planDt = atof(argv[++i]);
+        else if (strcmp(argv[i], "--speed") == 0 && hasValue)
+            speed = atof(argv[++i]);
+        else if (strcmp(argv[i], "--out") == 0 && hasValue)
+            outFile = argv[++i];
+        else {
+            printUsage(argv[0]);
+            return strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    const locoApp::ModelOption *option = locoApp::findModelOption(modelName);
+    if (option == nullptr || seconds < 0 || dt <= 0 || planDt < dt) {
+        printUsage(argv[0]);
+        return 1;
+    }
+
+    // the model, or another robot with the gait and heights of the model
+    locoApp::ModelOption model = *option;
+    if (!rbsFile.empty())
+        model.filePath = rbsFile;
+    if (!limbs.empty())
+        model.legs = limbs;
+
+    // the same setup as locoApp
+    std::shared_ptr<crl::loco::LeggedRobot> robot;
+    try {
+        robot = locoApp::loadRobot(model);
+    } catch (...) {
+        // the loader printed what went wrong
+        return 1;
+    }
+    std::shared_ptr<crl::loco::GaitPlanner> gaitPlanner;
+    if (model.type == locoApp::ModelOption::Type::DOG)
+        gaitPlanner = std::make_shared<crl::loco::QuadrupedalGaitPlanner>();
+    else
+        gaitPlanner = std::make_shared<crl::loco::BipedalGaitPlanner>();
+
+    auto planner = std::make_shared<crl::loco::SimpleLocomotionTrajectoryPlanner>(robot);
+    planner->trunkHeight = model.baseTargetHeight;
+    planner->targetStepHeight = model.swingFootHeight;
+    planner->speedForward = speed;
+    auto controller = std::make_shared<crl::loco::KinematicTrackingController>(planner);
+
+    planner->appendPeriodicGaitIfNeeded(*gaitPlanner);
+    controller->generateMotionTrajectories();
+
+    FILE *fp = nullptr;
+    if (!outFile.empty()) {
+        fp = fopen(outFile.c_str(), "w");
+        if (fp == nullptr) {
+            std::cerr << "could not open " << outFile << " for writing" << std::endl;
+            return 1;
+        }
+        writeHeader(fp, *robot);
+        writeState(fp, 0, *robot);
+    }
+
+    // the loop of locoApp's process: a few simulation steps per plan
+    crl::Timer timer;
+    crl::P3D start = robot->getTrunk()->getWorldCoordinates(crl::P3D());
+    int nSteps = (int)(seconds / dt + 0.5);
+    double timeSincePlan = 0;
+    for (int k = 1; k <= nSteps; k++) {
+        controller->computeAndApplyControlSignals(dt);
+        controller->advanceInTime(dt);
+        if (fp != nullptr)
+            writeState(fp, k * dt, *robot);
+
+        timeSincePlan += dt;
+        if (timeSincePlan >= planDt - 1e-9) {
+            timeSincePlan = 0;
+            planner->appendPeriodicGaitIfNeeded(*gaitPlanner);
+            controller->generateMotionTrajectories();
+        }
+    }
+    double wallTime = timer.timeEllapsed();
+
+    if (fp != nullptr)
+        fclose(fp);
+
+    crl::P3D end = robot->getTrunk()->getWorldCoordinates(crl::P3D());
+    printf("%s walked %.3lf m in %.2lf s of simulated time (%d steps)\n", model.name.c_str(), crl::V3D(start, end).norm(), nSteps * dt, nSteps);
+    printf("wall time: %.3lf s (%.1lfx real time)\n", wallTime, wallTime > 0 ? nSteps * dt / wallTime : 0.0);
+    return 0;
+}
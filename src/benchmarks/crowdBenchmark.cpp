@@ -0,0 +1,63 @@
+#include <crl-basic/utils/timer.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <thread>
+
+#include "loco/crowd/Crowd.h"
+#include "menu.h"
+
+using namespace crl;
+using namespace crl::loco;
+
+/**
+ * Times a step of crowds of 1 to 1000 Bobs walking at different speeds, on
+ * one thread and on all cores, as well as per character and step.
+ */
+int main() {
+    const int crowdSizes[] = {1, 10, 100, 1000};
+    const double dt = 1 / 60.0;
+    const int nCores = std::max(1, (int)std::thread::hardware_concurrency());
+    auto gaitPlanner = std::make_shared<BipedalGaitPlanner>();
+    const double initSpeed = GaitParameters().getInitSpeed();
+
+    Timer timer;
+    double checksum = 0;
+
+    // seconds per step of a crowd of n characters, stepped on nThreads threads
+    auto timeSteps = [&](int n, int nThreads) {
+        Crowd crowd(nThreads);
+        for (int i = 0; i < n; i++) {
+            auto robot = locoApp::loadRobot(*locoApp::findModelOption("Bob"));
+            // side by side, at speeds between initSpeed and 2 m/s
+            robot->setRootState(P3D(2.0 * i, 0.9, 0));
+            crowd.addCharacter(robot, gaitPlanner, 0.9, 1.0, initSpeed + (2.0 - initSpeed) * (i % 10) / 9.0);
+        }
+
+        // warm up: the first plans allocate their storage
+        for (int k = 0; k < 30; k++)
+            crowd.step(dt);
+
+        // about as many character steps for every crowd size
+        int nSteps = std::max(10, 6000 / n);
+        timer.restart();
+        for (int k = 0; k < nSteps; k++)
+            crowd.step(dt);
+        double t = timer.timeEllapsed() / nSteps;
+
+        for (int i = 0; i < n; i++)
+            checksum += crowd.getCharacter(i).robot->getTrunk()->getWorldCoordinates(P3D()).z;
+        return t;
+    };
+
+    printf("crowd step, %d steps per character per second (%d cores):\n", (int)(1 / dt + 0.5), nCores);
+    printf("  %10s %14s %14s %14s %10s\n", "characters", "1 thread", "all cores", "per character", "speedup");
+    for (int n : crowdSizes) {
+        double serial = timeSteps(n, 1);
+        double parallel = timeSteps(n, nCores);
+        printf("  %10d %11.3lf ms %11.3lf ms %11.2lf us %9.2lfx\n", n, serial * 1e3, parallel * 1e3, parallel / n * 1e6, serial / parallel);
+    }
+    printf("(checksum %lf)\n", checksum);
+
+    return 0;
+}
@@ -0,0 +1,85 @@
+#include <crl-basic/utils/timer.h>
+
+#include <cstdio>
+
+#include "loco/robot/GeneralizedCoordinatesRobotRepresentation.h"
+#include "menu.h"
+
+using namespace crl;
+using namespace crl::loco;
+
+/**
+ * Times the mass matrix and the Coriolis and centrifugal forces of Bob, as
+ * computed from the jacobians of every rigid body (computeMassMatrix,
+ * computeCoriolisAndCentrifugalForcesTerm) and with the composite rigid body
+ * and recursive Newton-Euler algorithms.
+ */
+int main() {
+    const int nReps = 1000;
+
+    auto robot = locoApp::loadRobot(*locoApp::findModelOption("Bob"));
+    GCRR gcrr(robot);
+
+    dVector q, qDot;
+    gcrr.getQ(q);
+    resize(qDot, q.size());
+    srand(0);
+    for (int i = 0; i < q.size(); i++) {
+        q[i] += 0.5 * ((double)rand() / RAND_MAX - 0.5);
+        qDot[i] = 2.0 * ((double)rand() / RAND_MAX - 0.5);
+    }
+    gcrr.setQ(q);
+    gcrr.setQDot(qDot);
+
+    Matrix M1, M2;
+    dVector C1, C2, qDDot = qDot, tau;
+
+    Timer timer;
+    double checksum = 0;
+
+    timer.restart();
+    for (int k = 0; k < nReps; k++) {
+        gcrr.computeMassMatrix(M1);
+        checksum += M1(6, 6);
+    }
+    double massMatrixJacobians = timer.timeEllapsed();
+
+    timer.restart();
+    for (int k = 0; k < nReps; k++) {
+        gcrr.computeMassMatrixCRBA(M2);
+        checksum += M2(6, 6);
+    }
+    double massMatrixCRBA = timer.timeEllapsed();
+
+    // the reference Coriolis term is much slower, so it gets fewer reps
+    timer.restart();
+    for (int k = 0; k < nReps / 100; k++) {
+        gcrr.computeCoriolisAndCentrifugalForcesTerm(C1);
+        checksum += C1[6];
+    }
+    double coriolisJacobians = timer.timeEllapsed();
+
+    timer.restart();
+    for (int k = 0; k < nReps; k++) {
+        gcrr.computeBiasForcesRNEA(C2, false);
+        checksum += C2[6];
+    }
+    double coriolisRNEA = timer.timeEllapsed();
+
+    timer.restart();
+    for (int k = 0; k < nReps; k++) {
+        gcrr.computeInverseDynamicsRNEA(qDDot, tau);
+        checksum += tau[6];
+    }
+    double inverseDynamicsRNEA = timer.timeEllapsed();
+
+    double maxError = std::max((M1 - M2).norm() / M1.norm(), (C1 - C2).norm() / C1.norm());
+
+    printf("GCRR dynamics (bob_RB.rbs, %d dofs, max relative error %.2e, checksum %lf)\n", (int)q.size(), maxError, checksum);
+    printf("  mass matrix, jacobians:        %10.4lf us\n", massMatrixJacobians / nReps * 1e6);
+    printf("  mass matrix, CRBA:             %10.4lf us (%.2lfx)\n", massMatrixCRBA / nReps * 1e6, massMatrixJacobians / massMatrixCRBA);
+    printf("  Coriolis forces, jacobians:    %10.4lf us\n", coriolisJacobians / (nReps / 100) * 1e6);
+    printf("  Coriolis forces, RNEA:         %10.4lf us (%.2lfx)\n", coriolisRNEA / nReps * 1e6, coriolisJacobians / (nReps / 100) / (coriolisRNEA / nReps));
+    printf("  inverse dynamics, RNEA:        %10.4lf us\n", inverseDynamicsRNEA / nReps * 1e6);
+    return 0;
+}
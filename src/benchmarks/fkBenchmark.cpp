@@ -0,0 +1,192 @@
+#include <crl-basic/utils/timer.h>
+
+#include <cstdio>
+
+#include "loco/robot/GeneralizedCoordinatesRobotRepresentation.h"
+#include "menu.h"
+
+using namespace crl;
+using namespace crl::loco;
+
+/**
+ * Reference implementations that walk up the hierarchy for every query, the
+ * way GCRR did before it cached the world transforms of its dofs.
+ */
+P3D getWorldCoordinatesByChainWalk(const GCRR &gcrr, const P3D &p, const std::shared_ptr<const RB> &rb) {
+    V3D offset(p);
+    int qIndex = gcrr.getQStartIndexForRB(rb);
+
+    if (rb->pJoint != nullptr)
+        offset = V3D(rb->pJoint->cJPos, p);
+
+    while (qIndex > 2) {
+        offset = gcrr.getOffsetFromParentToQ(qIndex) + rotateVec(offset, gcrr.getQVal(qIndex), gcrr.getQAxis(qIndex));
+        qIndex = gcrr.getParentQIndex(qIndex);
+    }
+
+    return P3D(gcrr.getQVal(0), gcrr.getQVal(1), gcrr.getQVal(2)) + offset;
+}
+
+void compute_dpdqByChainWalk(const GCRR &gcrr, const P3D &p, const std::shared_ptr<const RB> &rb, Matrix &dpdq) {
+    resize(dpdq, 3, gcrr.getDimensionSize());
+
+    int startIndex = gcrr.getQStartIndexForRB(rb);
+    int loopIndex = startIndex;
+    while (loopIndex > 2) {
+        V3D offset(p);
+        if (rb->pJoint != nullptr)
+            offset = V3D(rb->pJoint->cJPos, p);
+        int qIndex = startIndex;
+
+        while (qIndex > loopIndex) {
+            offset = gcrr.getOffsetFromParentToQ(qIndex) + rotateVec(offset, gcrr.getQVal(qIndex), gcrr.getQAxis(qIndex));
+            qIndex = gcrr.getParentQIndex(qIndex);
+        }
+
+        offset = gcrr.getQAxis(qIndex).cross(offset);
+
+        while (qIndex > 2) {
+            offset = rotateVec(offset, gcrr.getQVal(qIndex), gcrr.getQAxis(qIndex));
+            qIndex = gcrr.getParentQIndex(qIndex);
+        }
+
+        dpdq.col(loopIndex) = offset;
+        loopIndex = gcrr.getParentQIndex(loopIndex);
+    }
+
+    dpdq(0, 0) = 1;
+    dpdq(1, 1) = 1;
+    dpdq(2, 2) = 1;
+}
+
+/**
+ * Times FK and jacobian queries on Bob with cached world transforms against
+ * the chain walk, as well as the cost of updating the cache in setQ. Also
+ * compares per body and batched jacobians, and the mass matrix assembled per
+ * body against the one assembled from the batched jacobians.
+ */
+int main() {
+    const int nReps = 10000;
+
+    auto robot = locoApp::loadRobot(*locoApp::findModelOption("Bob"));
+    GCRR gcrr(robot);
+
+    dVector q;
+    gcrr.getQ(q);
+    srand(0);
+    for (int i = 6; i < q.size(); i++)
+        q[i] += 0.5 * ((double)rand() / RAND_MAX - 0.5);
+    gcrr.setQ(q);
+
+    std::vector<std::shared_ptr<const RB>> rbs;
+    for (int i = 0; i < robot->getJointCount(); i++)
+        rbs.push_back(robot->getJoint(i)->child);
+
+    // make sure both agree before timing them
+    double maxError = 0;
+    Matrix J1, J2;
+    for (const auto &rb : rbs) {
+        maxError = std::max(maxError, V3D(getWorldCoordinatesByChainWalk(gcrr, P3D(0.1, 0, 0), rb), gcrr.getWorldCoordinates(P3D(0.1, 0, 0), rb)).norm());
+        compute_dpdqByChainWalk(gcrr, P3D(0.1, 0, 0), rb, J1);
+        gcrr.compute_dpdq(P3D(0.1, 0, 0), rb, J2);
+        maxError = std::max(maxError, (J1 - J2).norm());
+    }
+
+    Timer timer;
+    double checksum = 0;
+
+    timer.restart();
+    for (int k = 0; k < nReps; k++)
+        for (const auto &rb : rbs)
+            checksum += getWorldCoordinatesByChainWalk(gcrr, P3D(), rb).y;
+    double fkChainWalk = timer.timeEllapsed();
+
+    timer.restart();
+    for (int k = 0; k < nReps; k++)
+        for (const auto &rb : rbs)
+            checksum += gcrr.getWorldCoordinates(P3D(), rb).y;
+    double fkCached = timer.timeEllapsed();
+
+    timer.restart();
+    for (int k = 0; k < nReps / 10; k++)
+        for (const auto &rb : rbs) {
+            compute_dpdqByChainWalk(gcrr, P3D(), rb, J1);
+            checksum += J1(0, 6);
+        }
+    double jacobianChainWalk = timer.timeEllapsed();
+
+    timer.restart();
+    for (int k = 0; k < nReps / 10; k++)
+        for (const auto &rb : rbs) {
+            gcrr.compute_dpdq(P3D(), rb, J2);
+            checksum += J2(0, 6);
+        }
+    double jacobianCached = timer.timeEllapsed();
+
+    // linear and angular jacobians of all COMs, per body and batched
+    std::vector<P3D> coms(rbs.size(), P3D(0, 0, 0));
+    Matrix dpdq, dRdq, JR;
+    timer.restart();
+    for (int k = 0; k < nReps / 10; k++)
+        for (const auto &rb : rbs) {
+            gcrr.compute_dpdq(P3D(), rb, J1);
+            gcrr.compute_angular_jacobian(rb, JR);
+            checksum += J1(0, 6) + JR(0, 6);
+        }
+    double jacobiansPerBody = timer.timeEllapsed();
+
+    timer.restart();
+    for (int k = 0; k < nReps / 10; k++) {
+        gcrr.compute_jacobians(rbs, coms, dpdq, dRdq);
+        checksum += dpdq(0, 6) + dRdq(0, 6);
+    }
+    double jacobiansBatched = timer.timeEllapsed();
+
+    // mass matrix, summed up per body and from the batched jacobians
+    Matrix M1, M2, MRB;
+    timer.restart();
+    for (int k = 0; k < nReps / 100; k++) {
+        gcrr.computeMassMatrixForRB(robot->getRoot(), M1);
+        for (const auto &rb : rbs) {
+            gcrr.computeMassMatrixForRB(rb, MRB);
+            M1 += MRB;
+        }
+    }
+    double massMatrixPerBody = timer.timeEllapsed();
+
+    timer.restart();
+    for (int k = 0; k < nReps / 100; k++)
+        gcrr.computeMassMatrix(M2);
+    double massMatrixBatched = timer.timeEllapsed();
+    maxError = std::max(maxError, (M1 - M2).norm());
+
+    // setQ with every joint changed, and with only the last joint changed
+    dVector q2 = q;
+    timer.restart();
+    for (int k = 0; k < nReps; k++) {
+        q2.tail(q.size() - 6).array() += 1e-6;
+        gcrr.setQ(q2);
+    }
+    double setQAll = timer.timeEllapsed();
+
+    timer.restart();
+    for (int k = 0; k < nReps; k++) {
+        q2[q.size() - 1] += 1e-6;
+        gcrr.setQ(q2);
+    }
+    double setQLeaf = timer.timeEllapsed();
+
+    int nRBs = (int)rbs.size();
+    printf("GCRR forward kinematics (bob_RB.rbs, %d rigid bodies, %d dofs, max error %.2e, checksum %lf)\n", nRBs, (int)q.size(), maxError, checksum);
+    printf("  world coordinates, chain walk: %10.4lf us/query\n", fkChainWalk / (nReps * nRBs) * 1e6);
+    printf("  world coordinates, cached:     %10.4lf us/query (%.2lfx)\n", fkCached / (nReps * nRBs) * 1e6, fkChainWalk / fkCached);
+    printf("  dp/dq, chain walk:             %10.4lf us/query\n", jacobianChainWalk / (nReps / 10 * nRBs) * 1e6);
+    printf("  dp/dq, cached:                 %10.4lf us/query (%.2lfx)\n", jacobianCached / (nReps / 10 * nRBs) * 1e6, jacobianChainWalk / jacobianCached);
+    printf("  dp/dq and dR/dq, per body:     %10.4lf us/body\n", jacobiansPerBody / (nReps / 10 * nRBs) * 1e6);
+    printf("  dp/dq and dR/dq, batched:      %10.4lf us/body (%.2lfx)\n", jacobiansBatched / (nReps / 10 * nRBs) * 1e6, jacobiansPerBody / jacobiansBatched);
+    printf("  mass matrix, per body:         %10.4lf us\n", massMatrixPerBody / (nReps / 100) * 1e6);
+    printf("  mass matrix, batched:          %10.4lf us (%.2lfx)\n", massMatrixBatched / (nReps / 100) * 1e6, massMatrixPerBody / massMatrixBatched);
+    printf("  setQ, all joints changed:      %10.4lf us/call\n", setQAll / nReps * 1e6);
+    printf("  setQ, last joint changed:      %10.4lf us/call\n", setQLeaf / nReps * 1e6);
+    return 0;
+}
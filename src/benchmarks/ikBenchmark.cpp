@@ -0,0 +1,95 @@
+#include <crl-basic/utils/timer.h>
+
+#include <cstdio>
+
+#include "loco/controller/KinematicTrackingController.h"
+#include "loco/planner/GaitPlanner.h"
+#include "loco/planner/SimpleLocomotionTrajectoryPlanner.h"
+#include "menu.h"
+
+using namespace crl;
+using namespace crl::loco;
+
+/**
+ * IK time, iterations and final residual per control frame, averaged over a run
+ */
+struct IKBenchmarkResult {
+    double time = 0;
+    double iterations = 0;
+    double residual = 0;
+};
+
+/**
+ * Measures the IK time per control frame for Bob walking forward, once per
+ * jacobian/target mode. The plan is regenerated every frame, exactly as in locoApp.
+ * Without convergence checks, the solver always takes all its steps with fixed
+ * damping and starts from the robot's state, as it did before early termination.
+ */
+IKBenchmarkResult benchmarkIK(IK_JacobianMode mode, IK_TargetMode targetMode, int nFrames, double dt, bool convergenceChecks = true) {
+    auto robot = locoApp::loadRobot(*locoApp::findModelOption("Bob"));
+    auto gaitPlanner = std::make_shared<BipedalGaitPlanner>();
+    auto planner = std::make_shared<SimpleLocomotionTrajectoryPlanner>(robot);
+    planner->trunkHeight = 0.9;
+    planner->speedForward = 1.0;
+    auto controller = std::make_shared<KinematicTrackingController>(planner);
+    controller->ikSolver->setJacobianMode(mode);
+    controller->ikSolver->setTargetMode(targetMode);
+    if (!convergenceChecks) {
+        controller->ikSolver->setTolerances(0, 0);
+        controller->ikSolver->setAdaptiveDamping(false);
+        controller->ikSolver->setWarmStart(false);
+    }
+
+    planner->appendPeriodicGaitIfNeeded(*gaitPlanner);
+    controller->generateMotionTrajectories(dt);
+
+    IKBenchmarkResult result;
+    Timer timer;
+    for (int frame = 0; frame < nFrames; frame++) {
+        double t = planner->getSimTime() + dt;
+        robot->setRootState(planner->getTargetTrunkPositionAtTime(t), planner->getTargetTrunkOrientationAtTime(t));
+        for (int i = 0; i < robot->getLimbCount(); i++) {
+            const auto &limb = robot->getLimb(i);
+            controller->ikSolver->addEndEffectorTarget(limb->eeRB, limb->ee->endEffectorOffset, planner->getTargetLimbEEPositionAtTime(limb, t));
+        }
+
+        timer.restart();
+        controller->ikSolver->solve();
+        result.time += timer.timeEllapsed();
+        result.iterations += controller->ikSolver->getLastSolveStats().iterations;
+        result.residual += controller->ikSolver->getLastSolveStats().finalResidual;
+
+        controller->advanceInTime(dt);
+        planner->appendPeriodicGaitIfNeeded(*gaitPlanner);
+        controller->generateMotionTrajectories(dt);
+    }
+    result.time /= nFrames;
+    result.iterations /= nFrames;
+    result.residual /= nFrames;
+    return result;
+}
+
+void printResult(const char *name, const IKBenchmarkResult &result) {
+    printf("  %-40s %10.4lf ms/frame, %5.2lf iterations, residual %.2e\n", name, result.time * 1000.0, result.iterations, result.residual);
+}
+
+int main() {
+    const int nFrames = 300;
+    const double dt = 1.0 / 30.0;
+
+    auto analytic = benchmarkIK(IK_JacobianMode::ANALYTIC, IK_TargetMode::STACKED, nFrames, dt);
+    auto fd = benchmarkIK(IK_JacobianMode::FINITE_DIFFERENCE, IK_TargetMode::STACKED, nFrames, dt);
+    auto sequential = benchmarkIK(IK_JacobianMode::ANALYTIC, IK_TargetMode::SEQUENTIAL, nFrames, dt);
+    auto decomposed = benchmarkIK(IK_JacobianMode::ANALYTIC, IK_TargetMode::DECOMPOSED, nFrames, dt);
+    auto fixedSteps = benchmarkIK(IK_JacobianMode::ANALYTIC, IK_TargetMode::DECOMPOSED, nFrames, dt, false);
+
+    printf("IK (bob_RB.rbs, 8 limbs, %d frames)\n", nFrames);
+    printResult("stacked, analytic jacobian:", analytic);
+    printResult("stacked, finite difference jacobian:", fd);
+    printResult("sequential, analytic jacobian:", sequential);
+    printResult("decomposed, analytic jacobian:", decomposed);
+    printResult("decomposed, no convergence checks:", fixedSteps);
+    printf("  analytic vs finite difference jacobian: %.2lfx, early termination: %.2lfx\n", fd.time / analytic.time,
+           fixedSteps.time / decomposed.time);
+    return 0;
+}
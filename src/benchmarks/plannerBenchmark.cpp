@@ -0,0 +1,129 @@
+#include <crl-basic/utils/timer.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+
+#include "loco/planner/GaitPlanner.h"
+#include "loco/planner/SimpleLocomotionTrajectoryPlanner.h"
+#include "menu.h"
+
+using namespace crl;
+using namespace crl::loco;
+
+/**
+ * Times replanning for Bob walking forward, with the limb trajectories
+ * generated one after the other and in parallel on a thread pool, as well as
+ * replanning every frame from scratch against extending the previous plan.
+ * Also times the contact phase queries the limb trajectories make, answered
+ * by searching the contact schedule, by a cursor, and from a timeline.
+ */
+int main() {
+    const int nReps = 1000;
+
+    auto robot = locoApp::loadRobot(*locoApp::findModelOption("Bob"));
+    SimpleLocomotionTrajectoryPlanner planner(robot);
+    planner.trunkHeight = 0.9;
+    planner.speedForward = 1.0;
+    BipedalGaitPlanner gaitPlanner;
+    planner.appendPeriodicGaitIfNeeded(gaitPlanner);
+    planner.generateTrajectoriesFromCurrentState();
+
+    auto threadPool = std::make_shared<ThreadPool>();
+    Timer timer;
+    double checksum = 0;
+
+    const double dt = 1 / 30.0;
+    auto timeReplans = [&](const std::shared_ptr<ThreadPool> &pool, bool limbsOnly) {
+        planner.threadPool = pool;
+        timer.restart();
+        for (int k = 0; k < nReps; k++) {
+            if (limbsOnly)
+                planner.generateLimbTrajectories(dt);
+            else
+                planner.generateTrajectoriesFromCurrentState(dt);
+            checksum += planner.getTargetLimbEEPositionAtTime(robot->getLimb(k % robot->getLimbCount()), 0.5).y;
+        }
+        return timer.timeEllapsed() / nReps;
+    };
+
+    double limbsSerial = timeReplans(nullptr, true);
+    double limbsParallel = timeReplans(threadPool, true);
+    double replanSerial = timeReplans(nullptr, false);
+    double replanParallel = timeReplans(threadPool, false);
+
+    // one frame after the other, as in the app: this plans new knots only
+    // when the plan was extended
+    auto timeFrames = [&](bool incremental, int &nKnots) {
+        planner.threadPool = nullptr;
+        planner.incrementalReplanning = incremental;
+        nKnots = 0;
+        timer.restart();
+        for (int k = 0; k < nReps; k++) {
+            planner.advanceInTime(dt);
+            planner.appendPeriodicGaitIfNeeded(gaitPlanner);
+            planner.generateTrajectoriesFromCurrentState(dt);
+            nKnots += planner.getRecomputedKnotCount();
+            checksum += planner.getTargetLimbEEPositionAtTime(robot->getLimb(k % robot->getLimbCount()), planner.simTime + 0.5).y;
+        }
+        return timer.timeEllapsed() / nReps;
+    };
+
+    int nKnotsFull = 0, nKnotsIncremental = 0;
+    double framesFull = timeFrames(false, nKnotsFull);
+    double framesIncremental = timeFrames(true, nKnotsIncremental);
+
+    // every limb, at every knot time of the planning horizon. The best of a
+    // few runs, as these are short
+    const int nKnotTimes = (int)((planner.tPlanningHorizon + planner.tPlanningHorizonBuffer) / dt) + 1;
+    auto timeQueries = [&](const std::function<void(const std::shared_ptr<RobotLimb> &)> &queryLimb) {
+        double best = 1e10;
+        for (int run = 0; run < 5; run++) {
+            timer.restart();
+            for (int k = 0; k < nReps; k++)
+                for (uint i = 0; i < robot->getLimbCount(); i++)
+                    queryLimb(robot->getLimb(i));
+            best = std::min(best, timer.timeEllapsed() / nReps);
+        }
+        return best;
+    };
+    const ContactPlanManager &cpm = planner.cpm;
+    double tStart = planner.simTime;
+    double queriesSearched = timeQueries([&](const std::shared_ptr<RobotLimb> &limb) {
+        double t = tStart;
+        for (int k = 0; k < nKnotTimes; k++, t += dt)
+            checksum += cpm.getCPInformationFor(limb, t).getTimeLeft();
+    });
+    double queriesCursor = timeQueries([&](const std::shared_ptr<RobotLimb> &limb) {
+        ContactPhaseCursor cursor(cpm.cs, limb);
+        double t = tStart;
+        for (int k = 0; k < nKnotTimes; k++, t += dt)
+            checksum += cursor.getContactPhaseInformation(t).getTimeLeft();
+    });
+    const ContactTimeline &timeline = planner.cpm.getTimeline(tStart, dt, nKnotTimes);
+    double queriesTimeline = timeQueries([&](const std::shared_ptr<RobotLimb> &limb) {
+        const auto &timeLeft = timeline.timeLeft[limb->limbIndex];
+        for (int k = 0; k < nKnotTimes; k++)
+            checksum += timeLeft[k];
+    });
+    double queriesTimelineCursor = timeQueries([&](const std::shared_ptr<RobotLimb> &limb) {
+        ContactPhaseCursor cursor = cpm.getCPCursorFor(limb);
+        double t = tStart;
+        for (int k = 0; k < nKnotTimes; k++, t += dt)
+            checksum += cursor.getContactPhaseInformation(t).getTimeLeft();
+    });
+
+    printf("planner (bob_RB.rbs, %d limbs, %d threads, checksum %lf)\n", robot->getLimbCount(), threadPool->getThreadCount(), checksum);
+    printf("  limb trajectories, serial:   %10.4lf us\n", limbsSerial * 1e6);
+    printf("  limb trajectories, parallel: %10.4lf us (%.2lfx)\n", limbsParallel * 1e6, limbsSerial / limbsParallel);
+    printf("  whole replan, serial:        %10.4lf us\n", replanSerial * 1e6);
+    printf("  whole replan, parallel:      %10.4lf us (%.2lfx)\n", replanParallel * 1e6, replanSerial / replanParallel);
+    printf("  frame, full replan:          %10.4lf us (%.1lf knots)\n", framesFull * 1e6, (double)nKnotsFull / nReps);
+    printf("  frame, incremental replan:   %10.4lf us (%.1lf knots, %.2lfx)\n", framesIncremental * 1e6, (double)nKnotsIncremental / nReps, framesFull / framesIncremental);
+    printf("contact queries (%d limbs x %d knot times)\n", robot->getLimbCount(), nKnotTimes);
+    printf("  binary search:               %10.4lf us\n", queriesSearched * 1e6);
+    printf("  cursor:                      %10.4lf us (%.2lfx)\n", queriesCursor * 1e6, queriesSearched / queriesCursor);
+    printf("  timeline arrays:             %10.4lf us (%.2lfx)\n", queriesTimeline * 1e6, queriesSearched / queriesTimeline);
+    printf("  cursor on the timeline:      %10.4lf us (%.2lfx)\n", queriesTimelineCursor * 1e6, queriesSearched / queriesTimelineCursor);
+    return 0;
+}
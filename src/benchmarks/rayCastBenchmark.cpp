@@ -0,0 +1,117 @@
+#include <crl-basic/gui/model.h>
+#include <crl-basic/utils/timer.h>
+
+#include <cstdio>
+
+using namespace crl;
+using namespace crl::gui;
+
+/**
+ * Reference implementation that tests the ray against every triangle of the
+ * model, the way Model::hitByRay did before the meshes had bounding volume
+ * hierarchies. Returns the ray parameter of the closest hit.
+ */
+double hitByRayBruteForce(const Model &model, const Ray &ray) {
+    Quaternion orientationInv = model.orientation.inverse();
+    V3D origin = orientationInv * V3D(model.position, ray.origin);
+    V3D dir = orientationInv * ray.dir;
+    for (int idx = 0; idx < 3; idx++) {
+        origin[idx] /= model.scale[idx];
+        dir[idx] /= model.scale[idx];
+    }
+
+    double t = std::numeric_limits<double>::infinity();
+    for (const auto &m : model.meshes) {
+        for (unsigned int i = 0; i < m.indices.size() / 3; ++i) {
+            V3D v0 = toV3D(m.vertices[m.indices[3 * i + 0]].position);
+            V3D e1 = toV3D(m.vertices[m.indices[3 * i + 1]].position) - v0;
+            V3D e2 = toV3D(m.vertices[m.indices[3 * i + 2]].position) - v0;
+
+            V3D p = dir.cross(e2);
+            double det = e1.dot(p);
+            if (fabs(det) < 1e-14)
+                continue;
+            V3D s = origin - v0;
+            double u = s.dot(p) / det;
+            V3D q = s.cross(e1);
+            double v = dir.dot(q) / det;
+            double t_ = e2.dot(q) / det;
+            if (u >= 0 && v >= 0 && u + v <= 1 && t_ > 1e-8 && t_ < t)
+                t = t_;
+        }
+    }
+    return t;
+}
+
+/**
+ * Times ray casts at a model through the bounding volume hierarchies of its
+ * meshes, one ray at a time and batched, against testing every triangle.
+ */
+void benchmarkModel(const char *name, const P3D &center, double radius) {
+    const int nQueries = 1000;
+
+    Model model(std::string(CRL_DATA_FOLDER "/meshes/") + name);
+    int nTriangles = 0;
+    for (const auto &mesh : model.meshes)
+        nTriangles += (int)mesh.indices.size() / 3;
+
+    // rays from random points around the model, aimed at random points in it
+    srand(0);
+    std::vector<Ray> rays(nQueries);
+    for (auto &ray : rays) {
+        P3D origin = center + V3D(getRandomNumberInRange(-1, 1), getRandomNumberInRange(-1, 1), getRandomNumberInRange(-1, 1)).normalized() * 3 * radius;
+        P3D target = center + V3D(getRandomNumberInRange(-1, 1), getRandomNumberInRange(-1, 1), getRandomNumberInRange(-1, 1)) * radius;
+        ray = Ray(origin, V3D(origin, target).normalized());
+    }
+
+    Timer timer;
+    double tFirst;
+    model.hitByRay(rays[0].origin, rays[0].dir, tFirst);
+    double buildTime = timer.timeEllapsed();
+
+    double checksum = 0;
+    std::vector<double> tBruteForce(nQueries);
+    timer.restart();
+    for (int i = 0; i < nQueries; i++) {
+        tBruteForce[i] = hitByRayBruteForce(model, rays[i]);
+        if (tBruteForce[i] < 1e10)
+            checksum += tBruteForce[i];
+    }
+    double bruteForceTime = timer.timeEllapsed() / nQueries;
+
+    const int nReps = 100;
+    std::vector<double> tSingle(nQueries);
+    timer.restart();
+    for (int k = 0; k < nReps; k++)
+        for (int i = 0; i < nQueries; i++)
+            if (model.hitByRay(rays[i].origin, rays[i].dir, tSingle[i]))
+                checksum += tSingle[i];
+    double singleTime = timer.timeEllapsed() / (nReps * nQueries);
+
+    std::vector<double> tBatched(nQueries);
+    int nHits = 0;
+    timer.restart();
+    for (int k = 0; k < nReps; k++) {
+        nHits = model.hitByRays(rays.data(), tBatched.data(), nQueries);
+        checksum += tBatched[k % nQueries] < 1e10 ? tBatched[k % nQueries] : 0;
+    }
+    double batchedTime = timer.timeEllapsed() / (nReps * nQueries);
+
+    int nMismatches = 0;
+    for (int i = 0; i < nQueries; i++)
+        if (tBatched[i] != tSingle[i] || fabs(tBatched[i] - tBruteForce[i]) > 1e-6 * std::max(1.0, fabs(tBruteForce[i])))
+            nMismatches++;
+
+    printf("%s (%d triangles, %d of %d rays hit, %d mismatches, hierarchies built in %.2lf ms, checksum %lf)\n", name, nTriangles, nHits, nQueries, nMismatches,
+           buildTime * 1e3, checksum);
+    printf("  every triangle:  %10.4lf us/ray\n", bruteForceTime * 1e6);
+    printf("  BVH:             %10.4lf us/ray (%.2lfx)\n", singleTime * 1e6, bruteForceTime / singleTime);
+    printf("  BVH, batched:    %10.4lf us/ray (%.2lfx)\n", batchedTime * 1e6, bruteForceTime / batchedTime);
+}
+
+int main() {
+    benchmarkModel("nanosuit.obj", P3D(0, 8, 0), 8);
+    benchmarkModel("terrain2.obj", P3D(0, 0, 0), 20);
+    benchmarkModel("sphere.obj", P3D(0, 0, 0), 1);
+    return 0;
+}
@@ -0,0 +1,59 @@
+#include <crl-basic/utils/timer.h>
+
+#include <cstdio>
+
+#include "menu.h"
+
+using namespace crl;
+using namespace crl::loco;
+
+/**
+ * Times Robot::setState and Robot::populateState on 1000 Bobs, each switching
+ * between two poses of its own, the way a crowd updates its characters.
+ */
+int main() {
+    const int nRobots = 1000;
+    const int nReps = 100;
+
+    std::vector<std::shared_ptr<LeggedRobot>> robots;
+    std::vector<RobotState> states[2];
+    srand(0);
+    for (int i = 0; i < nRobots; i++) {
+        auto robot = locoApp::loadRobot(*locoApp::findModelOption("Bob"));
+        for (auto &s : states) {
+            RobotState state(*robot);
+            state.setPosition(P3D(2.0 * i, 0.9, 0));
+            for (int j = 0; j < state.getJointCount(); j++)
+                state.setJointRelativeOrientation(getRotationQuaternion(getRandomNumberInRange(-0.5, 0.5), robot->getJoint(j)->rotationAxis), j);
+            s.push_back(state);
+        }
+        robots.push_back(robot);
+    }
+
+    Timer timer;
+    double checksum = 0;
+
+    timer.restart();
+    for (int k = 0; k < nReps; k++)
+        for (int i = 0; i < nRobots; i++)
+            robots[i]->setState(states[k % 2][i]);
+    double setState = timer.timeEllapsed();
+
+    RobotState state;
+    timer.restart();
+    for (int k = 0; k < nReps; k++)
+        for (int i = 0; i < nRobots; i++) {
+            robots[i]->populateState(state);
+            checksum += state.getJointRelativeOrientation(0).w();
+        }
+    double populateState = timer.timeEllapsed();
+
+    for (const auto &robot : robots)
+        checksum += robot->getJoint(robot->getJointCount() - 1)->child->getWorldCoordinates(P3D()).y;
+
+    int nCalls = nReps * nRobots;
+    printf("robot state (%d x bob_RB.rbs, %d rigid bodies each, checksum %lf)\n", nRobots, robots[0]->getJointCount() + 1, checksum);
+    printf("  setState:      %10.4lf us/call %12.0lf calls/s\n", setState / nCalls * 1e6, nCalls / setState);
+    printf("  populateState: %10.4lf us/call %12.0lf calls/s\n", populateState / nCalls * 1e6, nCalls / populateState);
+    return 0;
+}
@@ -0,0 +1,75 @@
+#include <crl-basic/gui/renderer.h>
+#include <crl-basic/utils/timer.h>
+
+#include <cstdio>
+
+using namespace crl;
+using namespace crl::gui;
+
+/**
+ * Times terrain height queries through the height field of
+ * SizeableGroundModel against casting a ray at the terrain mesh
+ * (Model::hitByRay, which is what getHeight used to do).
+ */
+void benchmarkTerrain(const char *name) {
+    const int nQueries = 1000;
+
+    SizeableGroundModel ground(10);
+    Timer timer;
+    ground.loadTerrain(std::string(CRL_DATA_FOLDER "/meshes/") + name);
+    double bakeTime = timer.timeEllapsed();
+
+    int nTriangles = 0;
+    for (const auto &mesh : ground.terrain.meshes)
+        nTriangles += (int)mesh.indices.size() / 3;
+
+    // random points over the footprint of the terrain
+    srand(0);
+    std::vector<double> xs(nQueries), zs(nQueries);
+    for (int i = 0; i < nQueries; i++) {
+        xs[i] = getRandomNumberInRange(-16, 16);
+        zs[i] = getRandomNumberInRange(-20, 20);
+    }
+
+    double checksum = 0;
+    std::vector<double> rayHeights(nQueries);
+    timer.restart();
+    for (int i = 0; i < nQueries; i++) {
+        P3D hitPoint;
+        ground.terrain.hitByRay(P3D(xs[i], 1000.0, zs[i]), V3D(0, -1.0, 0), hitPoint);
+        rayHeights[i] = hitPoint[1];
+        checksum += rayHeights[i];
+    }
+    double rayTime = timer.timeEllapsed() / nQueries;
+
+    const int nReps = 1000;
+    timer.restart();
+    for (int k = 0; k < nReps; k++)
+        for (int i = 0; i < nQueries; i++)
+            checksum += ground.getHeight(xs[i], zs[i]);
+    double heightFieldTime = timer.timeEllapsed() / (nReps * nQueries);
+
+    std::vector<double> heights(nQueries);
+    timer.restart();
+    for (int k = 0; k < nReps; k++) {
+        ground.getHeights(xs.data(), zs.data(), heights.data(), nQueries);
+        checksum += heights[k % nQueries];
+    }
+    double batchedTime = timer.timeEllapsed() / (nReps * nQueries);
+
+    // the mesh is stored in single precision, so the heights agree up to that
+    double maxError = 0;
+    for (int i = 0; i < nQueries; i++)
+        maxError = std::max(maxError, fabs(heights[i] - rayHeights[i]));
+
+    printf("%s (%d triangles, height field baked in %.2lf ms, max error %.2e, checksum %lf)\n", name, nTriangles, bakeTime * 1e3, maxError, checksum);
+    printf("  ray cast:              %10.4lf us/query\n", rayTime * 1e6);
+    printf("  height field:          %10.4lf us/query (%.2lfx)\n", heightFieldTime * 1e6, rayTime / heightFieldTime);
+    printf("  height field, batched: %10.4lf us/query (%.2lfx)\n", batchedTime * 1e6, rayTime / batchedTime);
+}
+
+int main() {
+    benchmarkTerrain("terrain.obj");
+    benchmarkTerrain("terrain2.obj");
+    return 0;
+}
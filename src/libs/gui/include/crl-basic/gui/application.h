@@ -16,8 +16,7 @@
 #include <imgui_widgets/imGuIZMOquat.h>
 #include <imgui_widgets/imgui_add.h>
 #include <imgui_widgets/implot.h>
-
-#include <thread>
+#include <crl-basic/utils/simulationScheduler.h>
 
 namespace crl {
 namespace gui {
@@ -36,6 +35,8 @@ public:
 
     //--- Process
     virtual void restart() {}
+    // advances the simulation by one step of scheduler.getTimeStep(). The
+    // scheduler decides how many steps every frame takes
     virtual void process() {}
     virtual void baseProcess();
     virtual void processCallback();
@@ -86,9 +87,11 @@ public:
     float averagePercentTimeSpentProcessing = 0.f;
 
     //--- Process
+    // if set, the scheduler steps the simulation on a thread of its own,
+    // rather than in between frames
     bool useSeparateProcessThread = false;
-    std::thread processThread;
     bool processIsRunning = false;
+    SimulationScheduler scheduler;
 
     //--- Console
     bool automanageConsole = false;
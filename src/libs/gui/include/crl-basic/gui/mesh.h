@@ -10,8 +10,11 @@
 
 #define GLM_ENABLE_EXPERIMENTAL
 #include <map>
+#include <memory>
 #include <vector>
 
+#include "crl-basic/utils/bvh.h"
+
 #include "glm/gtx/hash.hpp"
 
 namespace crl {
@@ -66,6 +69,19 @@ public:
     // initializes all the buffer objects/arrays
     void reinitialize(const std::vector<Vertex> &vertices, const std::vector<unsigned int> &indices);
     void setupMesh() const;
+
+    /**
+     * returns the bounding volume hierarchy over the triangles of the mesh (in
+     * the mesh's own coordinates), building it the first time it is needed.
+     * reinitialize throws it away, so vertices and indices should not be
+     * changed directly once rays have been cast at the mesh.
+     */
+    std::shared_ptr<const TriangleBVH> getBVH() const;
+
+private:
+    // built by getBVH, and shared by copies of the mesh. It is only ever
+    // swapped atomically, so concurrent ray casts can build it without racing
+    mutable std::shared_ptr<const TriangleBVH> bvh;
 };
 
 namespace rendering {
@@ -51,12 +51,25 @@ protected:
     // loads a model with stl_reader from file and stores the resulting meshes in the meshes vector
     void loadStlModel(const std::string &path);
 
+    // transforms a ray from world coordinates to the coordinates the meshes
+    // are specified in
+    Ray getRayInModelCoordinates(const P3D &r_o, const V3D &r_v) const;
+
 public:
+    // ray casts go through the bounding volume hierarchies of the meshes (see
+    // Mesh::getBVH), which are built the first time a ray is cast
     bool hitByRay(const P3D &r_o, const V3D &r_v, P3D &hitPoint, double &t, V3D &n) const;
     bool hitByRay(const P3D &r_o, const V3D &r_v) const;
     bool hitByRay(const P3D &r_o, const V3D &r_v, double &t) const;
     bool hitByRay(const P3D &r_o, const V3D &r_v, P3D &hitPoint) const;
     bool hitByRay(const P3D &r_o, const V3D &r_v, P3D &hitPoint, V3D &hitNormal) const;
+
+    /**
+     * casts the n rays at once (e.g. from all feet), writing the ray
+     * parameters of their hits to t (infinity if a ray does not hit the
+     * model). Returns the number of rays that hit.
+     */
+    int hitByRays(const Ray *rays, double *t, int n) const;
 };
 
 }  // namespace gui
@@ -2,6 +2,7 @@
 
 #include "crl-basic/gui/guiMath.h"
 #include "crl-basic/gui/model.h"
+#include "crl-basic/utils/heightField.h"
 #include "crl-basic/utils/logger.h"
 
 namespace crl {
@@ -59,7 +60,9 @@ public:
 
 class SizeableGroundModel {
 public:
-    Model terrain = getGroundModel(size);
+    // the mesh that is drawn, and that getHeight samples. Call
+    // updateHeightField after changing it (e.g. moving or scaling it)
+    Model terrain;
     /*
     Model palm1 = Model(CRL_DATA_FOLDER "/meshes/Palm1.obj");
     Model palm2 = Model(CRL_DATA_FOLDER "/meshes/Palm2.obj");
@@ -80,11 +83,49 @@ public:
     void draw(const Shader &shader, const double &intensity = 1.0, const V3D &groundColor = V3D(0.95, 0.95, 0.95),
               const V3D &gridColor = V3D(0.78431, 0.78431, 0.78431));
 
-    double getHeight(double x, double z);
+    /**
+     * replaces the terrain with the mesh loaded from path (e.g. terrain.obj)
+     */
+    void loadTerrain(const std::string &path);
+
+    /**
+     * bakes the terrain into the height field that the height and normal
+     * queries read from
+     */
+    void updateHeightField();
+
+    /**
+     * returns the height of the terrain at (x, z), or 0 where there is none
+     */
+    double getHeight(double x, double z) const;
+
+    /**
+     * returns the normal of the terrain at (x, z)
+     */
+    V3D getNormal(double x, double z) const;
+
+    /**
+     * returns the heights of the terrain at the n points (x[k], z[k])
+     */
+    void getHeights(const double *x, const double *z, double *heights, int n) const;
+
+    /**
+     * the height field the terrain is baked into. updateHeightField rebakes it
+     * in place, which bumps its version, so whoever shares it (e.g. a planner,
+     * see SimpleLocomotionTrajectoryPlanner::setGround) plans on the new
+     * terrain from then on. It must not be rebaked while another thread reads
+     * it; such a thread should be handed a copy instead
+     */
+    std::shared_ptr<const HeightField> getHeightField() const {
+        return heightField;
+    }
 
 private:
     int size;
     Model ground;
+    // the top surface of the terrain, sampled on a regular grid so that height
+    // queries do not need to cast rays against every triangle
+    std::shared_ptr<HeightField> heightField = std::make_shared<HeightField>();
 
 public:
     double gridThickness = 0.025;
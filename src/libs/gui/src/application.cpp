@@ -58,8 +58,7 @@ Application::Application(const char *title, std::string iconPath) {
 }
 
 Application::~Application() {
-    if (useSeparateProcessThread)
-        processThread.std::thread::~thread();
+    scheduler.stop();
 }
 
 void Application::init(const char *title, int width, int height, std::string iconPath) {
@@ -165,7 +164,7 @@ void Application::setCallbacks() {
         if (key == GLFW_KEY_ESCAPE) {
             if (app->useSeparateProcessThread && app->processIsRunning) {
                 app->processIsRunning = false;
-                app->processThread.std::thread::~thread();
+                app->scheduler.stop();
             }
             glfwSetWindowShouldClose(window, GL_TRUE);
             return;
@@ -252,12 +251,15 @@ void Application::run() {
         }
         runningAverageStepCount++;
 
-        tmpEntireLoopTimeRunningAverage += FPSTimer.timeEllapsed();
+        double frameTime = FPSTimer.timeEllapsed();
+        tmpEntireLoopTimeRunningAverage += frameTime;
         FPSTimer.restart();
 
+        // the steps that are due by now
         processTimer.restart();
         if (!useSeparateProcessThread && processIsRunning)
-            process();
+            for (int nSteps = scheduler.advance(frameTime); nSteps > 0; nSteps--)
+                process();
         tmpProcessTimeRunningAverage += processTimer.timeEllapsed();
 
         draw();
@@ -287,6 +289,9 @@ void Application::run() {
         }
     }
 
+    // process must not run once the app is gone
+    scheduler.stop();
+
     // glfw: terminate, clearing all previously allocated GLFW resources.
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
@@ -298,20 +303,21 @@ void Application::run() {
 }
 
 void Application::baseProcess() {
-    while (processIsRunning)
-        process();
+    process();
 }
 
 void Application::processCallback() {
     if (useSeparateProcessThread) {
         if (processIsRunning) {
-            processThread = std::thread(&Application::baseProcess, this);
-            processThread.detach();
+            scheduler.start([this]() { baseProcess(); });
             Logger::print(Logger::DEFAULT, "Process thread started...\n");
         } else {
-            processThread.std::thread::~thread();
+            scheduler.stop();
             Logger::print(Logger::DEFAULT, "Process thread terminated...\n");
         }
+    } else if (processIsRunning) {
+        // pausing does not make up for the time spent paused
+        scheduler.reset();
     }
 }
 
@@ -87,9 +87,27 @@ void Mesh::reinitialize(const std::vector<Vertex> &vertices, const std::vector<u
         ctx->removeMeshRenderingBuffer(this);
     this->vertices = vertices;
     this->indices = indices;
+    std::atomic_store(&bvh, std::shared_ptr<const TriangleBVH>());
     setupMesh();
 }
 
+std::shared_ptr<const TriangleBVH> Mesh::getBVH() const {
+    auto result = std::atomic_load(&bvh);
+    if (result == nullptr) {
+        std::vector<P3D> points;
+        points.reserve(vertices.size());
+        for (const auto &v : vertices)
+            points.push_back(toP3D(v.position));
+        std::vector<int> triangles(indices.begin(), indices.end());
+
+        auto newBVH = std::make_shared<TriangleBVH>();
+        newBVH->build(points, triangles);
+        result = newBVH;
+        std::atomic_store(&bvh, result);
+    }
+    return result;
+}
+
 void Mesh::setupMesh() const {
     auto *ctx = rendering::GetCurrentMeshRenderingContext();
     auto &b = ctx->getMeshRenderingBuffer(this);
@@ -7,7 +7,6 @@
 #include <stl_reader.h>
 #include <tiny_obj_loader.h>
 
-#include <glm/gtx/intersect.hpp>
 #include <unordered_map>
 
 namespace std {
@@ -234,55 +233,64 @@ void Model::loadStlModel(const std::string &path) {
     }
 }
 
-bool Model::hitByRay(const P3D &r_o, const V3D &r_v, P3D &hitPoint, double &t, V3D &n) const {
-    using namespace glm;
+Ray Model::getRayInModelCoordinates(const P3D &r_o, const V3D &r_v) const {
+    // undo the translation and rotation, then the scale
+    Quaternion orientationInv = orientation.inverse();
+    V3D origin = orientationInv * V3D(position, r_o);
+    V3D dir = orientationInv * r_v;
+    for (int idx = 0; idx < 3; idx++) {
+        origin[idx] /= scale[idx];
+        dir[idx] /= scale[idx];
+    }
+    return Ray(P3D() + origin, dir);
+}
 
-    glm::vec3 orig = toGLM(r_o);
-    glm::vec3 dir = toGLM(r_v);
+bool Model::hitByRay(const P3D &r_o, const V3D &r_v, P3D &hitPoint, double &t, V3D &n) const {
+    Ray ray = getRayInModelCoordinates(r_o, r_v);
+
+    TriangleBVH::Hit hit;
+    const Mesh *hitMesh = nullptr;
+    for (const auto &m : meshes)
+        if (m.getBVH()->intersect(ray, hit))
+            hitMesh = &m;
+
+    t = hit.t;
+    if (hitMesh == nullptr)
+        return false;
+
+    V3D v[3];
+    for (int k = 0; k < 3; k++) {
+        v[k] = toV3D(hitMesh->vertices[hitMesh->indices[3 * hit.triangle + k]].position);
+        // handle the scaling here, otherwise the normal is a bit messed up...
+        for (int idx = 0; idx < 3; idx++)
+            v[k][idx] *= scale[idx];
+    }
 
-    auto modelInv = glm::inverse(getTransform());
-    vec4 origModelTmp = modelInv * vec4(orig, 1);
-    vec3 origModel = vec3(origModelTmp / origModelTmp.w);
-    vec3 dirModel = vec3(modelInv * vec4(dir, 0));
+    // the point is in local coordinates, so switch it over to world coords...
+    hitPoint = position + V3D(orientation * V3D(v[0] * (1 - hit.u - hit.v) + v[1] * hit.u + v[2] * hit.v));
+    n = orientation * V3D(v[1] - v[0]).cross(V3D(v[2] - v[0])).normalized();
+    return true;
+}
 
-    bool hit = false;
-    t = HUGE_VALF;
-    vec2 bary;
+int Model::hitByRays(const Ray *rays, double *t, int n) const {
+    std::vector<Ray> modelRays(n);
+    std::vector<TriangleBVH::Hit> hits(n);
+    for (int i = 0; i < n; i++)
+        modelRays[i] = getRayInModelCoordinates(rays[i].origin, rays[i].dir);
 
     for (const auto &m : meshes) {
-        for (unsigned int i = 0; i < m.indices.size() / 3; ++i) {
-            vec3 v0 = m.vertices[m.indices[3 * i + 0]].position;
-            vec3 v1 = m.vertices[m.indices[3 * i + 1]].position;
-            vec3 v2 = m.vertices[m.indices[3 * i + 2]].position;
-
-            float t_ = 0;
-            bool tHit = glm::intersectRayTriangle(origModel, dirModel, v0, v1, v2, bary, t_);
-
-            if (tHit && t_ > 1e-8 && t_ < t) {
-                hit = true;
-                t = t_;
-
-                // handle the scaling here, otherwise the normal is a bit messed
-                // up...
-                for (int idx = 0; idx < 3; idx++) {
-                    v0[idx] *= scale[idx];
-                    v1[idx] *= scale[idx];
-                    v2[idx] *= scale[idx];
-                }
-
-                hitPoint = toP3D(v0 * (1 - bary.x - bary.y) + v1 * bary.x + v2 * bary.y);
-                n = toV3D(v1 - v0).cross(toV3D(v2 - v0)).normalized();
-            }
-        }
+        auto bvh = m.getBVH();
+        for (int i = 0; i < n; i++)
+            bvh->intersect(modelRays[i], hits[i]);
     }
 
-    if (hit) {
-        // the point is now in local coordinates, so switch it over to world
-        // coords...
-        hitPoint = position + V3D(orientation * V3D(P3D(), hitPoint));
-        n = orientation * n;
+    int nHits = 0;
+    for (int i = 0; i < n; i++) {
+        t[i] = hits[i].t;
+        if (hits[i].triangle >= 0)
+            nHits++;
     }
-    return hit;
+    return nHits;
 }
 
 bool Model::hitByRay(const P3D &r_o, const V3D &r_v) const {
@@ -195,6 +195,8 @@ SizeableGroundModel::SizeableGroundModel(int size) {
 void SizeableGroundModel::setSize(int size) {
     this->size = size;
     ground = getGroundModel(size);
+    terrain = getGroundModel(size);
+    updateHeightField();
 }
 
 int SizeableGroundModel::getSize() const {
@@ -240,10 +242,38 @@ void SizeableGroundModel::draw(const Shader &shader, const double &intensity, co
     }
 }
 
-double SizeableGroundModel::getHeight(double x, double z) {
-    P3D hitPoint;
-    terrain.hitByRay(P3D(x,1000.0,z), V3D(0,-1.0,0), hitPoint);
-    return hitPoint[1];
+void SizeableGroundModel::loadTerrain(const std::string &path) {
+    terrain = Model(path);
+    updateHeightField();
+}
+
+void SizeableGroundModel::updateHeightField() {
+    // all meshes of the terrain, in world coordinates
+    std::vector<P3D> vertices;
+    std::vector<int> triangles;
+    for (const auto &mesh : terrain.meshes) {
+        int offset = (int)vertices.size();
+        for (const auto &vertex : mesh.vertices) {
+            V3D p = toV3D(vertex.position);
+            p = V3D(p[0] * terrain.scale[0], p[1] * terrain.scale[1], p[2] * terrain.scale[2]);
+            vertices.push_back(terrain.position + V3D(terrain.orientation * p));
+        }
+        for (unsigned int index : mesh.indices)
+            triangles.push_back(offset + (int)index);
+    }
+    heightField->bake(vertices, triangles);
+}
+
+double SizeableGroundModel::getHeight(double x, double z) const {
+    return heightField->getHeight(x, z);
+}
+
+V3D SizeableGroundModel::getNormal(double x, double z) const {
+    return heightField->getNormal(x, z);
+}
+
+void SizeableGroundModel::getHeights(const double *x, const double *z, double *heights, int n) const {
+    heightField->getHeights(x, z, heights, n);
 }
 
 namespace rendering {
@@ -2,6 +2,7 @@
 
 #include <loco/controller/LocomotionController.h>
 #include <loco/kinematics/IK_Solver.h>
+#include <loco/planner/AsynchronousPlanner.h>
 #include <loco/planner/LocomotionTrajectoryPlanner.h>
 #include <loco/robot/RB.h>
 #include <loco/robot/RBJoint.h>
@@ -17,6 +18,11 @@ public:
     std::shared_ptr<LeggedRobot> robot;
     std::shared_ptr<IK_Solver> ikSolver = nullptr;
 
+    // if set, plans are generated on the thread of asyncPlanner, and the latest
+    // one it published gets tracked. planner then only keeps the sim time and
+    // the high-level targets, and does not plan itself
+    std::shared_ptr<AsynchronousPlanner> asyncPlanner = nullptr;
+
 public:
     /**
      * constructor
@@ -32,39 +38,58 @@ public:
     ~KinematicTrackingController(void) override = default;
 
     void generateMotionTrajectories(double dt = 1.0 / 30.0) override {
+        if (asyncPlanner != nullptr) {
+            asyncPlanner->requestPlan(*robot, *planner, dt);
+            return;
+        }
         planner->planGenerationTime = planner->simTime;
         planner->generateTrajectoriesFromCurrentState(dt);
     }
 
     void computeAndApplyControlSignals(double dt) override {
+        if (asyncPlanner != nullptr)
+            track(asyncPlanner->getLatestPlan(), planner->getSimTime() + dt);
+        else
+            track(*planner, planner->getSimTime() + dt);
+    }
+
+    void advanceInTime(double dt) override {
+        planner->advanceInTime(dt);
+    }
+
+    // on the thread that tracks the plans: copies the plan being tracked,
+    // sampled every dt, e.g. to draw it on another thread
+    void samplePlan(LocomotionPlan &plan, double dt) const {
+        if (asyncPlanner != nullptr)
+            plan = asyncPlanner->getTrackedPlan();
+        else
+            plan.sample(*planner, dt);
+    }
+
+    void plotDebugInfo() override {
+        // add plot if you need...
+    }
+
+private:
+    // plan is either a LocomotionTrajectoryPlanner or a LocomotionPlan
+    template <typename Plan>
+    void track(Plan &plan, double t) {
         // set base pose. in this assignment, we just assume the base perfectly
         // follow target base trajectory.
-        P3D targetPos = planner->getTargetTrunkPositionAtTime(planner->getSimTime() + dt);
-        Quaternion targetOrientation = planner->getTargetTrunkOrientationAtTime(planner->getSimTime() + dt);
+        P3D targetPos = plan.getTargetTrunkPositionAtTime(t);
+        Quaternion targetOrientation = plan.getTargetTrunkOrientationAtTime(t);
 
         robot->setRootState(targetPos, targetOrientation);
 
         // now we solve inverse kinematics for each limbs
         for (uint i = 0; i < robot->getLimbCount(); i++) {
-            P3D target = planner->getTargetLimbEEPositionAtTime(robot->getLimb(i), planner->getSimTime() + dt);
+            P3D target = plan.getTargetLimbEEPositionAtTime(robot->getLimb(i), t);
 
             ikSolver->addEndEffectorTarget(robot->getLimb(i)->eeRB, robot->getLimb(i)->ee->endEffectorOffset, target);
         }
 
         ikSolver->solve();
     }
-
-    void advanceInTime(double dt) override {
-        planner->advanceInTime(dt);
-    }
-
-    void drawDebugInfo(gui::Shader *shader) override {
-        planner->drawTrajectories(shader);
-    }
-
-    void plotDebugInfo() override {
-        // add plot if you need...
-    }
 };
 
 }  // namespace crl::loco
\ No newline at end of file
@@ -1,6 +1,5 @@
 #pragma once
 
-#include <crl-basic/gui/renderer.h>
 #include <loco/planner/LocomotionTrajectoryPlanner.h>
 
 namespace crl::loco {
@@ -34,19 +33,6 @@ public:
      */
     virtual void advanceInTime(double dt) = 0;
 
-    /**
-     * Draw control options to ImGui.
-     */
-    virtual void drawControllerOptions() {
-        ImGui::Text("No option available");
-    };
-
-    /**
-     * Draw some useful information for debugging.
-     * e.g. contact, velocity, acceleration etc.
-     */
-    virtual void drawDebugInfo(gui::Shader* shader) = 0;
-
     /**
      * Plot some useful information for debugging.
      * e.g. joint torque etc.
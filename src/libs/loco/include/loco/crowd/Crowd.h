@@ -0,0 +1,111 @@
+#pragma once
+
+#include <crl-basic/utils/threadPool.h>
+#include <loco/controller/KinematicTrackingController.h>
+#include <loco/planner/GaitPlanner.h>
+#include <loco/planner/SimpleLocomotionTrajectoryPlanner.h>
+
+namespace crl::loco {
+
+/**
+ * A character of a crowd: a robot, and the planners and the controller that
+ * make it walk. Characters share no mutable state, and every one has targets
+ * of its own (e.g. planner->speedForward).
+ */
+struct CrowdCharacter {
+    std::shared_ptr<LeggedRobot> robot;
+    // gait planners are stateless, so characters can share one
+    std::shared_ptr<const GaitPlanner> gaitPlanner;
+    std::shared_ptr<SimpleLocomotionTrajectoryPlanner> planner;
+    std::shared_ptr<KinematicTrackingController> controller;
+};
+
+/**
+ * Walks many independent characters (e.g. the background characters of a
+ * scene), stepping all of them at a fixed time step in parallel on a thread
+ * pool. Every character is stepped on one thread, in the same way as the
+ * locomotion app steps its robot, so the motion of a character does not
+ * depend on the number of threads or on the other characters.
+ */
+class Crowd {
+public:
+    // the characters replan every stepsPerPlan steps. Replanning is staggered
+    // over the characters, so that all steps take about as long
+    int stepsPerPlan = 1;
+
+    // the gait parameters of the characters added from now on (they can
+    // still be changed per character, through its planner)
+    std::shared_ptr<const GaitParameters> gaitParameters = std::make_shared<GaitParameters>();
+
+public:
+    /**
+     * steps the crowd on nThreads threads (one per core if not positive)
+     */
+    explicit Crowd(int nThreads = -1) : threadPool(nThreads) {}
+
+    /**
+     * adds a character that walks the robot, from where the robot is, at the
+     * given speed. The robot must have its limbs already. The character stays
+     * valid until the next one is added.
+     */
+    CrowdCharacter &addCharacter(const std::shared_ptr<LeggedRobot> &robot, const std::shared_ptr<const GaitPlanner> &gaitPlanner, double trunkHeight,
+                                 double stepHeight, double speedForward) {
+        CrowdCharacter c;
+        c.robot = robot;
+        c.gaitPlanner = gaitPlanner;
+        c.planner = std::make_shared<SimpleLocomotionTrajectoryPlanner>(robot);
+        c.planner->trunkHeight = trunkHeight;
+        c.planner->targetStepHeight = stepHeight;
+        c.planner->speedForward = speedForward;
+        c.planner->gaitParameters = gaitParameters;
+        c.controller = std::make_shared<KinematicTrackingController>(c.planner);
+        plan(c);
+        characters.push_back(c);
+        return characters.back();
+    }
+
+    int getCharacterCount() const {
+        return (int)characters.size();
+    }
+
+    CrowdCharacter &getCharacter(int i) {
+        return characters[i];
+    }
+
+    /**
+     * advances all characters by dt, replanning for the ones whose turn it is
+     */
+    void step(double dt) {
+        stepCount++;
+        threadPool.parallelFor(getCharacterCount(), [this, dt](int i) {
+            CrowdCharacter &c = characters[i];
+            c.controller->computeAndApplyControlSignals(dt);
+            c.controller->advanceInTime(dt);
+            if ((stepCount + i) % stepsPerPlan == 0)
+                plan(c);
+        });
+    }
+
+    /**
+     * the number of steps taken so far
+     */
+    int getStepCount() const {
+        return stepCount;
+    }
+
+    int getThreadCount() const {
+        return threadPool.getThreadCount();
+    }
+
+private:
+    static void plan(CrowdCharacter &c) {
+        c.planner->appendPeriodicGaitIfNeeded(*c.gaitPlanner);
+        c.controller->generateMotionTrajectories();
+    }
+
+    DynamicArray<CrowdCharacter> characters;
+    int stepCount = 0;
+    ThreadPool threadPool;
+};
+
+}  // namespace crl::loco
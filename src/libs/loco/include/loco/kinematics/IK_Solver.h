@@ -1,9 +1,13 @@
 #pragma once
+#include <algorithm>
 #include <iostream>
 #include <loco/robot/GeneralizedCoordinatesRobotRepresentation.h>
 #include <loco/robot/Robot.h>
 #include <string>
 
+#include <crl-basic/utils/logger.h>
+#include <crl-basic/utils/timer.h>
+
 namespace crl::loco {
 
 struct IK_EndEffectorTargets {
@@ -21,6 +25,88 @@ enum class IK_UpdateRule {
 /* An enum class to specify the method we use to enforce joint limits. */
 enum class IK_JointConstraintMethod { NONE, CLAMP, PROJECT };
 
+/* An enum class to specify how the end effector jacobians dp/dq are computed */
+enum class IK_JacobianMode {
+    ANALYTIC,           // gcrr.compute_dpdq: one chain walk per target
+    FINITE_DIFFERENCE,  // gcrr.estimate_linear_jacobian: 2 * |q| chain walks per target
+    VALIDATED           // analytic, cross-checked against finite differences in debug builds
+};
+
+/* An enum class to specify how multiple end effector targets are combined */
+enum class IK_TargetMode {
+    SEQUENTIAL,  // one update of q per target, applied in turn
+    STACKED,     // all targets stacked into one system, one update of q per iteration
+    DECOMPOSED   // same update as STACKED, but solved per group of targets whose kinematic chains share joints
+};
+
+/**
+ * Preallocated buffers for one damped least squares problem
+ *   dq = argmin |J dq - r|^2 + damping * |dq|^2
+ * Once sized, solving it again does not allocate.
+ */
+struct IK_LinearSystem {
+    Matrix J;   // jacobian of the residuals w.r.t. the dofs being solved for
+    dVector r;  // residuals, pee_{target} - FK(q)
+    Matrix A;   // J J^T or J^T J, plus damping
+    dVector x;  // solution of the dual system
+    dVector dq;
+    Eigen::LDLT<Matrix> ldlt;
+
+    void resize(int nRows, int nDofs) {
+        if (J.rows() != nRows || J.cols() != nDofs)
+            J.resize(nRows, nDofs);
+        if (r.size() != nRows)
+            r.resize(nRows);
+    }
+
+    /**
+     * When J has fewer rows than columns we solve the dual system
+     *   dq = J^T (J J^T + damping * I)^{-1} r
+     * instead of the primal (J^T J + damping * I)^{-1} J^T r.
+     */
+    void solve(double damping) {
+        if (J.rows() < J.cols()) {
+            A.noalias() = J * J.transpose();
+            A.diagonal().array() += damping;
+            ldlt.compute(A);
+            x = r;
+            ldlt.solveInPlace(x);
+            dq.noalias() = J.transpose() * x;
+        } else {
+            A.noalias() = J.transpose() * J;
+            A.diagonal().array() += damping;
+            ldlt.compute(A);
+            dq.noalias() = J.transpose() * r;
+            ldlt.solveInPlace(dq);
+        }
+    }
+};
+
+/* A set of end effector targets whose kinematic chains share joints, and the dofs they depend on */
+struct IK_TargetGroup {
+    std::vector<int> targets;   // indices into the end effector target list
+    std::vector<int> qIndices;  // sorted joint dofs (>= 6) that move at least one of the targets
+    IK_LinearSystem system;     // workspace for the group's update
+};
+
+/* Statistics of the last call to IK_Solver::solve */
+struct IK_SolveStats {
+    int iterations = 0;           // number of update steps taken (including rejected ones)
+    int rejectedSteps = 0;        // LM steps that did not reduce the residual and were undone
+    double initialResidual = 0;   // |pee_{target} - FK(q)| over all targets, before the first step
+    double finalResidual = 0;     // same, after the last step
+    double lambda = 0;            // damping factor at the end of the solve
+    double solveTime = 0;         // wall clock time of the solve, in seconds
+    bool converged = false;       // true if the residual dropped below the residual tolerance
+};
+
+/**
+ * Damped least squares IK for the end effectors of a robot. The solver is bound
+ * to its robot and keeps all of its buffers (including the generalized
+ * coordinates representation) across solves, so that once the set of targeted
+ * rigid bodies stops changing, solving with analytic jacobians does not
+ * allocate any memory.
+ */
 class IK_Solver {
 public:
     /**
@@ -31,10 +117,19 @@ public:
      * @param updateRule which update rule to use
      * @param alpha step size of the IK solver
      * @param lambda damping factor for the Levenberg-Marquardt update rule
+     * @param jacobianMode how the end effector jacobians are computed
      */
     IK_Solver(const std::shared_ptr<Robot> &robot, IK_UpdateRule updateRule = IK_UpdateRule::LEVENBERG_MARQUARDT,
-              IK_JointConstraintMethod constraintMethod = IK_JointConstraintMethod::CLAMP, double alpha = 1.0, double lambda = 0.1)
-        : robot(robot), constraintMethod(constraintMethod), updateRule(updateRule), alpha(alpha), lambda(lambda) {}
+              IK_JointConstraintMethod constraintMethod = IK_JointConstraintMethod::CLAMP, double alpha = 1.0, double lambda = 0.1,
+              IK_JacobianMode jacobianMode = IK_JacobianMode::ANALYTIC)
+        : robot(robot),
+          gcrr(robot),
+          constraintMethod(constraintMethod),
+          updateRule(updateRule),
+          jacobianMode(jacobianMode),
+          alpha(alpha),
+          lambda(lambda),
+          currentLambda(lambda) {}
 
     ~IK_Solver(void) {}
 
@@ -43,96 +138,430 @@ public:
      * is specified in the local coordinates of rb and its target expressed in world frame.
      */
     void addEndEffectorTarget(const std::shared_ptr<RB> &rb, P3D p, P3D target) {
-        endEffectorTargets.push_back(IK_EndEffectorTargets());
+        // the target list keeps its capacity when it is cleared after a solve
+        endEffectorTargets.emplace_back();
         endEffectorTargets.back().rb = rb;
         endEffectorTargets.back().p = p;
         endEffectorTargets.back().target = target;
     }
 
+    void setJacobianMode(IK_JacobianMode mode) {
+        jacobianMode = mode;
+    }
+
+    IK_JacobianMode getJacobianMode() const {
+        return jacobianMode;
+    }
+
+    void setTargetMode(IK_TargetMode mode) {
+        targetMode = mode;
+    }
+
+    IK_TargetMode getTargetMode() const {
+        return targetMode;
+    }
+
+    /**
+     * stop iterating once the residual |pee_{target} - FK(q)| over all targets
+     * drops below residualTolerance, or once an update moves q by less than
+     * stepTolerance (e.g. unreachable targets or targets blocked by joint limits).
+     */
+    void setTolerances(double residualTolerance, double stepTolerance) {
+        this->residualTolerance = residualTolerance;
+        this->stepTolerance = stepTolerance;
+    }
+
+    /**
+     * with adaptive damping, LEVENBERG_MARQUARDT steps that increase the residual
+     * are undone and lambda is increased; accepted steps decrease lambda. The
+     * damping is carried over from one solve to the next.
+     */
+    void setAdaptiveDamping(bool adaptive) {
+        adaptiveDamping = adaptive;
+        currentLambda = lambda;
+    }
+
+    bool getAdaptiveDamping() const {
+        return adaptiveDamping;
+    }
+
+    /**
+     * with warm starting, each solve starts from the joint angles found by the
+     * previous solve rather than from the robot's current state (which loses
+     * precision going through the joint quaternions). Call resetWarmStart()
+     * if the robot's joint angles are changed by anything other than this solver.
+     */
+    void setWarmStart(bool warmStart) {
+        this->warmStart = warmStart;
+        resetWarmStart();
+    }
+
+    void resetWarmStart() {
+        hasLastSolution = false;
+        currentLambda = lambda;
+    }
+
+    const IK_SolveStats &getLastSolveStats() const {
+        return stats;
+    }
+
     void solve(int nSteps = 10) {
-        GeneralizedCoordinatesRobotRepresentation gcrr(robot);
+        Timer timer;
+        stats = IK_SolveStats();
+
+        gcrr.syncGeneralizedCoordinatesWithRobotState();
 
-        for (uint i = 0; i < nSteps; i++) {
-            dVector q;
+        if (warmStart && hasLastSolution) {
+            // the base pose comes from the robot, the joint angles (still in q) from the last solve
+            for (int i = 0; i < 6; i++)
+                q[i] = gcrr.getQVal(i);
+            gcrr.setQ(q);
+        } else {
+            // get current generalized coordinates of the robots
             gcrr.getQ(q);
+        }
 
+        if (!adaptiveDamping)
+            currentLambda = lambda;
 
-            // get current generalized coordinates of the robots
+        double residual = computeResidual();
+        stats.initialResidual = residual;
 
-            // TODO: Inverse Kinematics
-            //
-            // update generalized coordinates of the robot by solving IK.
+        while (stats.iterations < nSteps) {
+            if (residual < residualTolerance) {
+                stats.converged = true;
+                break;
+            }
+            qPrev = q;
+            stats.iterations++;
 
             // remember, we don't update base pose since we assume it's already at
             // the target position and orientation
+            if (targetMode == IK_TargetMode::SEQUENTIAL)
+                sequentialStep(q);
+            else if (targetMode == IK_TargetMode::STACKED)
+                stackedStep(q);
+            else if (targetMode == IK_TargetMode::DECOMPOSED)
+                decomposedStep(q);
+            else
+                throw std::invalid_argument("TargetMode not implemented");
 
-            // TODO: here, compute deltaq using Gauss-Newton.
-            // end effector targets are stored in endEffectorTargets vector.
-            //
-            // Hint:
-            // - use gcrr.estimate_linear_jacobian(p, rb, dpdq) function for Jacobian matrix.
-            // - don't forget we use only last q.size() - 6 columns (use block(0,6,3,q.size() - 6) function)
-            // - when you compute inverse of the matrix, use ldlt().solve() instead of inverse() function. this is numerically more stable.
-            //   see https://eigen.tuxfamily.org/dox-devel/group__LeastSquares.html
-
-            // TODO: your implementation should be here.
-            Matrix Jq, Jq_block;
-            Matrix I = Matrix::Identity(q.size() - 6, q.size() - 6);
-            for (size_t j = 0; j < endEffectorTargets.size(); j++) {
-                // J(q)
-                gcrr.estimate_linear_jacobian(endEffectorTargets[j].p, endEffectorTargets[j].rb, Jq);
-
-                // FK(q)
-                P3D FKq = gcrr.getWorldCoordinates(endEffectorTargets[j].p, endEffectorTargets[j].rb);
-
-                // pee_target - FK(q)
-                V3D difference = V3D(endEffectorTargets[j].target - FKq);
-
-                // get relevant submatrix of dpdq
-                Jq_block = Jq.block(0, 6, 3, q.size() - 6);
-
-                // Update q (TODO: remove control flow once we settle on a final method to improve performance)
-                if (updateRule == IK_UpdateRule::GAUSS_NEWTON) {
-                    q.tail(q.size() - 6) += alpha * (Jq_block.transpose() * Jq_block).ldlt().solve(Jq_block.transpose() * difference).eval();
-                } else if (updateRule == IK_UpdateRule::LEVENBERG_MARQUARDT) {
-                    q.tail(q.size() - 6) += alpha * (Jq_block.transpose() * Jq_block + lambda * I).ldlt().solve(Jq_block.transpose() * difference).eval();
-                } else {
-                    throw std::invalid_argument("UpdateRule not implemented");
-                }
+            // now update gcrr with q
+            gcrr.setQ(q);
+            double newResidual = computeResidual();
 
-                // Enforce joint angle constraints
-                if (constraintMethod == IK_JointConstraintMethod::NONE) {
-                    // do nothing
+            if (adaptiveDamping && updateRule == IK_UpdateRule::LEVENBERG_MARQUARDT) {
+                if (newResidual >= residual) {
+                    // reject the step and retry with more damping
+                    q = qPrev;
+                    gcrr.setQ(q);
+                    stats.rejectedSteps++;
+                    currentLambda = std::min(currentLambda * lambdaIncrease, maxLambda);
+                    if (currentLambda >= maxLambda)
+                        break;
                     continue;
-                } else if (constraintMethod == IK_JointConstraintMethod::CLAMP) {
-                    for (int k = 0; k < q.size() - 6; k++) {
-                        double minJointAngle = robot->getJoint(k)->minAngle;
-                        double maxJointAngle = robot->getJoint(k)->maxAngle;
-                        q[k + 6] = std::clamp(q[k + 6], minJointAngle, maxJointAngle);
-                    }
-                } else {
-                    throw std::invalid_argument("JointConstraintMethod not implemented");
                 }
+                currentLambda = std::max(currentLambda * lambdaDecrease, minLambda);
             }
+            residual = newResidual;
 
-            // now update gcrr with q
-            gcrr.setQ(q);
+            if ((q - qPrev).norm() < stepTolerance)
+                break;
         }
+        if (residual < residualTolerance)
+            stats.converged = true;
 
         gcrr.syncRobotStateWithGeneralizedCoordinates();
+        hasLastSolution = true;
 
         // clear end effector targets
         // we will add targets in the next step again.
         endEffectorTargets.clear();
+
+        stats.finalResidual = residual;
+        stats.lambda = currentLambda;
+        stats.solveTime = timer.timeEllapsed();
+    }
+
+private:
+    /**
+     * |pee_{target} - FK(q)| over all end effector targets
+     */
+    double computeResidual() const {
+        double sqResidual = 0;
+        for (const auto &eeTarget : endEffectorTargets)
+            sqResidual += V3D(gcrr.getWorldCoordinates(eeTarget.p, eeTarget.rb), eeTarget.target).squaredNorm();
+        return std::sqrt(sqResidual);
+    }
+
+    /**
+     * one damped least squares step per end effector target. Each target
+     * updates q on its own, so limbs that share joints (e.g. the spine) pull
+     * on them in turn.
+     */
+    void sequentialStep(dVector &q) {
+        int nDofs = (int)q.size() - 6;
+        double damping = getDamping();
+        IK_LinearSystem &system = linearSystem;
+        system.resize(3, nDofs);
+        for (size_t j = 0; j < endEffectorTargets.size(); j++) {
+            // J(q)
+            computeJacobian(endEffectorTargets[j].p, endEffectorTargets[j].rb, Jq);
+
+            // FK(q)
+            P3D FKq = gcrr.getWorldCoordinates(endEffectorTargets[j].p, endEffectorTargets[j].rb);
+
+            // pee_target - FK(q)
+            system.r = V3D(FKq, endEffectorTargets[j].target);
+
+            // get relevant submatrix of dpdq
+            system.J = Jq.rightCols(nDofs);
+
+            // update q
+            system.solve(damping);
+            q.tail(nDofs) += alpha * system.dq;
+
+            enforceJointLimits(q);
+        }
+    }
+
+    /**
+     * one damped least squares step for all end effector targets at once: the
+     * 3k x (|q|-6) jacobians and residuals are stacked, so there is a single
+     * factorization per iteration and shared joints get a compromise update.
+     */
+    void stackedStep(dVector &q) {
+        int nTargets = (int)endEffectorTargets.size();
+        int nDofs = (int)q.size() - 6;
+        if (nTargets == 0 || nDofs <= 0)
+            return;
+
+        computeJacobians();
+
+        IK_LinearSystem &system = linearSystem;
+        system.resize(3 * nTargets, nDofs);
+        system.J = Jall.rightCols(nDofs);
+        for (int j = 0; j < nTargets; j++) {
+            P3D FKq = gcrr.getWorldCoordinates(endEffectorTargets[j].p, endEffectorTargets[j].rb);
+            system.r.segment<3>(3 * j) = V3D(FKq, endEffectorTargets[j].target);
+        }
+
+        system.solve(getDamping());
+        q.tail(nDofs) += alpha * system.dq;
+
+        enforceJointLimits(q);
+    }
+
+    /**
+     * same update as stackedStep, but exploiting the structure of the stacked
+     * jacobian: a target only depends on the dofs along its chain to the root,
+     * so J is block diagonal over groups of targets that share no joints (e.g.
+     * one group per leg, and one for the arms and head coupled via the spine).
+     * Each group is solved as a small dense problem over its own dofs only.
+     */
+    void decomposedStep(dVector &q) {
+        updateTargetGroups();
+        computeJacobians();
+
+        double damping = getDamping();
+        for (auto &group : targetGroups) {
+            int nTargets = (int)group.targets.size();
+            int nDofs = (int)group.qIndices.size();
+            // e.g. an end effector on the root: nothing we can move
+            if (nDofs == 0)
+                continue;
+
+            IK_LinearSystem &system = group.system;
+            system.resize(3 * nTargets, nDofs);
+            for (int j = 0; j < nTargets; j++) {
+                const auto &eeTarget = endEffectorTargets[group.targets[j]];
+                for (int k = 0; k < nDofs; k++)
+                    system.J.block<3, 1>(3 * j, k) = Jall.block<3, 1>(3 * group.targets[j], group.qIndices[k]);
+
+                P3D FKq = gcrr.getWorldCoordinates(eeTarget.p, eeTarget.rb);
+                system.r.segment<3>(3 * j) = V3D(FKq, eeTarget.target);
+            }
+
+            system.solve(damping);
+            for (int k = 0; k < nDofs; k++)
+                q[group.qIndices[k]] += alpha * system.dq[k];
+        }
+
+        enforceJointLimits(q);
+    }
+
+    double getDamping() const {
+        if (updateRule == IK_UpdateRule::LEVENBERG_MARQUARDT)
+            return currentLambda;
+        if (updateRule != IK_UpdateRule::GAUSS_NEWTON)
+            throw std::invalid_argument("UpdateRule not implemented");
+        return 0;
+    }
+
+    /**
+     * (re)builds targetGroups from the kinematic chains of the current end
+     * effector targets. The grouping only depends on which rigid bodies are
+     * targeted, so it is reused as long as those do not change.
+     */
+    void updateTargetGroups() {
+        bool upToDate = groupedRBs.size() == endEffectorTargets.size();
+        for (size_t j = 0; upToDate && j < endEffectorTargets.size(); j++)
+            upToDate = groupedRBs[j] == endEffectorTargets[j].rb;
+        if (upToDate)
+            return;
+
+        groupedRBs.clear();
+        targetGroups.clear();
+
+        // for every dof, the group that already depends on it
+        std::vector<int> qOwner(gcrr.getDimensionSize(), -1);
+        for (int j = 0; j < (int)endEffectorTargets.size(); j++) {
+            groupedRBs.push_back(endEffectorTargets[j].rb);
+
+            // the joint dofs between the end effector and the root; 5 is the
+            // last dof of the root, which IK does not update
+            std::vector<int> chain;
+            for (int qIndex = gcrr.getQStartIndexForRB(endEffectorTargets[j].rb); qIndex > 5; qIndex = gcrr.getParentQIndex(qIndex))
+                chain.push_back(qIndex);
+
+            // find the group this target joins, merging groups it couples
+            int g = -1;
+            for (int qIndex : chain) {
+                int other = qOwner[qIndex];
+                if (other == -1 || other == g)
+                    continue;
+                if (g == -1) {
+                    g = other;
+                    continue;
+                }
+                for (int t : targetGroups[other].targets)
+                    targetGroups[g].targets.push_back(t);
+                for (int qi : targetGroups[other].qIndices) {
+                    targetGroups[g].qIndices.push_back(qi);
+                    qOwner[qi] = g;
+                }
+                targetGroups[other].targets.clear();
+                targetGroups[other].qIndices.clear();
+            }
+            if (g == -1) {
+                g = (int)targetGroups.size();
+                targetGroups.push_back(IK_TargetGroup());
+            }
+
+            targetGroups[g].targets.push_back(j);
+            for (int qIndex : chain) {
+                if (qOwner[qIndex] == -1) {
+                    qOwner[qIndex] = g;
+                    targetGroups[g].qIndices.push_back(qIndex);
+                }
+            }
+        }
+
+        // drop the groups that were merged into others
+        targetGroups.erase(std::remove_if(targetGroups.begin(), targetGroups.end(), [](const IK_TargetGroup &g) { return g.targets.empty(); }),
+                           targetGroups.end());
+        for (auto &group : targetGroups) {
+            std::sort(group.targets.begin(), group.targets.end());
+            std::sort(group.qIndices.begin(), group.qIndices.end());
+        }
+    }
+
+    void enforceJointLimits(dVector &q) const {
+        if (constraintMethod == IK_JointConstraintMethod::NONE) {
+            // do nothing
+            return;
+        } else if (constraintMethod == IK_JointConstraintMethod::CLAMP) {
+            for (int k = 0; k < q.size() - 6; k++) {
+                double minJointAngle = robot->getJoint(k)->minAngle;
+                double maxJointAngle = robot->getJoint(k)->maxAngle;
+                q[k + 6] = std::clamp(q[k + 6], minJointAngle, maxJointAngle);
+            }
+        } else {
+            throw std::invalid_argument("JointConstraintMethod not implemented");
+        }
+    }
+
+    /**
+     * stacks dp/dq for all end effector targets into Jall, in the order of the
+     * targets. Analytic jacobians are computed in one batch.
+     */
+    void computeJacobians() {
+        if (jacobianMode == IK_JacobianMode::ANALYTIC) {
+            eeRBs.clear();
+            eePoints.clear();
+            for (const auto &eeTarget : endEffectorTargets) {
+                eeRBs.push_back(eeTarget.rb);
+                eePoints.push_back(eeTarget.p);
+            }
+            gcrr.compute_dpdq(eeRBs, eePoints, Jall);
+            return;
+        }
+
+        Jall.resize(3 * endEffectorTargets.size(), gcrr.getDimensionSize());
+        for (size_t j = 0; j < endEffectorTargets.size(); j++) {
+            computeJacobian(endEffectorTargets[j].p, endEffectorTargets[j].rb, Jq);
+            Jall.middleRows<3>(3 * j) = Jq;
+        }
+    }
+
+    /**
+     * computes dp/dq for point p (local coordinates of rb) according to the
+     * selected jacobian mode. Only the analytic jacobian is allocation free.
+     */
+    void computeJacobian(const P3D &p, const std::shared_ptr<RB> &rb, Matrix &dpdq) {
+        switch (jacobianMode) {
+            case IK_JacobianMode::ANALYTIC:
+                gcrr.compute_dpdq(p, rb, dpdq);
+                break;
+            case IK_JacobianMode::FINITE_DIFFERENCE:
+                gcrr.estimate_linear_jacobian(p, rb, dpdq);
+                break;
+            case IK_JacobianMode::VALIDATED:
+#ifndef NDEBUG
+                // test_linear_jacobian reports every mismatching entry
+                if (!gcrr.test_linear_jacobian(p, rb))
+                    Logger::consolePrint("IK_Solver: analytic jacobian does not match FD for %s\n", rb->name.c_str());
+#endif
+                gcrr.compute_dpdq(p, rb, dpdq);
+                break;
+            default:
+                throw std::invalid_argument("JacobianMode not implemented");
+        }
     }
 
 private:
     std::shared_ptr<Robot> robot;
+    GeneralizedCoordinatesRobotRepresentation gcrr;
     std::vector<IK_EndEffectorTargets> endEffectorTargets;
     IK_JointConstraintMethod constraintMethod;
     IK_UpdateRule updateRule;
+    IK_JacobianMode jacobianMode;
+    IK_TargetMode targetMode = IK_TargetMode::DECOMPOSED;
+    // cached decomposition of the targets into independent groups
+    std::vector<std::shared_ptr<RB>> groupedRBs;
+    std::vector<IK_TargetGroup> targetGroups;
     double alpha;
     double lambda;
+    // convergence criteria
+    double residualTolerance = 1e-4;
+    double stepTolerance = 1e-6;
+    // adaptive damping for LEVENBERG_MARQUARDT, starting from lambda
+    bool adaptiveDamping = true;
+    double currentLambda;
+    double lambdaIncrease = 10.0;
+    double lambdaDecrease = 0.5;
+    double minLambda = 1e-4;
+    double maxLambda = 1e4;
+    // warm start
+    bool warmStart = true;
+    bool hasLastSolution = false;
+    IK_SolveStats stats;
+    // workspace, reused across iterations and solves
+    dVector q, qPrev;
+    Matrix Jq, Jall;
+    std::vector<std::shared_ptr<const RB>> eeRBs;
+    std::vector<P3D> eePoints;
+    IK_LinearSystem linearSystem;
 };
 
 }  // namespace crl::loco
\ No newline at end of file
@@ -0,0 +1,192 @@
+#pragma once
+
+#include <crl-basic/utils/tripleBuffer.h>
+#include <loco/planner/GaitPlanner.h>
+#include <loco/planner/LocomotionPlan.h>
+#include <loco/planner/LocomotionTrajectoryPlanner.h>
+
+#include <atomic>
+#include <chrono>
+#include <thread>
+
+namespace crl::loco {
+
+/**
+ * Runs a LocomotionTrajectoryPlanner on a thread of its own, at a fixed rate,
+ * so that tracking the plan never waits for planning. Plan requests (the state
+ * of the robot, the sim time and the high-level targets) and the resulting
+ * plans are handed over through lock-free triple buffers: requestPlan and
+ * getLatestPlan return right away, and plans that are not picked up in time
+ * are skipped.
+ *
+ * Once the thread runs, it owns the planner and its robot, which must not be
+ * the robot that gets controlled. It also appends the periodic gait to the
+ * planner's contact schedule, as needed.
+ */
+class AsynchronousPlanner {
+public:
+    AsynchronousPlanner(const std::shared_ptr<LocomotionTrajectoryPlanner>& planner, const std::shared_ptr<const GaitPlanner>& gaitPlanner,
+                        double planningRate = 30)
+        : planner(planner), gaitPlanner(gaitPlanner), planningRate(planningRate) {}
+
+    ~AsynchronousPlanner() {
+        stopping = true;
+        if (plannerThread.joinable())
+            plannerThread.join();
+    }
+
+    AsynchronousPlanner(const AsynchronousPlanner&) = delete;
+    AsynchronousPlanner& operator=(const AsynchronousPlanner&) = delete;
+
+    /**
+     * asks for a plan that starts from the current state of the robot, at the
+     * sim time of targets, and has its high-level targets. Only one thread
+     * may call this. The first request is planned right away, on the calling
+     * thread, before the planner thread starts; later ones are planned on the
+     * planner thread.
+     */
+    void requestPlan(const Robot& robot, const LocomotionTrajectoryPlanner& targets, double dt = 1 / 30.0) {
+        Request& request = requests.getBackBuffer();
+        robot.populateState(request.robotState);
+        request.simTime = targets.simTime;
+        request.dt = dt;
+        request.trunkHeight = targets.trunkHeight;
+        request.trunkPitch = targets.trunkPitch;
+        request.trunkRoll = targets.trunkRoll;
+        request.trunkYaw = targets.trunkYaw;
+        request.speedForward = targets.speedForward;
+        request.speedSideways = targets.speedSideways;
+        request.turningSpeed = targets.turningSpeed;
+        request.stepWidthModifier = targets.stepWidthModifier;
+        request.targetStepHeight = targets.targetStepHeight;
+
+        // so that there is a plan to track from the start
+        if (!plannerThread.joinable()) {
+            plan(request);
+            plannerThread = std::thread(&AsynchronousPlanner::plannerLoop, this);
+            return;
+        }
+
+        requests.publish();
+    }
+
+    /**
+     * the latest plan that was published. Only one thread (the one that
+     * tracks the plans) may call this, and the plan stays valid until its
+     * next call.
+     */
+    const LocomotionPlan& getLatestPlan() {
+        plans.update();
+        return plans.getFrontBuffer();
+    }
+
+    /**
+     * the plan the last call to getLatestPlan returned, without picking up a
+     * newer one. Only the thread that calls getLatestPlan may call this.
+     */
+    const LocomotionPlan& getTrackedPlan() const {
+        return plans.getFrontBuffer();
+    }
+
+    /**
+     * the version and the generation time of the latest plan that was
+     * published. Any thread may call these (e.g. to show them in a UI), but
+     * the two may belong to consecutive plans.
+     */
+    int getPublishedPlanVersion() const {
+        return publishedPlanVersion;
+    }
+
+    double getPublishedPlanGenerationTime() const {
+        return publishedPlanGenerationTime;
+    }
+
+    /**
+     * plans per second (in wall clock time) the planner thread makes at most
+     */
+    void setPlanningRate(double rate) {
+        planningRate = rate;
+    }
+
+    double getPlanningRate() const {
+        return planningRate;
+    }
+
+    std::shared_ptr<LocomotionTrajectoryPlanner> getPlanner() const {
+        return planner;
+    }
+
+private:
+    // what requestPlan hands over to the planner thread
+    struct Request {
+        RobotState robotState;
+        double simTime = 0;
+        double dt = 1 / 30.0;
+
+        double trunkHeight = 0;
+        double trunkPitch = 0;
+        double trunkRoll = 0;
+        double trunkYaw = 0;
+        double speedForward = 0;
+        double speedSideways = 0;
+        double turningSpeed = 0;
+        double stepWidthModifier = 0;
+        double targetStepHeight = 0;
+    };
+
+    void plannerLoop() {
+        while (!stopping) {
+            auto start = std::chrono::steady_clock::now();
+            if (requests.update())
+                plan(requests.getFrontBuffer());
+            std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(1.0 / planningRate)));
+        }
+    }
+
+    // plans for the request, and publishes the plan
+    void plan(const Request& request) {
+        LocomotionTrajectoryPlanner& p = *planner;
+
+        // the planner keeps its own clock, which tidies up its contact schedule
+        p.advanceInTime(request.simTime - p.simTime);
+        p.trunkHeight = request.trunkHeight;
+        p.trunkPitch = request.trunkPitch;
+        p.trunkRoll = request.trunkRoll;
+        p.trunkYaw = request.trunkYaw;
+        p.speedForward = request.speedForward;
+        p.speedSideways = request.speedSideways;
+        p.turningSpeed = request.turningSpeed;
+        p.stepWidthModifier = request.stepWidthModifier;
+        p.targetStepHeight = request.targetStepHeight;
+        p.robot->setState(request.robotState);
+
+        p.appendPeriodicGaitIfNeeded(*gaitPlanner);
+        p.planGenerationTime = p.simTime;
+        p.generateTrajectoriesFromCurrentState(request.dt);
+
+        LocomotionPlan& plan = plans.getBackBuffer();
+        plan.sample(p, request.dt);
+        plan.version = ++nPlans;
+        // before the plan, so that whoever gets the plan sees them too
+        publishedPlanGenerationTime = p.planGenerationTime;
+        publishedPlanVersion = nPlans;
+        plans.publish();
+    }
+
+    std::shared_ptr<LocomotionTrajectoryPlanner> planner;
+    std::shared_ptr<const GaitPlanner> gaitPlanner;
+
+    TripleBuffer<Request> requests;
+    TripleBuffer<LocomotionPlan> plans;
+    // owned by whoever plans: the first caller of requestPlan, then the planner thread
+    int nPlans = 0;
+    // for anyone who does not track the plans
+    std::atomic<int> publishedPlanVersion{0};
+    std::atomic<double> publishedPlanGenerationTime{0};
+
+    std::atomic<double> planningRate;
+    std::atomic<bool> stopping{false};
+    std::thread plannerThread;
+};
+
+}  // namespace crl::loco
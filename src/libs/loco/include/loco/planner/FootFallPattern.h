@@ -2,9 +2,9 @@
 
 #include <crl-basic/utils/trajectory.h>
 #include <crl-basic/utils/utils.h>
-#include <imgui_widgets/ImGuizmo.h>
 #include <loco/robot/LeggedRobot.h>
-#include <loco/shared/value_share.h>
+
+#include <algorithm>
 
 using namespace std;
 
@@ -35,8 +35,18 @@ public:
     }
 
     void clearSwingPhasesBefore(double t) {
-        while (swingPhases.size() > 0 && swingPhases.front().second < t)
-            swingPhases.erase(swingPhases.begin());
+        auto firstToKeep = std::find_if(swingPhases.begin(), swingPhases.end(), [t](const pair<double, double> &sp) { return sp.second >= t; });
+        swingPhases.erase(swingPhases.begin(), firstToKeep);
+    }
+
+    /**
+     * swing phases are sorted, and do not overlap, so this is a binary search
+     * for the index of the last swing phase that starts before t (0 if there
+     * is none)
+     */
+    int getIndexOfSwingPhaseStartingBefore(double t) const {
+        auto it = std::lower_bound(swingPhases.begin(), swingPhases.end(), t, [](const pair<double, double> &sp, double t) { return sp.first < t; });
+        return it == swingPhases.begin() ? 0 : (int)(it - swingPhases.begin()) - 1;
     }
 };
 
@@ -144,22 +154,22 @@ public:
         this->timeLeft = timeLeft;
     }
 
-    bool isSwing() {
+    bool isSwing() const {
         return swingMode;
     }
 
-    bool isStance() {
+    bool isStance() const {
         return !swingMode;
     }
 
     /**
      * time left until the next phase starts
      */
-    double getTimeLeft() {
+    double getTimeLeft() const {
         return timeLeft;
     }
 
-    double getDuration() {
+    double getDuration() const {
         return contactPhaseDuration;
     }
 
@@ -167,7 +177,7 @@ public:
      * relative amount of elapsed time in this swing/stance mode. 0 means it is
      * at the very start, 1 means it is at the end
      */
-    double getPercentageOfTimeElapsed() {
+    double getPercentageOfTimeElapsed() const {
         return (contactPhaseDuration - timeLeft) / contactPhaseDuration;
     }
 };
@@ -182,6 +192,27 @@ public:
     // swing phases stored in absolute time...
     DynamicArray<SwingPhaseContainer> cs;
 
+private:
+    // for each limbIndex, where the limb's swing phases are in cs (or -1), so
+    // that looking them up does not need to go through all the limbs
+    DynamicArray<int> csIndexForLimb;
+
+    // counts the swing phases that were added, or extended, so far
+    int changeCount = 0;
+
+    int getCSIndexForLimb(const std::shared_ptr<RobotLimb> &l) const {
+        if (l->limbIndex >= 0 && l->limbIndex < (int)csIndexForLimb.size()) {
+            int i = csIndexForLimb[l->limbIndex];
+            if (i >= 0 && cs[i].limb == l)
+                return i;
+        }
+        // limbs that were added to cs directly, or that belong to another robot
+        for (uint i = 0; i < cs.size(); i++)
+            if (cs[i].limb == l)
+                return i;
+        return -1;
+    }
+
 public:
 
     void addSwingPhaseForLimb(const std::shared_ptr<RobotLimb> &l, double start, double end) {
@@ -198,17 +229,18 @@ public:
             return;
         }
 
-        int lIndex = 0;
+        int lIndex = getCSIndexForLimb(l);
+        changeCount++;
 
-        // periodic gaits will admit only one swing phase per gait cycle...
-        for (auto ls : cs) {
-            if (ls.limb == l)
-                break;
-            lIndex++;
-        }
-
-        if (lIndex == (int)cs.size())
+        if (lIndex == -1) {
+            lIndex = (int)cs.size();
             cs.push_back(SwingPhaseContainer(l));
+            if (l->limbIndex >= 0) {
+                if (l->limbIndex >= (int)csIndexForLimb.size())
+                    csIndexForLimb.resize(l->limbIndex + 1, -1);
+                csIndexForLimb[l->limbIndex] = lIndex;
+            }
+        }
 
         // now, make sure that this new swing phase starts after the previous
         // one has ended...
@@ -228,33 +260,46 @@ public:
         cs[lIndex].addSwingPhase(start, end);
     }
 
+    // changes whenever a swing phase is added to the schedule (or an existing
+    // one is extended), so plans can tell whether they are out of date.
+    // Dropping swing phases that are over does not count as a change
+    int getChangeCount() const {
+        return changeCount;
+    }
+
     void addPeriodicGaitToContactSequence(const PeriodicGait &pg, double startTime) {
-        double strideDuration = strideDurationInSeconds(*targetForwardSpeed_shared);
         for (auto ls : pg.swingPhases)
-            addSwingPhaseForLimb(ls.limb, startTime + ls.swingPhases.front().first * strideDuration,
-                                 startTime + ls.swingPhases.front().second * strideDuration);
+            addSwingPhaseForLimb(ls.limb, startTime + ls.swingPhases.front().first * pg.strideDuration,
+                                 startTime + ls.swingPhases.front().second * pg.strideDuration);
     }
 
     SwingPhaseContainer *getSwingPhaseContainerForLimb(const std::shared_ptr<RobotLimb> &l) {
-        for (uint i = 0; i < cs.size(); i++)
-            if (cs[i].limb == l)
-                return &cs[i];
-        return nullptr;
+        int i = getCSIndexForLimb(l);
+        return i >= 0 ? &cs[i] : nullptr;
+    }
+
+    const SwingPhaseContainer *getSwingPhaseContainerForLimb(const std::shared_ptr<RobotLimb> &l) const {
+        int i = getCSIndexForLimb(l);
+        return i >= 0 ? &cs[i] : nullptr;
     }
 
     /**
      * returns a data structure that can be used to determine, based on absolute
      * time t, if the limb is in swing or stance mode, time remaining for the
-     * current contact configuration, etc...
+     * current contact configuration, etc... Queries do not modify the
+     * schedule, so they can be made from several threads at once. To query
+     * times that increase, a ContactPhaseCursor is faster.
      */
-    ContactPhaseInfo getContactPhaseInformation(const std::shared_ptr<RobotLimb> &l, double t) {
-        SwingPhaseContainer *spc = nullptr;
-        for (uint i = 0; i < cs.size(); i++)
-            if (cs[i].limb == l) {
-                spc = &cs[i];
-                break;
-            }
+    ContactPhaseInfo getContactPhaseInformation(const std::shared_ptr<RobotLimb> &l, double t) const {
+        const SwingPhaseContainer *spc = getSwingPhaseContainerForLimb(l);
+        return getContactPhaseInformation(spc, spc != nullptr ? spc->getIndexOfSwingPhaseStartingBefore(t) : 0, t);
+    }
 
+    /**
+     * the same, for the swing phases in spc, given the index i of the last
+     * one that starts before t (0 if there is none)
+     */
+    static ContactPhaseInfo getContactPhaseInformation(const SwingPhaseContainer *spc, int i, double t) {
         // if we have no information for this limb, we assume no one gave it any
         // swing phases, so it must be allways in stance then...
         if (spc == nullptr)
@@ -274,31 +319,164 @@ public:
         if (spc->swingPhases.back().second < t)
             return ContactPhaseInfo(false, 100, 50);
 
-        // if none of the above are true, t must fall between swing phases, or
-        // within a swing phase...
-        for (int i = 0; i < (int)spc->swingPhases.size(); i++) {
-            // see if t falls within a swing phase
-            if (t >= spc->swingPhases[i].first && t <= spc->swingPhases[i].second) {
-                return ContactPhaseInfo(true, spc->swingPhases[i].second - spc->swingPhases[i].first, spc->swingPhases[i].second - t);
-            }
-            // since swing phases are sorted, if t is smaller than the next
-            // swing phase, it means it falls within a contact region... note:
-            // we know that t does not start after the last swing phase, so the
-            // "i+1" here should be safe...
-            if (t <= spc->swingPhases[i + 1].first) {
-                // assert(false); // This should never happen for us
-                return ContactPhaseInfo(false, spc->swingPhases[i + 1].first - spc->swingPhases[i].second, spc->swingPhases[i + 1].first - t);
+        // if none of the above are true, t must fall within swing phase i, or
+        // in the contact region that follows it (swing phase i starts before
+        // t, and the next one does not)...
+        if (t <= spc->swingPhases[i].second)
+            return ContactPhaseInfo(true, spc->swingPhases[i].second - spc->swingPhases[i].first, spc->swingPhases[i].second - t);
+        // note: we know that t does not start after the last swing phase, so
+        // the "i+1" here is safe...
+        return ContactPhaseInfo(false, spc->swingPhases[i + 1].first - spc->swingPhases[i].second, spc->swingPhases[i + 1].first - t);
+    }
+};
+
+typedef ContactSchedule FootFallPattern;
+
+/**
+ * the contact phases of the limbs in a schedule, sampled at N times: tStart,
+ * and then one dt after the other. The sample times are accumulated the same
+ * way as the times of the knots of planned trajectories, so knots that start
+ * from tStart fall exactly on them. For every limb (indexed by limbIndex),
+ * the samples are stored in plain arrays.
+ */
+class ContactTimeline {
+public:
+    double tStart = 0;
+    double dt = 0;
+    DynamicArray<double> times;
+
+    // indexed by limbIndex, and then by sample. Limbs that have no swing
+    // phases in the schedule have no samples
+    DynamicArray<DynamicArray<char>> isSwing;
+    DynamicArray<DynamicArray<double>> duration;
+    DynamicArray<DynamicArray<double>> timeLeft;
+    DynamicArray<DynamicArray<double>> progress;
+
+public:
+    // the arrays keep their storage from one call to the next
+    void sample(const ContactSchedule &cs, double tStart, double dt, int N) {
+        this->tStart = tStart;
+        this->dt = dt;
+        times.resize(N);
+        double t = tStart;
+        for (int k = 0; k < N; k++, t += dt)
+            times[k] = t;
+
+        int nLimbs = 0;
+        for (const auto &spc : cs.cs)
+            nLimbs = std::max(nLimbs, spc.limb->limbIndex + 1);
+        isSwing.resize(nLimbs);
+        duration.resize(nLimbs);
+        timeLeft.resize(nLimbs);
+        progress.resize(nLimbs);
+        for (int l = 0; l < nLimbs; l++) {
+            isSwing[l].clear();
+            duration[l].clear();
+            timeLeft[l].clear();
+            progress[l].clear();
+        }
+
+        for (const auto &spc : cs.cs) {
+            int l = spc.limb->limbIndex;
+            if (l < 0)
+                continue;
+            isSwing[l].resize(N);
+            duration[l].resize(N);
+            timeLeft[l].resize(N);
+            progress[l].resize(N);
+            // the swing phase that starts before the sample times, which go up
+            int i = 0;
+            for (int k = 0; k < N; k++) {
+                while (i + 1 < (int)spc.swingPhases.size() && spc.swingPhases[i + 1].first < times[k])
+                    i++;
+                ContactPhaseInfo cpi = ContactSchedule::getContactPhaseInformation(&spc, i, times[k]);
+                isSwing[l][k] = cpi.isSwing();
+                duration[l][k] = cpi.getDuration();
+                timeLeft[l][k] = cpi.getTimeLeft();
+                progress[l][k] = cpi.getPercentageOfTimeElapsed();
             }
         }
+    }
+
+    bool hasSamplesFor(int limbIndex) const {
+        return limbIndex >= 0 && limbIndex < (int)isSwing.size() && !isSwing[limbIndex].empty();
+    }
+
+    // the index of the sample taken at exactly time t, or -1
+    int getSampleIndex(double t) const {
+        if (times.empty() || !(dt > 0))
+            return -1;
+        double k = (t - tStart) / dt + 0.5;
+        if (!(k >= 0 && k < (double)times.size()))
+            return -1;
+        return times[(int)k] == t ? (int)k : -1;
+    }
 
-        // all right, we should never get here...
-        assert(false);
-        // but the show must go on...
-        return ContactPhaseInfo(false, 100, 50);
+    // the same as what the schedule says at the time of sample k
+    ContactPhaseInfo getContactPhaseInformation(int limbIndex, int k) const {
+        return ContactPhaseInfo(isSwing[limbIndex][k] != 0, duration[limbIndex][k], timeLeft[limbIndex][k]);
     }
 };
 
-typedef ContactSchedule FootFallPattern;
+/**
+ * answers contact phase queries for one limb, starting the search for the
+ * swing phase at t from the one the last query found. Sweeping through the
+ * schedule with increasing t therefore takes constant time per query, rather
+ * than a binary search. Queries that go back in time are fine too, they just
+ * fall back to a binary search. If the cursor is given a timeline of the
+ * schedule, queries at its sample times are looked up instead. The cursor is
+ * valid only as long as the schedule (and the timeline) do not change.
+ */
+class ContactPhaseCursor {
+private:
+    const SwingPhaseContainer *spc = nullptr;
+    // the index of the last swing phase that started before the last query
+    int i = 0;
+
+    // the samples of the limb in the timeline, if there is one
+    const ContactTimeline *timeline = nullptr;
+    int nSamples = 0;
+    const double *times = nullptr;
+    const char *isSwing = nullptr;
+    const double *duration = nullptr;
+    const double *timeLeft = nullptr;
+    // the sample the last query was at (or -1)
+    int k = -1;
+
+public:
+    ContactPhaseCursor(const ContactSchedule &cs, const std::shared_ptr<RobotLimb> &l, const ContactTimeline *timeline = nullptr) {
+        spc = cs.getSwingPhaseContainerForLimb(l);
+        if (timeline != nullptr && timeline->hasSamplesFor(l->limbIndex)) {
+            this->timeline = timeline;
+            nSamples = (int)timeline->times.size();
+            times = timeline->times.data();
+            isSwing = timeline->isSwing[l->limbIndex].data();
+            duration = timeline->duration[l->limbIndex].data();
+            timeLeft = timeline->timeLeft[l->limbIndex].data();
+        }
+    }
+
+    ContactPhaseInfo getContactPhaseInformation(double t) {
+        if (timeline != nullptr) {
+            // sweeps usually query one sample after the other
+            if (k + 1 < nSamples && times[k + 1] == t)
+                k++;
+            else if (k < 0 || times[k] != t)
+                k = timeline->getSampleIndex(t);
+            if (k >= 0)
+                return ContactPhaseInfo(isSwing[k] != 0, duration[k], timeLeft[k]);
+        }
+        if (spc != nullptr) {
+            const auto &swingPhases = spc->swingPhases;
+            if (i > 0 && swingPhases[i].first >= t)
+                i = spc->getIndexOfSwingPhaseStartingBefore(t);
+            else
+                while (i + 1 < (int)swingPhases.size() && swingPhases[i + 1].first < t)
+                    i++;
+        }
+        return ContactSchedule::getContactPhaseInformation(spc, i, t);
+    }
+};
 
 class ContactPlanManager {
 public:
@@ -307,25 +485,29 @@ public:
     // this is the time when the last periodic ffp was added. When a new one
     // will be added, it will go from there...
     double timeStampForLastUpdate = 0;
-    // visualization options here...
-    double visTimeWindow = 3;
-    // this is the overall window width we want for the visualizer...
-    double cpmWindowWidth = 1300;
-    double labelWindowWidth = 50;
-    bool drawLabels = true;
-
     // this is the schedule of planned swing and stance phases for all the
     // limbs...
     ContactSchedule cs;
 
+private:
+    // the contact phases, sampled for the last grid they were asked for, and
+    // the version of the schedule they were sampled from
+    ContactTimeline timeline;
+    std::pair<int, int> timelineScheduleVersion = {-1, -1};
+    // counts the times tidyUp dropped swing phases that the timeline depends on
+    int tidyUpCount = 0;
+
+    std::pair<int, int> getScheduleVersion() const {
+        return {cs.getChangeCount(), tidyUpCount};
+    }
+
 public:
     ContactPlanManager() {}
 
     void appendPeriodicGaitToPlanningHorizon(const PeriodicGait &pg) {
         cs.addPeriodicGaitToContactSequence(pg, timeStampForLastUpdate);
-        double strideDuration = strideDurationInSeconds(*targetForwardSpeed_shared);
-        strideUpdates.push_back(pair<double, double>(timeStampForLastUpdate, timeStampForLastUpdate + strideDuration));
-        timeStampForLastUpdate += strideDuration;
+        strideUpdates.push_back(pair<double, double>(timeStampForLastUpdate, timeStampForLastUpdate + pg.strideDuration));
+        timeStampForLastUpdate += pg.strideDuration;
     }
 
     double timeUntilEndOfPlanningHorizon(double t) {
@@ -333,182 +515,54 @@ public:
     }
 
     void tidyUp(double t) {
-        for (uint i = 0; i < cs.cs.size(); i++)
+        for (uint i = 0; i < cs.cs.size(); i++) {
+            const auto &swingPhases = cs.cs[i].swingPhases;
+            size_t nSwingPhases = swingPhases.size();
+            double tLastDropped = 0;
+            for (const auto &sp : swingPhases)
+                if (sp.second < t)
+                    tLastDropped = sp.second;
             cs.cs[i].clearSwingPhasesBefore(t);
+            // the samples of the timeline only depend on the swing phases
+            // that were dropped if they are not all over by the first sample,
+            // or if no other swing phase starts before it
+            if (swingPhases.size() != nSwingPhases &&
+                !(tLastDropped < timeline.tStart && (swingPhases.empty() || swingPhases.front().first < timeline.tStart)))
+                tidyUpCount++;
+        }
         while (strideUpdates.size() > 0 && strideUpdates.front().second < t)
             strideUpdates.erase(strideUpdates.begin());
     }
 
-    ContactPhaseInfo getCPInformationFor(const std::shared_ptr<RobotLimb> &limb, double t) {
+    ContactPhaseInfo getCPInformationFor(const std::shared_ptr<RobotLimb> &limb, double t) const {
         return cs.getContactPhaseInformation(limb, t);
     }
 
-    float getWindowCoord(double tVal, double tStart, double tEnd) {
-        double p = (tVal - tStart) / (tEnd - tStart);
-        return labelWindowWidth + (float)p * (cpmWindowWidth);
-    }
-
-    // use Dear ImGUI code to visualize the contact schedule...
-    void visualizeContactSchedule(double t, double gridStartTime = -1, double dt_grid = 1 / 30.0, int nGridSteps = 30) {
-        ImGui::SetNextWindowBgAlpha(1.0);
-        ImGui::Begin("Contact Schedule Visualizer");
-        ImGuizmo::BeginFrame();
-
-        //		float time_ = t;
-        //		ImGui::SliderFloat("CPM time", &time_, -10, 10);
-        //		t = time_;
-
-        ImGui::Checkbox("draw labels", &drawLabels);
-
-        //		ImGui::InputDouble("Time window", &visTimeWindow, 0.5);
-        //		if (visTimeWindow < 0.5) visTimeWindow = 0.5;
-
-        //		if (ImGui::Button("Clean up CP"))
-        //			tidyUp();
-
-        // this is where the window screen starts...
-        ImVec2 p = ImGui::GetCursorScreenPos();
-        ImDrawList *draw_list = ImGui::GetWindowDrawList();
-
-        double timeStart = t - visTimeWindow * 0.25;
-        double timeEnd = t + visTimeWindow;
-
-        // this is for every row which will visualize the foot fall pattern for
-        // one robot limb...
-        float height = ImGui::GetFrameHeight();
-        float radius = height * 0.005f;
-        ImU32 col_bg = ImGui::GetColorU32(ImVec4(0.0f, 0.0f, 0.0f, 1.0f));
-        draw_list->AddRectFilled(ImVec2(p.x, p.y), ImVec2(p.x + labelWindowWidth + cpmWindowWidth + 20, p.y + cs.cs.size() * height), col_bg);
-
-        ImU32 col_text_gray = ImGui::GetColorU32(ImVec4(0.8f, 0.8f, 1.0f, 1.0f));
-        ImU32 col_line = ImGui::GetColorU32(ImVec4(0.7f, 0.7f, 0.7f, 1.0f));
-        ImU32 col_cursor = ImGui::GetColorU32(ImVec4(1.0f, 0.7f, 0.7f, 1.0f));
-        ImU32 col_horizon = ImGui::GetColorU32(ImVec4(0.5f, 0.5f, 0.5f, 1.0f));
-        ImU32 col_text_dark = ImGui::GetColorU32(ImVec4(0.1f, 0.1f, 0.1f, 1.0f));
-
-        // draw the swing phases now...
-        float rowOffset = 0;
-        for (auto lcs : cs.cs) {
-            ContactPhaseInfo cpi = cs.getContactPhaseInformation(lcs.limb, t);
-            for (auto sp : lcs.swingPhases) {
-                float start = getWindowCoord(sp.first, timeStart, timeEnd);
-                float end = getWindowCoord(sp.second, timeStart, timeEnd);
-                if (end > labelWindowWidth && start < labelWindowWidth + cpmWindowWidth) {
-                    ImU32 col = ImGui::GetColorU32(ImVec4(0.7f, 0.7f, 0.7f, 1.0f));
-                    if (start < labelWindowWidth - 5)
-                        start = labelWindowWidth - 5;
-                    if (end > labelWindowWidth + cpmWindowWidth + 5)
-                        end = labelWindowWidth + cpmWindowWidth + 5;
-                    // only mark as in swing the relevant one...
-                    if (cpi.isSwing() && sp.first <= t && sp.second >= t)
-                        col = ImGui::GetColorU32(ImVec4(1.0f - 0.3 * cpi.getPercentageOfTimeElapsed(), 0.7f * (cpi.getPercentageOfTimeElapsed()),
-                                                        0.7f * (cpi.getPercentageOfTimeElapsed()), 1.0f));
-                    draw_list->AddRectFilled(ImVec2(p.x + start, p.y + rowOffset + height * 0.15), ImVec2(p.x + end, p.y + rowOffset + height * 0.85), col,
-                                             height * radius);
-                }
-            }
-            rowOffset += height;
-        }
-
-        // cover up the loose ends of the swing phases...
-
-        draw_list->AddRectFilled(ImVec2(p.x, p.y), ImVec2(p.x + labelWindowWidth, p.y + rowOffset), col_bg);
-        draw_list->AddRectFilled(ImVec2(p.x + labelWindowWidth + cpmWindowWidth, p.y), ImVec2(p.x + labelWindowWidth + cpmWindowWidth + 20, p.y + rowOffset),
-                                 col_bg);
-
-        // draw the grid, the labels of the limbs, and the time cursor...
-        rowOffset = 0;
-        draw_list->AddLine(ImVec2(p.x, p.y + rowOffset), ImVec2(p.x + labelWindowWidth + cpmWindowWidth, p.y + rowOffset), col_line);
-        for (auto lcs : cs.cs) {
-            draw_list->AddText(ImVec2(p.x + height * 0.5, p.y + rowOffset + height * 0.1), col_text_gray, lcs.limb->name.c_str());
-            rowOffset += height;
-            draw_list->AddLine(ImVec2(p.x, p.y + rowOffset), ImVec2(p.x + labelWindowWidth + cpmWindowWidth, p.y + rowOffset), col_line);
-        }
-        draw_list->AddLine(ImVec2(p.x, p.y), ImVec2(p.x, p.y + rowOffset), col_line);
-        draw_list->AddLine(ImVec2(p.x + labelWindowWidth, p.y), ImVec2(p.x + labelWindowWidth, p.y + rowOffset), col_line);
-        draw_list->AddLine(ImVec2(p.x + labelWindowWidth + cpmWindowWidth, p.y), ImVec2(p.x + labelWindowWidth + cpmWindowWidth, p.y + rowOffset), col_line);
-
-        for (auto s : strideUpdates) {
-            float sVal = getWindowCoord(s.first, timeStart, timeEnd);
-            if (sVal >= labelWindowWidth && sVal <= labelWindowWidth + cpmWindowWidth)
-                draw_list->AddLine(ImVec2(p.x + sVal, p.y - 5), ImVec2(p.x + sVal, p.y + rowOffset + 5), col_horizon);
-        }
-
-        // show where the current moment in time is...
-        float cursorVal;
-
-        if (gridStartTime > -1) {
-            int N = nGridSteps;
-            for (int i = 0; i < N + 1; i++) {
-                double t_tmp = gridStartTime + i * dt_grid;
-                if (t_tmp >= timeStart) {
-                    cursorVal = getWindowCoord(t_tmp, timeStart, timeEnd);
-
-                    if (i == 0 || i == N) {
-                        draw_list->AddLine(ImVec2(p.x + cursorVal, p.y), ImVec2(p.x + cursorVal, p.y + rowOffset), col_line, 2);
-                        draw_list->AddCircleFilled(ImVec2(p.x + cursorVal, p.y - 5), 5, col_line);
-                        draw_list->AddCircleFilled(ImVec2(p.x + cursorVal, p.y + rowOffset + 5), 5, col_line);
-                        char timeTextForMPC[100];
-                        sprintf(timeTextForMPC, "t = %2.2lfs", t_tmp);
-                        draw_list->AddText(ImVec2(p.x + cursorVal - height / 2.0, p.y + rowOffset + height * 0.5), col_text_gray, timeTextForMPC);
-                    } else {
-                        draw_list->AddLine(ImVec2(p.x + cursorVal, p.y), ImVec2(p.x + cursorVal, p.y + rowOffset), col_line, 0.5);
-                    }
-                }
-
-                if (t_tmp <= t && t < t_tmp + dt_grid && i < N) {
-                    double cursorVal_tmp = getWindowCoord(t, timeStart, timeEnd);
-                    char timeText[100];
-                    sprintf(timeText, "mpc t idx: %d", i);
-                    draw_list->AddText(ImVec2(p.x + cursorVal_tmp, p.y + rowOffset - 220), col_cursor, timeText);
-                }
-            }
-        }
-
-        cursorVal = getWindowCoord(t, timeStart, timeEnd);
-        draw_list->AddLine(ImVec2(p.x + cursorVal, p.y), ImVec2(p.x + cursorVal, p.y + rowOffset), col_cursor);
-        char timeText[100];
-        sprintf(timeText, "t = %2.2lfs", t);
-        draw_list->AddText(ImVec2(p.x + cursorVal - height / 2.0, p.y + rowOffset + height * 0.5), col_cursor, timeText);
-        draw_list->AddCircleFilled(ImVec2(p.x + cursorVal, p.y - 5), 5, col_cursor);
-        draw_list->AddCircleFilled(ImVec2(p.x + cursorVal, p.y + rowOffset + 5), 5, col_cursor);
-
-        // and also show here the planning horizon...
-        float horizonVal = getWindowCoord(timeStampForLastUpdate, timeStart, timeEnd);
-        if (horizonVal <= labelWindowWidth + cpmWindowWidth) {
-            draw_list->AddLine(ImVec2(p.x + horizonVal, p.y), ImVec2(p.x + horizonVal, p.y + rowOffset), col_horizon);
-            char timeText[100];
-            sprintf(timeText, "t = %2.2lfs", timeStampForLastUpdate);
-            draw_list->AddText(ImVec2(p.x + horizonVal - height / 2.0, p.y + rowOffset + height * 0.5), col_horizon, timeText);
-            draw_list->AddCircleFilled(ImVec2(p.x + horizonVal, p.y - 5), 5, col_horizon);
-            draw_list->AddCircleFilled(ImVec2(p.x + horizonVal, p.y + rowOffset + 5), 5, col_horizon);
+    /**
+     * the contact phases of all limbs at (at least) N times, from tStart on,
+     * one dt after the other. They are only sampled again if the schedule
+     * changed since the last call, or if the times were not sampled then.
+     */
+    const ContactTimeline &getTimeline(double tStart, double dt, int N) {
+        int k = -1;
+        if (timelineScheduleVersion == getScheduleVersion() && timeline.dt == dt)
+            k = timeline.getSampleIndex(tStart);
+        if (k < 0) {
+            timeline.sample(cs, tStart, dt, N);
+            timelineScheduleVersion = getScheduleVersion();
+        } else if (k + N > (int)timeline.times.size()) {
+            // the times continue the ones of the last call, so plans that
+            // keep going on from here get room to use the same samples
+            timeline.sample(cs, tStart, dt, 2 * N);
+            timelineScheduleVersion = getScheduleVersion();
         }
+        return timeline;
+    }
 
-        // finally draw the labels of the swing/stance phases...
-        rowOffset = 0;
-        if (drawLabels)
-            for (auto lcs : cs.cs) {
-                ContactPhaseInfo cpi = cs.getContactPhaseInformation(lcs.limb, t);
-                char text[100];
-                if (cpi.isSwing()) {
-                    sprintf(text, "p:%2.0lf%%", cpi.getPercentageOfTimeElapsed() * 100);
-                    float labelPos = getWindowCoord(t + cpi.getTimeLeft() - cpi.getDuration(), timeStart, timeEnd);
-                    draw_list->AddText(ImVec2(p.x + labelPos + 15, p.y + rowOffset + height * 0.075), col_text_dark, text);
-                } else {
-                    if (cpi.getTimeLeft() < 10) {
-                        sprintf(text, "t-%2.2lfs", cpi.getTimeLeft());
-                        float labelPos = getWindowCoord(t + cpi.getTimeLeft(), timeStart, timeEnd);
-                        draw_list->AddText(ImVec2(p.x + labelPos + 15, p.y + rowOffset + height * 0.075), col_text_dark, text);
-                    } else {
-                        sprintf(text, "inStance");
-                        float labelPos = getWindowCoord(t, timeStart, timeEnd);
-                        draw_list->AddText(ImVec2(p.x + labelPos + 15, p.y + rowOffset + height * 0.075), col_text_gray, text);
-                    }
-                }
-                rowOffset += height;
-            }
-
-        ImGui::End();
+    // for queries about a limb at times that mostly increase. Queries at the
+    // times of the last timeline are looked up in it, if it is up to date
+    ContactPhaseCursor getCPCursorFor(const std::shared_ptr<RobotLimb> &limb) const {
+        return ContactPhaseCursor(cs, limb, timelineScheduleVersion == getScheduleVersion() ? &timeline : nullptr);
     }
 };
 
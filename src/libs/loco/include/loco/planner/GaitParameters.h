@@ -0,0 +1,160 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace crl::loco {
+
+/**
+ * The parameters of the gait of a character that depend on how fast it
+ * walks: how long its strides last, and for how much of a stride a foot
+ * swings. Both follow measurements of humans walking and running. The
+ * curves are tabulated every speedStep m/s up to maxSpeed whenever one of
+ * the parameters is set, and queries interpolate the tables linearly,
+ * clamping speeds to [0, maxSpeed]. Parameters are per character, and
+ * characters that walk the same way can share them.
+ */
+class GaitParameters {
+public:
+    GaitParameters() {
+        tabulate();
+    }
+
+    // m/s. No reliable measurements exist below this speed, so we use this as our initial speed.
+    double getInitSpeed() const {
+        return initSpeed;
+    }
+
+    void setInitSpeed(double speed) {
+        initSpeed = speed;
+        tabulate();
+    }
+
+    // m/s. The speed at which humans transition from walking to running according to Hansen et al. (2017).
+    double getWalkToRunTransitionSpeed() const {
+        return walkToRunTransitionSpeed;
+    }
+
+    void setWalkToRunTransitionSpeed(double speed) {
+        walkToRunTransitionSpeed = speed;
+        tabulate();
+    }
+
+    // m/s. We could go higher.
+    double getMaxSpeed() const {
+        return maxSpeed;
+    }
+
+    void setMaxSpeed(double speed) {
+        maxSpeed = speed;
+        tabulate();
+    }
+
+    // m/s. The spacing of the tables. Within one step of the walk to run
+    // transition, the stride duration blends from walking to running
+    double getSpeedStep() const {
+        return speedStep;
+    }
+
+    void setSpeedStep(double step) {
+        speedStep = step;
+        tabulate();
+    }
+
+    /**
+     * the stride duration (in seconds) is slope * speed + intercept, below
+     * the walk to run transition speed
+     */
+    void setWalkingStrideDuration(double slope, double intercept) {
+        strideDurationSlopeWalk = slope;
+        strideDurationInterceptWalk = intercept;
+        tabulate();
+    }
+
+    /**
+     * the stride duration (in seconds) is slope * speed + intercept, from the
+     * walk to run transition speed on
+     */
+    void setRunningStrideDuration(double slope, double intercept) {
+        strideDurationSlopeRun = slope;
+        strideDurationInterceptRun = intercept;
+        tabulate();
+    }
+
+    /**
+     * returns the duration of a stride in seconds.
+     */
+    double getStrideDuration(double speed) const {
+        return lookUp(strideDurations, speed);
+    }
+
+    /**
+     * returns the duration of the swing phase relative to the whole stride duration.
+     */
+    double getRelativeSwingPhaseDuration(double speed) const {
+        return lookUp(relativeSwingPhaseDurations, speed);
+    }
+
+    /**
+     * returns the speed, clamped to [0, maxSpeed], over maxSpeed
+     */
+    double getNormalizedSpeed(double speed) const {
+        return std::clamp(speed, 0.0, maxSpeed) / maxSpeed;  // We should also allow negative speeds.
+    }
+
+private:
+    /**
+     * fills in the tables, which every setter does again
+     */
+    void tabulate() {
+        int nSamples = (int)std::ceil(maxSpeed / speedStep) + 1;
+        strideDurations.resize(nSamples);
+        relativeSwingPhaseDurations.resize(nSamples);
+        for (int k = 0; k < nSamples; k++) {
+            strideDurations[k] = computeStrideDuration(k * speedStep);
+            relativeSwingPhaseDurations[k] = computeRelativeSwingPhaseDuration(k * speedStep);
+        }
+    }
+
+    double computeStrideDuration(double speed) const {
+        if (speed < walkToRunTransitionSpeed) {
+            return strideDurationSlopeWalk * speed + strideDurationInterceptWalk;
+        } else {
+            return strideDurationSlopeRun * speed + strideDurationInterceptRun;
+        }
+    }
+
+    double computeRelativeSwingPhaseDuration(double speed) const {
+        if (speed < initSpeed) {
+            return (3.4 * initSpeed + 37.1) / 100.0;  // Hansen et al. was in percent, so we divide by 100.
+        } else if (speed > walkToRunTransitionSpeed) {
+            return 0.6;  // Beyond walking speed, we fix to 60%.
+        } else {
+            return (3.4 * speed + 37.1) / 100.0;  // Hansen et al. was in percent, so we divide by 100.
+        }
+    }
+
+    double lookUp(const std::vector<double> &table, double speed) const {
+        double x = std::clamp(speed, 0.0, maxSpeed) / speedStep;
+        int k = std::min((int)x, (int)table.size() - 2);
+        return table[k] + (x - k) * (table[k + 1] - table[k]);
+    }
+
+    double initSpeed = 0.6;
+    double walkToRunTransitionSpeed = 2.1;
+    double maxSpeed = 8;
+    double speedStep = 0.01;
+
+    // According to Nilsson et al (1985).
+    double strideDurationSlopeWalk = -0.419;
+    double strideDurationInterceptWalk = 1.927;
+    double strideDurationSlopeRun = -0.041;
+    double strideDurationInterceptRun = 0.901;
+
+    // sampled every speedStep, from 0 to (at least) maxSpeed
+    std::vector<double> strideDurations;
+    std::vector<double> relativeSwingPhaseDurations;
+};
+
+}  // namespace crl::loco
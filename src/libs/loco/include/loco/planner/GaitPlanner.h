@@ -6,6 +6,7 @@
 #define PROCEDURAL_LOCOMOTION_GAITPLANNER_H
 
 #include "loco/planner/FootFallPattern.h"
+#include "loco/planner/GaitParameters.h"
 
 namespace crl::loco {
 
@@ -16,7 +17,12 @@ class GaitPlanner {
 public:
     virtual ~GaitPlanner() = default;
 
-    virtual PeriodicGait getPeriodicGait(const std::shared_ptr<LeggedRobot> &robot) const = 0;
+    /**
+     * the gait of the robot when it walks forward at forwardSpeed, with the
+     * given gait parameters. Its stride duration is how long one gait cycle
+     * lasts in the contact schedule
+     */
+    virtual PeriodicGait getPeriodicGait(const std::shared_ptr<LeggedRobot> &robot, const GaitParameters &gaitParameters, double forwardSpeed) const = 0;
 };
 
 /**
@@ -26,7 +32,7 @@ class QuadrupedalGaitPlanner : public GaitPlanner {
 public:
     ~QuadrupedalGaitPlanner() override = default;
 
-    PeriodicGait getPeriodicGait(const std::shared_ptr<LeggedRobot> &robot) const {
+    PeriodicGait getPeriodicGait(const std::shared_ptr<LeggedRobot> &robot, const GaitParameters &/*gaitParameters*/, double /*forwardSpeed*/) const override {
         PeriodicGait pg;
         double tOffset = -0.0;
         pg.addSwingPhaseForLimb(robot->getLimbByName("hl"), 0 - tOffset, 0.5 + tOffset);
@@ -45,9 +51,9 @@ class BipedalGaitPlanner : public GaitPlanner {
 public:
     ~BipedalGaitPlanner() override = default;
 
-    PeriodicGait getPeriodicGait(const std::shared_ptr<LeggedRobot> &robot) const {
+    PeriodicGait getPeriodicGait(const std::shared_ptr<LeggedRobot> &robot, const GaitParameters &gaitParameters, double forwardSpeed) const override {
         PeriodicGait pg;
-        double swingPhaseDuration = swingPhaseDurationRelative((targetForwardSpeed_shared != nullptr) ? *targetForwardSpeed_shared : 0.0);
+        double swingPhaseDuration = gaitParameters.getRelativeSwingPhaseDuration(forwardSpeed);
         double offset = (0.5 - swingPhaseDuration) / 2.0;
         double toeOffset = 0.2;
         pg.addSwingPhaseForLimb(robot->getLimbByName("lLowerLeg"), 0 + offset, 0.5 - offset);
@@ -58,7 +64,7 @@ public:
         pg.addSwingPhaseForLimb(robot->getLimbByName("rHand"), -0.5, 0.499);
         pg.addSwingPhaseForLimb(robot->getLimbByName("head"), 0.0, 0.999); // For a non foot limb, we should set the swing phase to 0.0 to 1.0
         pg.addSwingPhaseForLimb(robot->getLimbByName("pelvis"), 0.0, 0.999); // For a non foot limb, we should set the swing phase to 0.0 to 1.0
-        pg.strideDuration = strideDurationInSeconds(*targetForwardSpeed_shared);
+        pg.strideDuration = gaitParameters.getStrideDuration(forwardSpeed);
         return pg;
     }
 };
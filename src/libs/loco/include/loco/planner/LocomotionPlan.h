@@ -0,0 +1,75 @@
+#pragma once
+
+#include <crl-basic/utils/trajectory.h>
+#include <loco/planner/LocomotionTrajectoryPlanner.h>
+
+namespace crl::loco {
+
+/**
+ * A copy of the targets a LocomotionTrajectoryPlanner generated, sampled over
+ * its planning horizon. Plans can be handed from one thread to another, and be
+ * tracked while the planner already works on the next one.
+ */
+class LocomotionPlan {
+public:
+    //counts the plans a planner published, starting from 1 (0: no plan yet)
+    int version = 0;
+    //the sim time the plan was generated at
+    double planGenerationTime = 0;
+
+    //the targets, sampled every dt from planGenerationTime
+    Trajectory3D trunkPositions;
+    Trajectory1D trunkHeadings;
+    //indexed by limbIndex
+    DynamicArray<Trajectory3D> limbPositions;
+
+    double trunkPitch = 0;
+    double trunkRoll = 0;
+    V3D forward = V3D(0, 0, 1);
+
+public:
+    //samples the current targets of the planner, which reuses the storage of
+    //the last plan sampled into this one
+    void sample(LocomotionTrajectoryPlanner& planner, double dt) {
+        planGenerationTime = planner.simTime;
+        trunkPitch = planner.trunkPitch;
+        trunkRoll = planner.trunkRoll;
+        forward = planner.robot->getForward();
+
+        int nSamples = (int)(planner.tPlanningHorizon / dt) + 1;
+        trunkPositions.clear();
+        trunkHeadings.clear();
+        limbPositions.resize(planner.robot->getLimbCount());
+        for (auto& traj : limbPositions)
+            traj.clear();
+
+        for (int k = 0; k < nSamples; k++) {
+            double t = planGenerationTime + k * dt;
+            trunkPositions.addKnot(t, V3D(planner.getTargetTrunkPositionAtTime(t)));
+            trunkHeadings.addKnot(t, planner.getTargetTrunkHeadingAtTime(t));
+            for (uint i = 0; i < limbPositions.size(); i++)
+                limbPositions[i].addKnot(t, V3D(planner.getTargetLimbEEPositionAtTime(planner.robot->getLimb(i), t)));
+        }
+    }
+
+    //how long ago (in sim time) the plan was generated
+    double getAge(double t) const {
+        return t - planGenerationTime;
+    }
+
+    P3D getTargetLimbEEPositionAtTime(const std::shared_ptr<RobotLimb>& l, double t) const {
+        return P3D() + limbPositions[l->limbIndex].evaluate_linear(t);
+    }
+
+    P3D getTargetTrunkPositionAtTime(double t) const {
+        return P3D() + trunkPositions.evaluate_linear(t);
+    }
+
+    //the same as LocomotionTrajectoryPlanner::getTargetTrunkOrientationAtTime
+    Quaternion getTargetTrunkOrientationAtTime(double t) const {
+        return getRotationQuaternion(trunkHeadings.evaluate_linear(t), V3D(0, 1, 0)) * getRotationQuaternion(trunkPitch, RBGlobals::worldUp.cross(forward)) *
+               getRotationQuaternion(trunkRoll, forward);
+    }
+};
+
+}  // namespace crl::loco
@@ -1,15 +1,16 @@
 #pragma once
 
-#include <crl-basic/gui/renderer.h>
+#include <crl-basic/utils/heightField.h>
+#include <crl-basic/utils/logger.h>
 #include <crl-basic/utils/trajectory.h>
 #include <loco/planner/BodyFrame.h>
 #include <loco/planner/FootFallPattern.h>
+#include <loco/planner/GaitParameters.h>
 #include <loco/planner/LocomotionTrajectoryPlanner.h>
 #include <loco/robot/RB.h>
 #include <loco/robot/RBJoint.h>
 #include <loco/robot/RBUtils.h>
 #include "math.h"
-#include <loco/shared/value_share.h>
 
 namespace crl::loco {
 
@@ -55,18 +56,15 @@ public:
     }
 
     /*
-    * constructor: based on limb
+    * constructor: based on limb, and on the gait and forward speed of the character
     */
-    LimbMotionProperties(std::shared_ptr<RobotLimb> limb) {
+    LimbMotionProperties(const std::shared_ptr<RobotLimb>& limb, const GaitParameters& gaitParameters, double forwardSpeed) {
         bool is_leg = limb->name == "lLowerLeg" || limb->name == "rLowerLeg";
         bool is_foot = limb->name == "lToes" || limb->name == "rToes";
         bool is_hand = limb->name == "lHand" || limb->name == "rHand";
         bool is_head = limb->name == "head";
         bool is_pelvis = limb->name == "pelvis";
-        limb->normalizedSpeed = 1.0;
-        if (targetForwardSpeed_shared != NULL){
-            limb->normalizedSpeed = std::clamp(*targetForwardSpeed_shared, 0.0, maxSpeed) / maxSpeed; // We should also allow negative speeds.
-        }
+        limb->normalizedSpeed = gaitParameters.getNormalizedSpeed(forwardSpeed);
         double speed = limb->normalizedSpeed;
             
         if (is_leg) {
@@ -128,7 +126,7 @@ public:
         } else if (is_head) {
             // p: this trajectory should be parameterized...
             double headBop = 0.01;
-            double headLeanForward = speed > (walkToRunTransitionSpeed / maxSpeed) ? speed * 0.3 : 0.0;
+            double headLeanForward = speed > gaitParameters.getNormalizedSpeed(gaitParameters.getWalkToRunTransitionSpeed()) ? speed * 0.3 : 0.0;
             generalSwingTraj.addKnot(0, V3D(0, 0, headLeanForward));
             generalSwingTraj.addKnot(0.125, V3D(0, headBop, headLeanForward));
             generalSwingTraj.addKnot(0.375, V3D(0, -headBop, headLeanForward));
@@ -159,6 +157,9 @@ public:
     P3D contactLocation;
     //we will also add a flag here that tells us if this is a current position (i.e. fixed), or a planned one
     bool isFixed = false;
+    //planned positions depend on the body frame plan, and are provisional if
+    //that was not planned far enough ahead to be final
+    bool isProvisional = false;
     PlannedLimbContact(double tStart, double tEnd, const P3D& pos, bool isFixed = false) {
         this->tStart = tStart;
         this->tEnd = tEnd;
@@ -167,6 +168,32 @@ public:
     }
 };
 
+/**
+        What it takes to continue the trajectory of a foot from its last knot.
+    */
+class FootTrajectoryState {
+public:
+    //the raw position of the foot (i.e. without the swing motion) at the last knot
+    V3D rawEEPos;
+    //swing phases that head for a provisional contact are planned again once the
+    //contact is final. This is the time of the first knot of the earliest such
+    //swing phase (or -1), and the raw position of the foot right before it
+    double tProvisionalSwing = -1;
+    V3D rawEEPosBeforeProvisionalSwing;
+
+    //removes the knots of the swing phase that headed for a provisional contact
+    //(unless it started before the first knot), so the trajectory gets continued
+    //from right before it
+    void discardProvisionalSwing(Trajectory3D& traj) {
+        if (tProvisionalSwing > traj.getKnotPosition(0)) {
+            while (traj.getKnotPosition(traj.getKnotCount() - 1) >= tProvisionalSwing)
+                traj.removeKnot(traj.getKnotCount() - 1);
+            rawEEPos = rawEEPosBeforeProvisionalSwing;
+        }
+        tProvisionalSwing = -1;
+    }
+};
+
 /**
         This class stores a sequence of planned foot falls for each of the robot's limbs.
         Useful bits of information, such as the target stepping location at a particular
@@ -178,110 +205,164 @@ public:
     //Whomever populates the footstep plan should also set the contact plan manager adequately;
     //the two are closely link, as they store complementary information
     ContactPlanManager* cpm = nullptr;
-    std::map<const std::shared_ptr<RobotLimb>, DynamicArray<PlannedLimbContact>> footSteps;
-    crl::gui::SizeableGroundModel ground = crl::gui::SizeableGroundModel(10);
+    //the planned contacts of each limb, indexed by limbIndex
+    DynamicArray<DynamicArray<PlannedLimbContact>> footSteps;
+    //the terrain the steps are planned on. It is shared with the rest of the
+    //planner rather than owned by every plan; if it is not set, the ground is
+    //flat, at height 0
+    std::shared_ptr<const HeightField> ground = nullptr;
+
+    double getGroundHeight(double x, double z) const {
+        return ground != nullptr ? ground->getHeight(x, z) : 0;
+    }
 
     //if the limb is in stance at time t, we'll be returning the current planned
     //position of the contact point; if the limb is in swing at time t, we'll
     //be returning the planned contact position for the end of the swing phase
-    P3D getCurrentOrUpcomingPlannedContactLocation(const std::shared_ptr<RobotLimb>& limb, double t) {
-        for (uint i = 0; i < footSteps[limb].size(); i++) {
-            if (t < footSteps[limb][i].tEnd)
-                return footSteps[limb][i].contactLocation;
-        }
-        return P3D();
+    P3D getCurrentOrUpcomingPlannedContactLocation(const std::shared_ptr<RobotLimb>& limb, double t) const {
+        int i = getIndexOfCurrentOrUpcomingPlannedLimbContact(limb, t);
+        if (i < 0)
+            return P3D();
+        return footSteps[limb->limbIndex][i].contactLocation;
     }
 
     PlannedLimbContact* getCurrentOrUpcomingPlannedLimbContact(const std::shared_ptr<RobotLimb>& limb, double t) {
-        for (uint i = 0; i < footSteps[limb].size(); i++) {
-            if (t < footSteps[limb][i].tEnd)
-                return &footSteps[limb][i];
-        }
-        return nullptr;
+        int i = getIndexOfCurrentOrUpcomingPlannedLimbContact(limb, t);
+        if (i < 0)
+            return nullptr;
+        return &footSteps[limb->limbIndex][i];
     }
 
-    int getIndexOfCurrentOrUpcomingPlannedLimbContact(const std::shared_ptr<RobotLimb>& limb, double t) {
-        for (uint i = 0; i < footSteps[limb].size(); i++) {
-            if (t < footSteps[limb][i].tEnd)
+    int getIndexOfCurrentOrUpcomingPlannedLimbContact(const std::shared_ptr<RobotLimb>& limb, double t) const {
+        if (limb->limbIndex < 0 || limb->limbIndex >= (int)footSteps.size())
+            return -1;
+        const auto& steps = footSteps[limb->limbIndex];
+        for (uint i = 0; i < steps.size(); i++) {
+            if (t < steps[i].tEnd)
                 return i;
         }
 
         return -1;
     }
 
-    Trajectory3D generateNonFootTrajectory(
-        const std::shared_ptr<RobotLimb> limb,
+    //the trajectory is written to traj, which is cleared first: passing the
+    //same one every time the plan is regenerated reuses its storage
+    void generateNonFootTrajectory(
+        const std::shared_ptr<RobotLimb>& limb,
         const LimbMotionProperties& lmp,
         double tStart,
         double tEnd,
         double dt,
-        Trajectory3D bFramePosTrajectory,
-        Trajectory1D bFrameHeadingTrajectory
-    ) {
-        double t = tStart;
+        const Trajectory3D& bFramePosTrajectory,
+        const Trajectory1D& bFrameHeadingTrajectory,
+        Trajectory3D& traj
+    ) const {
         V3D startingEEPos = V3D(limb->getEEWorldPos());
-        Trajectory3D traj;
-        traj.addKnot(t, startingEEPos);
-        t += dt;
-        while (t < tEnd) {
-            double bFrameHeadingAngle = bFrameHeadingTrajectory.evaluate_catmull_rom(t);
-            P3D bFramePos = P3D() + bFramePosTrajectory.evaluate_catmull_rom(t);
+        traj.clear();
+        traj.addKnot(tStart, startingEEPos);
+        extendNonFootTrajectory(limb, lmp, tEnd, dt, bFramePosTrajectory, bFrameHeadingTrajectory, traj);
+    }
+
+    //adds a knot every dt after the last one of traj, up to tEnd. The knots
+    //are the same as if the whole trajectory had been generated at once
+    void extendNonFootTrajectory(
+        const std::shared_ptr<RobotLimb>& limb,
+        const LimbMotionProperties& lmp,
+        double tEnd,
+        double dt,
+        const Trajectory3D& bFramePosTrajectory,
+        const Trajectory1D& bFrameHeadingTrajectory,
+        Trajectory3D& traj
+    ) const {
+        double t = traj.getKnotPosition(traj.getKnotCount() - 1);
+
+        // the body frame trajectories are evaluated at all knots in one pass
+        std::vector<double> ts;
+        for (t += dt; t < tEnd; t += dt)
+            ts.push_back(t);
+        std::vector<double> bFrameHeadingAngles(ts.size());
+        std::vector<V3D> bFramePositions(ts.size());
+        bFrameHeadingTrajectory.evaluate_catmull_rom(ts.data(), bFrameHeadingAngles.data(), (int)ts.size());
+        bFramePosTrajectory.evaluate_catmull_rom(ts.data(), bFramePositions.data(), (int)ts.size());
+
+        traj.reserve(traj.getKnotCount() + (int)ts.size());
+        ContactPhaseCursor cursor = cpm->getCPCursorFor(limb);
+        for (uint i = 0; i < ts.size(); i++) {
+            double bFrameHeadingAngle = bFrameHeadingAngles[i];
+            P3D bFramePos = P3D() + bFramePositions[i];
             V3D defaultEEOffset = limb->defaultEEOffset;
-            ContactPhaseInfo cpiSwing = cpm->getCPInformationFor(limb, t);
+            ContactPhaseInfo cpiSwing = cursor.getContactPhaseInformation(ts[i]);
             P3D pos = bFramePos + 
                 getRotationQuaternion(bFrameHeadingAngle, V3D(0, 1, 0)) * defaultEEOffset + 
                 getRotationQuaternion(bFrameHeadingAngle, V3D(0, 1, 0)) * lmp.generalSwingTraj.evaluate_catmull_rom(cpiSwing.getPercentageOfTimeElapsed());
-            traj.addKnot(t, V3D(pos));
-            t += dt;
+            traj.addKnot(ts[i], V3D(pos));
         }
-        return traj;
     }
 
-    Trajectory3D generateNonFootTrajectory(
-        const std::shared_ptr<LeggedRobot> robot,
+    void generateNonFootTrajectory(
+        const std::shared_ptr<LeggedRobot>& robot,
         int limbIndex,
         const LimbMotionProperties& lmp,
         double tStart,
         double tEnd,
         double dt,
-        Trajectory3D bFramePosTrajectory,
-        Trajectory1D bFrameHeadingTrajectory
-    ) {
-        return generateNonFootTrajectory(robot->getLimb(limbIndex), lmp, tStart, tEnd, dt, bFramePosTrajectory, bFrameHeadingTrajectory);
+        const Trajectory3D& bFramePosTrajectory,
+        const Trajectory1D& bFrameHeadingTrajectory,
+        Trajectory3D& traj
+    ) const {
+        generateNonFootTrajectory(robot->getLimb(limbIndex), lmp, tStart, tEnd, dt, bFramePosTrajectory, bFrameHeadingTrajectory, traj);
     }
 
-    //given world coordinates for the step locations, generate continuous trajectories for each of a robot's feet
-    Trajectory3D generateLimbTrajectory(
-        const std::shared_ptr<LeggedRobot> robot,
+    //given world coordinates for the step locations, generate continuous trajectories for each of a robot's feet.
+    //As for generateNonFootTrajectory, traj is cleared first, and state keeps track of where it can be continued from
+    void generateLimbTrajectory(
+        const std::shared_ptr<LeggedRobot>& robot,
         int limbIndex,
         const LimbMotionProperties& lmp,
         double tStart,
         double tEnd,
         double dt,
-        Trajectory3D bFramePosTrajectory,
-        Trajectory1D bFrameHeadingTrajectory
-    ) {
-        const std::shared_ptr<RobotLimb>& limb = robot->getLimb(limbIndex);
-
-        // Print name of the limb
-        double t = tStart;
-        Trajectory3D traj;
-        Trajectory3D rawTraj; // Displacements are added onto this.
-
+        const Trajectory3D& bFramePosTrajectory,
+        const Trajectory1D& bFrameHeadingTrajectory,
+        Trajectory3D& traj,
+        FootTrajectoryState& state
+    ) const {
         //always start the trajectory from the current location of the robot
-        V3D startingEEPos = V3D(limb->getEEWorldPos());
-        traj.addKnot(t, startingEEPos);
-        rawTraj.addKnot(t, startingEEPos);
+        V3D startingEEPos = V3D(robot->getLimb(limbIndex)->getEEWorldPos());
+        traj.clear();
+        traj.addKnot(tStart, startingEEPos);
+        state = FootTrajectoryState();
+        state.rawEEPos = startingEEPos;
+        extendLimbTrajectory(robot, limbIndex, lmp, tEnd, dt, bFramePosTrajectory, bFrameHeadingTrajectory, traj, state);
+    }
 
-        t += dt;
+    //adds knots every dt after the last one of traj, up to tEnd (swing phases
+    //that have started by then are planned until they end). Swing phases that
+    //head for a provisional contact are remembered in state
+    void extendLimbTrajectory(
+        const std::shared_ptr<LeggedRobot>& robot,
+        int limbIndex,
+        const LimbMotionProperties& lmp,
+        double tEnd,
+        double dt,
+        const Trajectory3D& bFramePosTrajectory,
+        const Trajectory1D& bFrameHeadingTrajectory,
+        Trajectory3D& traj,
+        FootTrajectoryState& state
+    ) const {
+        const std::shared_ptr<RobotLimb>& limb = robot->getLimb(limbIndex);
+
+        // the knots are planned in order, so one cursor serves all the queries
+        ContactPhaseCursor cursor = cpm->getCPCursorFor(limb);
+        double t = traj.getKnotPosition(traj.getKnotCount() - 1) + dt;
         while (t < tEnd) {
-            ContactPhaseInfo cpi = cpm->getCPInformationFor(limb, t);
+            ContactPhaseInfo cpi = cursor.getContactPhaseInformation(t);
             if (cpi.isStance()) {
                 double tEndOfStance = t + cpi.getTimeLeft();
                 // in stance, we want the foot to not slip, while keeping to
                 // the ground...
                 V3D eePos = traj.getKnotValue(traj.getKnotCount() - 1);
-                double groundHeight = ground.getHeight(eePos[0], eePos[2]); //  + offset;
+                double groundHeight = getGroundHeight(eePos[0], eePos[2]); //  + offset;
                 eePos.y() = groundHeight + limb->ee->radius * lmp.contactSafetyFactor;  // account for the size of the ee
                 while (t <= tEndOfStance && t < tEnd) {
                     traj.addKnot(t, eePos);
@@ -292,6 +373,12 @@ public:
 
                 V3D finalEEPos = V3D(getCurrentOrUpcomingPlannedContactLocation(limb, tEndOfSwing));
 
+                int contactIndex = getIndexOfCurrentOrUpcomingPlannedLimbContact(limb, tEndOfSwing);
+                if (contactIndex >= 0 && footSteps[limbIndex][contactIndex].isProvisional && state.tProvisionalSwing < 0) {
+                    state.tProvisionalSwing = t;
+                    state.rawEEPosBeforeProvisionalSwing = state.rawEEPos;
+                }
+
                 // when we first transition to a swing phase (at some time
                 // sample t_i), this could be at the very beginning of it,
                 // or it could have been a "little while ago" and so the
@@ -302,14 +389,14 @@ public:
                 // plan motion for the entire swing phase here to avoid
                 // computing redundant information...
                 while (t <= tEndOfSwing) {
-                    ContactPhaseInfo cpiSwing = cpm->getCPInformationFor(limb, t);
+                    ContactPhaseInfo cpiSwing = cursor.getContactPhaseInformation(t);
 
                     double factor = 1.0;
                     if (firstTimeStepInSwingPhase)
                         factor = (cpi.getDuration() - cpi.getTimeLeft()) / dt;
                     firstTimeStepInSwingPhase = false;
 
-                    V3D oldEEPos = rawTraj.getKnotValue(rawTraj.getKnotCount() - 1);
+                    V3D oldEEPos = state.rawEEPos;
                     // now, we have the remainder of the swing phase to go
                     // from the old step position to the final stepping
                     // location. Based on this we know how much we should be
@@ -322,8 +409,8 @@ public:
 
                     V3D deltaStep = dTimeStep * (finalEEPos - oldEEPos);
                     V3D eePos = oldEEPos + deltaStep;
-                    rawTraj.addKnot(t, V3D(eePos));
-                    double groundHeight = ground.getHeight(eePos[0], eePos[2]);
+                    state.rawEEPos = eePos;
+                    double groundHeight = getGroundHeight(eePos[0], eePos[2]);
                     // add ground height + ee size as offset...
                     double bFrameHeadingAngle = bFrameHeadingTrajectory.evaluate_catmull_rom(t);
                     eePos += getRotationQuaternion(bFrameHeadingAngle, V3D(0, 1, 0)) * lmp.generalSwingTraj.evaluate_catmull_rom(cpiSwing.getPercentageOfTimeElapsed());
@@ -334,8 +421,6 @@ public:
                 }
             }
         }
-
-        return traj;
     }
 };
 
@@ -351,29 +436,32 @@ private:
     //3: heading
     typedef Eigen::Matrix<double, 4, 1> bFrameState;
 
-    void generate(const bFrameState& startingbFrameState, FootstepPlan fsp) {
-        double headingAngle = startingbFrameState[3];
-        P3D pos(startingbFrameState[0], startingbFrameState[1], startingbFrameState[2]);
-        double vForward = std::clamp(targetForwardSpeed, 0.0, maxSpeed);
+    //the body frame state reached at tNext, from which the trajectories are
+    //continued when they get extended
+    bFrameState nextState;
+    double tNext = 0;
+    //except for the very first plan, the body frame follows the planned
+    //motion of the pelvis
+    bool followsPelvis = false;
+
+    //integrates the motion of the body frame from nextState, adding knots up to tEnd
+    void integrate() {
+        double headingAngle = nextState[3];
+        P3D pos(nextState[0], nextState[1], nextState[2]);
+        double vForward = std::clamp(targetForwardSpeed, 0.0, gaitParameters->getMaxSpeed());
         double vSideways = targetSidewaysSpeed;
         double turningSpeed = targetTurngingSpeed;
 
-        bFramePosTrajectory.clear();
-        bFrameHeadingTrajectory.clear();
-        bFrameVels.clear();
-
-        double t = tStart;
-
         // generate trajectories that capture the motion of the robot's body frame...
-        while (t < tEnd) {
+        while (tNext < tEnd) {
             Quaternion heading = getRotationQuaternion(headingAngle, V3D(0, 1, 0));
 
-            bFramePosTrajectory.addKnot(t, V3D(pos));
-            bFrameHeadingTrajectory.addKnot(t, headingAngle);
+            bFramePosTrajectory.addKnot(tNext, V3D(pos));
+            bFrameHeadingTrajectory.addKnot(tNext, headingAngle);
 
-            bFrameVels.addKnot(t, V3D(vForward, vSideways, turningSpeed));
+            bFrameVels.addKnot(tNext, V3D(vForward, vSideways, turningSpeed));
 
-            vForward = std::clamp(targetForwardSpeed, 0.0, maxSpeed);
+            vForward = std::clamp(targetForwardSpeed, 0.0, gaitParameters->getMaxSpeed());
             vSideways = targetSidewaysSpeed;
             turningSpeed = targetTurngingSpeed;
 
@@ -391,24 +479,106 @@ private:
             Matrix rot = Eigen::AngleAxisd(headingAngle, Eigen::Vector3d::UnitY()).toRotationMatrix();
 
             //calculate new position and angle
-            pos.y = targetbFrameHeight + ground.getHeight(pos.x, pos.z);
+            pos.y = targetbFrameHeight + (ground != nullptr ? ground->getHeight(pos.x, pos.z) : 0);
             pos = pos + dt * (rot * V3D(0, 0, 1) * vForward + rot * RBGlobals::worldUp.cross(V3D(0, 0, 1)) * vSideways);
             headingAngle = headingAngle + dt * turningSpeed;
 
-            t += dt;
+            tNext += dt;
         }
 
+        nextState << pos.x, pos.y, pos.z, headingAngle;
+    }
+
+    //overwrites the body frame positions from knot firstKnot onwards with the motion of the pelvis
+    void followPelvis(int firstKnot) {
+        for (int i = firstKnot; i < displacement.getKnotCount(); i++) {
+            bFramePosTrajectory.setKnotValue(i, displacement.getKnotValue(i));
+        }
+    }
+
+    void generate(const bFrameState& startingbFrameState, const FootstepPlan& fsp) {
+        bFramePosTrajectory.clear();
+        bFrameHeadingTrajectory.clear();
+        bFrameVels.clear();
+
+        nextState = startingbFrameState;
+        tNext = tStart;
+        integrate();
 
-        LimbMotionProperties pelvisLmProps = LimbMotionProperties(robot->getLimbByName("pelvis"));
-        if (tStart > 0.001) {
-            Trajectory3D displacement = fsp.generateNonFootTrajectory(robot->getLimbByName("pelvis"), pelvisLmProps, tStart, tEnd, dt, bFramePosTrajectory, bFrameHeadingTrajectory);
+        LimbMotionProperties pelvisLmProps = LimbMotionProperties(robot->getLimbByName("pelvis"), *gaitParameters, targetForwardSpeed);
+        followsPelvis = tStart > 0.001;
+        if (followsPelvis) {
+            fsp.generateNonFootTrajectory(robot->getLimbByName("pelvis"), pelvisLmProps, tStart, tEnd, dt, bFramePosTrajectory, bFrameHeadingTrajectory, displacement);
 
             // Add the displacement trajectory to the bFrame trajectory per knot
-            for (int i = 0; i < displacement.getKnotCount(); i++) {
-                bFramePosTrajectory.setKnotValue(i, displacement.getKnotValue(i));
+            followPelvis(0);
+        }
+    }
+
+    //plans the contacts of a limb that is in swing at time t, up to tEnd
+    void appendFootsteps(DynamicArray<PlannedLimbContact>& footSteps, const std::shared_ptr<RobotLimb>& limb, const LimbMotionProperties& lmProps, const ContactPlanManager* cpm, double t) {
+        double tTiny = 0.0001;
+        ContactPhaseCursor cursor = cpm->getCPCursorFor(limb);
+        while (t < tEnd) {
+            ContactPhaseInfo cpiSwing = cursor.getContactPhaseInformation(t);
+            //when we get here, at time t, the foot is in swing, so find the start of the next contact phase
+            if (cpiSwing.isSwing() == false) {
+                Logger::consolePrint(
+                    "ERROR, ERROR, at this point the limb should be in "
+                    "swing, but isn't");
+                assert(cpiSwing.isStance());
+            }
+
+            t += cpiSwing.getTimeLeft();
+            ContactPhaseInfo cpiStance = cursor.getContactPhaseInformation(t + tTiny);
+            if (cpiStance.isStance() == false) {
+                Logger::consolePrint(
+                    "ERROR, ERROR, at this point the limb should be in "
+                    "stance, but isn't");
+                assert(cpiStance.isSwing());
             }
 
+            double tStart = t;
+            double tEnd = tStart + cpiStance.getDuration();
+            t = tEnd + tTiny;
+
+            //this is the moment in time where we'd like the limb to be right under its hip
+            limb->normalizedSpeed = gaitParameters->getNormalizedSpeed(targetForwardSpeed);
+            double speed = limb->normalizedSpeed;
+            double tMidStance = tStart + cpiStance.getDuration() * (lmProps.ffStancePhaseForDefaultStepLength - 0.1 * speed);
+            //so, compute the location of the body frame at that particular moment in time...
+            double bFrameHeadingAngle = bFrameHeadingTrajectory.evaluate_catmull_rom(tMidStance);
+            P3D bFramePos = P3D() + bFramePosTrajectory.evaluate_catmull_rom(tMidStance);
+
+            V3D defaultEEOffset = limb->defaultEEOffset;
+            defaultEEOffset[0] *= lmProps.stepWidthOffsetX;
+            defaultEEOffset[2] *= lmProps.stepWidthOffsetZ;
+
+            P3D pos = bFramePos + getRotationQuaternion(bFrameHeadingAngle, V3D(0, 1, 0)) * defaultEEOffset;
+
+            pos.y = limb->ee->radius * lmProps.contactSafetyFactor;  // account for the size of the ee
+
+            footSteps.push_back(PlannedLimbContact(tStart, tEnd, pos, false));
+            //the body frame is interpolated with slopes estimated from the knots around it, so
+            //it is final up to the second to last knot
+            int nKnots = bFramePosTrajectory.getKnotCount();
+            footSteps.back().isProvisional = nKnots < 2 || tMidStance >= bFramePosTrajectory.getKnotPosition(nKnots - 2);
+        }
+    }
+
+    //plans the contacts of a limb from tStart, starting with the one it is in now, if it is in stance
+    void populateFootstepsForLimb(DynamicArray<PlannedLimbContact>& footSteps, const std::shared_ptr<RobotLimb>& limb, const LimbMotionProperties& lmProps, const ContactPlanManager* cpm, double groundHeight) {
+        double tTiny = 0.0001;
+        footSteps.clear();
+        ContactPhaseInfo cpi = cpm->getCPInformationFor(limb, tStart);
+        double t = tStart;
+        if (cpi.isStance()) {
+            P3D pos = limb->getEEWorldPos();
+            pos.y = groundHeight + limb->ee->radius * lmProps.contactSafetyFactor;  // account for the size of the ee
+            footSteps.push_back(PlannedLimbContact(tStart, tStart + cpi.getTimeLeft(), pos, true));
+            t = tStart + cpi.getTimeLeft() + tTiny;
         }
+        appendFootsteps(footSteps, limb, lmProps, cpm, t);
     }
 
 public:
@@ -425,7 +595,11 @@ public:
 
     //and the robot we apply this to
     std::shared_ptr<LeggedRobot> robot = nullptr;
-    crl::gui::SizeableGroundModel ground = crl::gui::SizeableGroundModel(10);
+    //the terrain the robot walks on (flat, at height 0, if not set), shared
+    //with the footstep plan
+    std::shared_ptr<const HeightField> ground = nullptr;
+    //how the gait of the robot changes with its speed
+    std::shared_ptr<const GaitParameters> gaitParameters = nullptr;
 
     bFrameReferenceMotionPlan(const std::shared_ptr<LeggedRobot>& robot) {
         this->robot = robot;
@@ -438,6 +612,11 @@ public:
     //and the profile of turning, forward and sideways velocities that were used
     Trajectory3D bFrameVels;
 
+private:
+    //the motion of the pelvis about the body frame, kept between calls to generate to reuse its storage
+    Trajectory3D displacement;
+
+public:
     bFrameState getBFrameStateFromRBState(const RBState& rbState) {
         bFrameState s;
         BodyFrame bFrame(rbState.pos, rbState.orientation);
@@ -473,69 +652,64 @@ public:
     }
 
     //generate the bFrame reference trajectory starting from the current state of the robot's trunk...
-    void generateTrajectory(FootstepPlan fsp) {
+    void generateTrajectory(const FootstepPlan& fsp) {
         generate(getInitialConditionsFromCurrentTrunkState(), fsp);
     }
 
+    //continues the trajectories from where the last call to generateTrajectory or extendTrajectory left
+    //them, up to tEnd. The trajectories are the same as if they had been generated at once
+    void extendTrajectory(const FootstepPlan& fsp) {
+        int nKnots = bFramePosTrajectory.getKnotCount();
+        integrate();
+
+        if (followsPelvis) {
+            LimbMotionProperties pelvisLmProps = LimbMotionProperties(robot->getLimbByName("pelvis"), *gaitParameters, targetForwardSpeed);
+            fsp.extendNonFootTrajectory(robot->getLimbByName("pelvis"), pelvisLmProps, tEnd, dt, bFramePosTrajectory, bFrameHeadingTrajectory, displacement);
+            followPelvis(nKnots);
+        }
+    }
+
+    //drops the knots that are no longer needed to evaluate the trajectories from time t onwards
+    void removeKnotsBefore(double t) {
+        bFramePosTrajectory.removeKnotsBefore(t);
+        bFrameHeadingTrajectory.removeKnotsBefore(t);
+        bFrameVels.removeKnotsBefore(t);
+        if (followsPelvis)
+            displacement.removeKnotsBefore(t);
+    }
+
     void populateFootstepPlan(FootstepPlan& fsp, const LimbMotionProperties& lmProps, ContactPlanManager* cpm, double groundHeight = 0) {
         fsp.cpm = cpm;
-        double tTiny = 0.0001;
+        fsp.footSteps.resize(robot->getLimbCount());
         for (uint i = 0; i < robot->getLimbCount(); i++) {
             const auto& limb = robot->getLimb(i);
-            fsp.footSteps[limb].clear();
-            ContactPhaseInfo cpi = cpm->getCPInformationFor(limb, tStart);
-            double t = tStart;
-            if (cpi.isStance()) {
-                P3D pos = limb->getEEWorldPos();
-                pos.y = groundHeight + limb->ee->radius * lmProps.contactSafetyFactor;  // account for the size of the ee
-                fsp.footSteps[limb].push_back(PlannedLimbContact(tStart, tStart + cpi.getTimeLeft(), pos, true));
-                t = tStart + cpi.getTimeLeft() + tTiny;
-            }
-
-            while (t < tEnd) {
-                ContactPhaseInfo cpiSwing = cpm->getCPInformationFor(limb, t);
-                //when we get here, at time t, the foot is in swing, so find the start of the next contact phase
-                if (cpiSwing.isSwing() == false) {
-                    Logger::consolePrint(
-                        "ERROR, ERROR, at this point the limb should be in "
-                        "swing, but isn't");
-                    assert(cpiSwing.isStance());
-                }
-
-                t += cpiSwing.getTimeLeft();
-                ContactPhaseInfo cpiStance = cpm->getCPInformationFor(limb, t + tTiny);
-                if (cpiStance.isStance() == false) {
-                    Logger::consolePrint(
-                        "ERROR, ERROR, at this point the limb should be in "
-                        "stance, but isn't");
-                    assert(cpiStance.isSwing());
-                }
-
-                double tStart = t;
-                double tEnd = tStart + cpiStance.getDuration();
-                t = tEnd + tTiny;
+            populateFootstepsForLimb(fsp.footSteps[limb->limbIndex], limb, lmProps, cpm, groundHeight);
+        }
+    }
 
-                //this is the moment in time where we'd like the limb to be right under its hip
-                limb->normalizedSpeed = 1.0;
-                if (targetForwardSpeed_shared != NULL){
-                    limb->normalizedSpeed = std::clamp(*targetForwardSpeed_shared, 0.0, maxSpeed) / maxSpeed; // We should also allow negative speeds.
+    //drops the contacts that ended before tStart, as well as the provisional ones, and plans
+    //the ones that follow the last remaining contact of each limb, up to tEnd
+    void extendFootstepPlan(FootstepPlan& fsp, const LimbMotionProperties& lmProps, double groundHeight = 0) {
+        double tTiny = 0.0001;
+        fsp.footSteps.resize(robot->getLimbCount());
+        for (uint i = 0; i < robot->getLimbCount(); i++) {
+            const auto& limb = robot->getLimb(i);
+            auto& footSteps = fsp.footSteps[limb->limbIndex];
+            uint nPast = 0;
+            while (nPast < footSteps.size() && footSteps[nPast].tEnd < tStart)
+                nPast++;
+            footSteps.erase(footSteps.begin(), footSteps.begin() + nPast);
+            for (uint j = 0; j < footSteps.size(); j++) {
+                if (footSteps[j].isProvisional) {
+                    footSteps.erase(footSteps.begin() + j, footSteps.end());
+                    break;
                 }
-                double speed = limb->normalizedSpeed;
-                double tMidStance = tStart + cpiStance.getDuration() * (lmProps.ffStancePhaseForDefaultStepLength - 0.1 * speed);
-                //so, compute the location of the body frame at that particular moment in time...
-                double bFrameHeadingAngle = bFrameHeadingTrajectory.evaluate_catmull_rom(tMidStance);
-                P3D bFramePos = P3D() + bFramePosTrajectory.evaluate_catmull_rom(tMidStance);
-
-                V3D defaultEEOffset = limb->defaultEEOffset;
-                defaultEEOffset[0] *= lmProps.stepWidthOffsetX;
-                defaultEEOffset[2] *= lmProps.stepWidthOffsetZ;
-
-                P3D pos = bFramePos + getRotationQuaternion(bFrameHeadingAngle, V3D(0, 1, 0)) * defaultEEOffset;
-
-                pos.y = limb->ee->radius * lmProps.contactSafetyFactor;  // account for the size of the ee
-
-                fsp.footSteps[limb].push_back(PlannedLimbContact(tStart, tEnd, pos, false));
             }
+
+            if (footSteps.empty())
+                populateFootstepsForLimb(footSteps, limb, lmProps, fsp.cpm, groundHeight);
+            else
+                appendFootsteps(footSteps, limb, lmProps, fsp.cpm, footSteps.back().tEnd + tTiny);
         }
     }
 };
@@ -1,8 +1,9 @@
 #pragma once
 
-#include <crl-basic/gui/renderer.h>
 #include <crl-basic/utils/trajectory.h>
 #include <loco/planner/FootFallPattern.h>
+#include <loco/planner/GaitParameters.h>
+#include <loco/planner/GaitPlanner.h>
 #include <loco/robot/LeggedRobot.h>
 #include <loco/robot/RB.h>
 #include <loco/robot/RBJoint.h>
@@ -48,6 +49,10 @@ public:
 
     double targetStepHeight = 1.0;
 
+    //how the gait changes with the speed. Characters that walk alike can share
+    //their parameters
+    std::shared_ptr<const GaitParameters> gaitParameters = std::make_shared<GaitParameters>();
+
 public:
     /**
      * constructor
@@ -72,6 +77,13 @@ public:
             appendPeriodicGait(p);
     }
 
+    //the same, with the periodic gait gaitPlanner picks for the robot at its
+    //target speed, which is only computed if it is needed
+    void appendPeriodicGaitIfNeeded(const GaitPlanner& gaitPlanner) {
+        if (cpm.timeUntilEndOfPlanningHorizon(simTime) < tPlanningHorizon + tPlanningHorizonBuffer)
+            appendPeriodicGaitIfNeeded(gaitPlanner.getPeriodicGait(robot, *gaitParameters, speedForward));
+    }
+
     virtual void appendPeriodicGait(const PeriodicGait& p) {
         // and add the footfall pattern to the timeline...
         cpm.appendPeriodicGaitToPlanningHorizon(p);
@@ -81,12 +93,6 @@ public:
         return cpm.getCPInformationFor(l, t);
     }
 
-    void visualizeContactSchedule(double gridStartTime = -1, double dt_grid = 1 / 30.0, int nGridSteps = 30) {
-        cpm.visualizeContactSchedule(simTime, gridStartTime, dt_grid, nGridSteps);
-    }
-
-    virtual void visualizeParameters() {}
-
     virtual void generateTrajectoriesFromCurrentState(double dt = 1 / 30.0) = 0;
 
     virtual void refineCurrentMPCTrajectory() {}
@@ -122,8 +128,6 @@ public:
     virtual V3D getTargetTrunkAngularVelocityAtTime(double t, double dt = 1 / 30.0) {
         return estimateAngularVelocity(getTargetTrunkOrientationAtTime(t), getTargetTrunkOrientationAtTime(t + dt), dt);
     }
-
-    virtual void drawTrajectories(gui::Shader* shader) {}
 };
 
 }  // namespace crl::loco
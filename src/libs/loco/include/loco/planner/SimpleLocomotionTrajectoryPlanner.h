@@ -1,6 +1,6 @@
 #pragma once
 
-#include <crl-basic/gui/renderer.h>
+#include <crl-basic/utils/threadPool.h>
 #include <crl-basic/utils/trajectory.h>
 #include <loco/planner/BodyFrame.h>
 #include <loco/planner/FootFallPattern.h>
@@ -9,9 +9,9 @@
 #include <loco/robot/RB.h>
 #include <loco/robot/RBJoint.h>
 #include <loco/robot/RBUtils.h>
-#include <map>
 
-#include <loco/shared/value_share.h>
+
+#include <tuple>
 
 namespace crl::loco {
 
@@ -34,21 +34,94 @@ namespace crl::loco {
 class SimpleLocomotionTrajectoryPlanner : public LocomotionTrajectoryPlanner {
 protected:
 
-    //store cartesian trajectories for each foot
-    std::map<const shared_ptr<RobotLimb>, Trajectory3D> limbTrajectories;
+    //store cartesian trajectories for each foot, indexed by limbIndex
+    DynamicArray<Trajectory3D> limbTrajectories;
 
     //store reference trajectory for the robot's body frame
     bFrameReferenceMotionPlan bFrameMotionPlan;
 
     // TODO: Define different limbproperties for each limb
-    std::map<const shared_ptr<RobotLimb>, LimbMotionProperties> lmProps;
+    // (indexed by limbIndex)
+    DynamicArray<LimbMotionProperties> lmProps;
     
     FootstepPlan fsp;
 
     //assumption is that walking happens on flat ground here
     double groundHeight = 0;
 
+    //where the trajectory of each foot can be continued from, indexed by limbIndex
+    DynamicArray<FootTrajectoryState> footTrajectoryStates;
+
+    //everything the plan depends on, other than the state of the robot it starts from
+    struct PlanTargets {
+        double speedForward = 0, speedSideways = 0, turningSpeed = 0;
+        double trunkHeight = 0, stepWidthModifier = 0, targetStepHeight = 0;
+        double tPlanningHorizon = 0, tPlanningHorizonBuffer = 0, dt = 0, groundHeight = 0;
+        //the ground may be rebaked in place, so its version counts as well
+        const HeightField* ground = nullptr;
+        int groundVersion = 0;
+        const GaitParameters* gaitParameters = nullptr;
+        int contactScheduleChangeCount = -1;
+
+        bool operator==(const PlanTargets& other) const {
+            return std::tie(speedForward, speedSideways, turningSpeed, trunkHeight, stepWidthModifier, targetStepHeight, tPlanningHorizon,
+                            tPlanningHorizonBuffer, dt, groundHeight, ground, groundVersion, gaitParameters,
+                            contactScheduleChangeCount) ==
+                   std::tie(other.speedForward, other.speedSideways, other.turningSpeed, other.trunkHeight, other.stepWidthModifier,
+                            other.targetStepHeight, other.tPlanningHorizon, other.tPlanningHorizonBuffer, other.dt, other.groundHeight,
+                            other.ground, other.groundVersion, other.gaitParameters, other.contactScheduleChangeCount);
+        }
+    };
+
+    //the targets the current plan was generated for
+    PlanTargets plannedTargets;
+
+    //the number of knots of the body frame and limb trajectories that were computed the last time the plan was generated
+    int recomputedKnotCount = 0;
+
+    PlanTargets getPlanTargets(double dt) const {
+        PlanTargets targets;
+        targets.speedForward = speedForward;
+        targets.speedSideways = speedSideways;
+        targets.turningSpeed = turningSpeed;
+        targets.trunkHeight = trunkHeight;
+        targets.stepWidthModifier = stepWidthModifier;
+        targets.targetStepHeight = targetStepHeight;
+        targets.tPlanningHorizon = tPlanningHorizon;
+        targets.tPlanningHorizonBuffer = tPlanningHorizonBuffer;
+        targets.dt = dt;
+        targets.groundHeight = groundHeight;
+        targets.ground = fsp.ground.get();
+        targets.groundVersion = fsp.ground != nullptr ? fsp.ground->getVersion() : 0;
+        targets.gaitParameters = gaitParameters.get();
+        targets.contactScheduleChangeCount = cpm.cs.getChangeCount();
+        return targets;
+    }
+
+    //true if the current plan starts at or before time t, and goes on past it
+    bool planCovers(double t) const {
+        const Trajectory3D& bFramePos = bFrameMotionPlan.bFramePosTrajectory;
+        if (bFramePos.getKnotCount() == 0 || bFramePos.getKnotPosition(0) > t || bFramePos.getKnotPosition(bFramePos.getKnotCount() - 1) <= t)
+            return false;
+        if (limbTrajectories.size() != robot->getLimbCount())
+            return false;
+        for (const auto& traj : limbTrajectories)
+            if (traj.getKnotCount() == 0 || traj.getKnotPosition(0) > t)
+                return false;
+        return true;
+    }
+
 public:
+    //if set, the trajectories of the limbs are generated in parallel on this
+    //pool (which can be shared with other planners). The trajectories are the
+    //same as when they are generated one limb after the other
+    std::shared_ptr<ThreadPool> threadPool = nullptr;
+
+    //if set, the plan is only extended to the end of the new planning horizon
+    //as long as the targets and the contact schedule stay the same: the part of
+    //the horizon that was planned already is kept, rather than planned again
+    //from the current state of the robot
+    bool incrementalReplanning = false;
 
     /**
     * constructor
@@ -57,6 +130,15 @@ public:
         generateTrajectoriesFromCurrentState();
     }
 
+    //sets the terrain to plan for, which the footstep plan and the body frame
+    //plan share (e.g. the height field of the ground model the app draws). If it
+    //is not set, the ground is flat, at height 0. If it is rebaked in place, the
+    //next plan is generated from scratch, as for any other change of targets
+    void setGround(const std::shared_ptr<const HeightField>& ground) {
+        fsp.ground = ground;
+        bFrameMotionPlan.ground = ground;
+    }
+
     void initializeMotionPlan(double dt) {
         //set properties/targets needed to generate body frame motion trajectory
         bFrameMotionPlan.dt = dt;
@@ -66,9 +148,7 @@ public:
         bFrameMotionPlan.targetTurngingSpeed = turningSpeed;
         bFrameMotionPlan.tStart = simTime;
         bFrameMotionPlan.tEnd = simTime + tPlanningHorizon + tPlanningHorizonBuffer;
-
-        //our external initialization
-        targetForwardSpeed_shared = &(bFrameMotionPlan.targetForwardSpeed);
+        bFrameMotionPlan.gaitParameters = gaitParameters;
 
         // lmProps.stepWidthOffsetX = stepWidthModifier;
         // lmProps.swingFootHeight = targetStepHeight;
@@ -80,66 +160,164 @@ public:
     }
 
     void generateLimbProperties() {
+        lmProps.resize(robot->getLimbCount());
         for (uint i = 0; i < robot->getLimbCount(); i++) {
-            lmProps[robot->getLimb(i)] = LimbMotionProperties(robot->getLimb(i));
-            lmProps[robot->getLimb(i)].stepWidthOffsetX = stepWidthModifier;
-            lmProps[robot->getLimb(i)].swingFootHeight = targetStepHeight;
+            lmProps[i] = LimbMotionProperties(robot->getLimb(i), *gaitParameters, bFrameMotionPlan.targetForwardSpeed);
+            lmProps[i].stepWidthOffsetX = stepWidthModifier;
+            lmProps[i].swingFootHeight = targetStepHeight;
         }
     }
 
     void generateSteppingLocations() {
         // and the contact locations for the limbs
         // No clue which leg we should actually use here. Also no clue why this is called on bFrameMotionPlan.
-        bFrameMotionPlan.populateFootstepPlan(fsp, lmProps[robot->getLimbByName("lLowerLeg")], &cpm, groundHeight);
+        bFrameMotionPlan.populateFootstepPlan(fsp, lmProps[robot->getLimbByName("lLowerLeg")->limbIndex], &cpm, groundHeight);
+    }
+
+    bool isFoot(int limbIndex) const {
+        const std::string& name = robot->getLimb(limbIndex)->name;
+        return name == "lLowerLeg" || 
+            name == "rLowerLeg" || 
+            name == "lToes" || 
+            name == "rToes";
+    }
+
+    void generateLimbTrajectory(int limbIndex, double dt) {
+        if (!isFoot(limbIndex)) {
+            fsp.generateNonFootTrajectory(
+                robot,
+                limbIndex,
+                lmProps[limbIndex],
+                simTime,
+                simTime + tPlanningHorizon,
+                dt,
+                bFrameMotionPlan.bFramePosTrajectory,
+                bFrameMotionPlan.bFrameHeadingTrajectory,
+                limbTrajectories[limbIndex]
+            );
+        } else {
+            fsp.generateLimbTrajectory(
+                robot,
+                limbIndex,
+                lmProps[limbIndex],
+                simTime,
+                simTime + tPlanningHorizon,
+                dt,
+                bFrameMotionPlan.bFramePosTrajectory,
+                bFrameMotionPlan.bFrameHeadingTrajectory,
+                limbTrajectories[limbIndex],
+                footTrajectoryStates[limbIndex]
+            );
+        }
+    }
+
+    void extendLimbTrajectory(int limbIndex, double dt) {
+        if (!isFoot(limbIndex)) {
+            fsp.extendNonFootTrajectory(
+                robot->getLimb(limbIndex),
+                lmProps[limbIndex],
+                simTime + tPlanningHorizon,
+                dt,
+                bFrameMotionPlan.bFramePosTrajectory,
+                bFrameMotionPlan.bFrameHeadingTrajectory,
+                limbTrajectories[limbIndex]
+            );
+        } else {
+            fsp.extendLimbTrajectory(
+                robot,
+                limbIndex,
+                lmProps[limbIndex],
+                simTime + tPlanningHorizon,
+                dt,
+                bFrameMotionPlan.bFramePosTrajectory,
+                bFrameMotionPlan.bFrameHeadingTrajectory,
+                limbTrajectories[limbIndex],
+                footTrajectoryStates[limbIndex]
+            );
+        }
+    }
+
+    //every limb only reads the plans made so far, and writes its own trajectory
+    void forEachLimb(const std::function<void(int)>& f) {
+        if (threadPool != nullptr) {
+            threadPool->parallelFor(robot->getLimbCount(), f);
+        } else {
+            for (uint i = 0; i < robot->getLimbCount(); i++)
+                f(i);
+        }
+    }
+
+    //samples the contact schedule on the grid of knot times that starts at
+    //tStart, so the limbs look their contact phases up rather than search for them
+    void sampleContactTimeline(double tStart, double dt) {
+        cpm.getTimeline(tStart, dt, (int)((tPlanningHorizon + tPlanningHorizonBuffer) / dt) + 1);
     }
 
     void generateLimbTrajectories(double dt) {
         //and full motion trajectories for each limb
+        limbTrajectories.resize(robot->getLimbCount());
+        footTrajectoryStates.resize(robot->getLimbCount());
+        sampleContactTimeline(simTime, dt);
+        forEachLimb([&](int i) { generateLimbTrajectory(i, dt); });
+    }
+
+    int getKnotCount() const {
+        int nKnots = bFrameMotionPlan.bFramePosTrajectory.getKnotCount();
+        for (const auto& traj : limbTrajectories)
+            nKnots += traj.getKnotCount();
+        return nKnots;
+    }
+
+    //drops the part of the plan that is over, and plans the part of the horizon that is new
+    void extendTrajectories(double dt) {
+        bFrameMotionPlan.removeKnotsBefore(simTime);
         for (uint i = 0; i < robot->getLimbCount(); i++) {
-            std::shared_ptr<RobotLimb> limb = robot->getLimb(i);
-            bool isFoot = limb->name == "lLowerLeg" || 
-                limb->name == "rLowerLeg" || 
-                limb->name == "lToes" || 
-                limb->name == "rToes";
-            if (!isFoot) {
-                limbTrajectories[limb] = fsp.generateNonFootTrajectory(
-                    robot,
-                    i,
-                    lmProps[limb],
-                    simTime,
-                    simTime + tPlanningHorizon,
-                    dt,
-                    bFrameMotionPlan.bFramePosTrajectory,
-                    bFrameMotionPlan.bFrameHeadingTrajectory
-                );
-            } else {
-                limbTrajectories[limb] = fsp.generateLimbTrajectory(
-                    robot,
-                    i,
-                    lmProps[limb],
-                    simTime,
-                    simTime + tPlanningHorizon,
-                    dt,
-                    bFrameMotionPlan.bFramePosTrajectory,
-                    bFrameMotionPlan.bFrameHeadingTrajectory
-                );
-            }
+            limbTrajectories[i].removeKnotsBefore(simTime);
+            if (isFoot(i))
+                footTrajectoryStates[i].discardProvisionalSwing(limbTrajectories[i]);
         }
+        int nKnots = getKnotCount();
+
+        bFrameMotionPlan.extendTrajectory(fsp);
+        bFrameMotionPlan.extendFootstepPlan(fsp, lmProps[robot->getLimbByName("lLowerLeg")->limbIndex], groundHeight);
+        //the knots that are left are on the grid of the plan they came from
+        sampleContactTimeline(limbTrajectories[0].getKnotPosition(0), dt);
+        forEachLimb([&](int i) { extendLimbTrajectory(i, dt); });
+
+        recomputedKnotCount = getKnotCount() - nKnots;
     }
 
     virtual void generateTrajectoriesFromCurrentState(double dt = 1 / 30.0) {
-        generateLimbProperties();
         initializeMotionPlan(dt);
 
+        PlanTargets targets = getPlanTargets(dt);
+        if (incrementalReplanning && targets == plannedTargets && planCovers(simTime)) {
+            extendTrajectories(dt);
+            return;
+        }
+        plannedTargets = targets;
+
+        //the limb properties depend on the gait and on the target speed
+        generateLimbProperties();
+
         generateBFrameTrajectory();
 
         generateSteppingLocations();
 
         generateLimbTrajectories(dt);
+
+        recomputedKnotCount = getKnotCount();
+    }
+
+    //the number of trajectory knots (of the body frame and of all limbs) that
+    //were computed the last time the plan was generated. With incremental
+    //replanning, this is usually only the knots that were added at the end
+    int getRecomputedKnotCount() const {
+        return recomputedKnotCount;
     }
 
     virtual P3D getTargetLimbEEPositionAtTime(const std::shared_ptr<RobotLimb>& l, double t) {
-        return P3D() + limbTrajectories[l].evaluate_linear(t);
+        return P3D() + limbTrajectories[l->limbIndex].evaluate_linear(t);
     }
 
     virtual P3D getTargetTrunkPositionAtTime(double t) {
@@ -154,15 +332,6 @@ public:
         return getRotationQuaternion(getTargetTrunkHeadingAtTime(t), V3D(0, 1, 0)) *
                getRotationQuaternion(trunkPitch, RBGlobals::worldUp.cross(robot->getForward())) * getRotationQuaternion(trunkRoll, robot->getForward());
     }
-
-    virtual void drawTrajectories(gui::Shader* shader) {
-        for (int i = 0; i < bFrameMotionPlan.bFramePosTrajectory.getKnotCount(); i++)
-            drawSphere(P3D() + bFrameMotionPlan.bFramePosTrajectory.getKnotValue(i), 0.02, *shader);
-
-        for (uint i = 0; i < robot->getLimbCount(); i++)
-            for (int j = 0; j < limbTrajectories[robot->getLimb(i)].getKnotCount(); j++)
-                drawSphere(P3D() + limbTrajectories[robot->getLimb(i)].getKnotValue(j), 0.01, *shader, V3D(1, 1, 0));
-    }
 };
 
 }  // namespace crl::loco
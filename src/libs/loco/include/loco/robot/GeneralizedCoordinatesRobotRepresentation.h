@@ -38,6 +38,81 @@ private:
     // and velocities
     dVector q, qDot;
 
+    // world-relative quantities for every dof, updated whenever q changes so
+    // that queries do not need to walk up the hierarchy (see
+    // updateWorldTransforms). Positions are relative to the root's position,
+    // so they do not change when only the root translates.
+    // the orientation induced by the dof and all of its ancestors
+    std::vector<Quaternion> worldRotationForQ;
+    // the rotation axis of the dof, in world coordinates
+    std::vector<V3D> worldAxisForQ;
+    // the location of the dof's pivot (i.e. its joint), in world coordinates
+    std::vector<V3D> worldPivotForQ;
+    // dofs whose world transforms are out of date
+    std::vector<char> worldTransformDirty;
+
+    // scratch space used to sync with the robot's state, kept around so that
+    // syncing does not allocate
+    mutable RobotState reducedState;
+    std::vector<V3D> worldRelJointVelocities;
+
+    // per-dof scratch space for the recursive dynamics algorithms (see
+    // computeMassMatrixCRBA and computeInverseDynamicsRNEA). All spatial
+    // quantities are expressed in world coordinates, about the root's
+    // position.
+    struct DofDynamics {
+        // inertia of the rigid bodies moved by the dof (composite inertia in
+        // CRBA, or only the rigid body it carries in RNEA): mass, first moment
+        // of mass and moment of inertia
+        double mass = 0;
+        V3D firstMoment = V3D(0, 0, 0);
+        Matrix3x3 MoI = Matrix3x3::Zero();
+        // spatial velocity and acceleration of the dof's frame
+        V3D angularVelocity = V3D(0, 0, 0), linearVelocity = V3D(0, 0, 0);
+        V3D angularAcceleration = V3D(0, 0, 0), linearAcceleration = V3D(0, 0, 0);
+        // spatial force transmitted through the dof
+        V3D torque = V3D(0, 0, 0), force = V3D(0, 0, 0);
+    };
+    mutable std::vector<DofDynamics> dofDynamics;
+
+    /**
+     * recomputes the world transforms of the dofs flagged in
+     * worldTransformDirty, starting at firstIndex, and those of all their
+     * descendants. Parent dofs always have lower indices than their children,
+     * so one pass in index order is enough.
+     */
+    void updateWorldTransforms(int firstIndex);
+
+    /**
+     * sets q(qIndex), and updates the world transforms of the dofs it moves
+     */
+    void setQVal(int qIndex, double val);
+
+    /**
+     * shared implementation of the batched jacobians: dRdq is optional
+     */
+    void computeJacobiansForPoints(const std::vector<std::shared_ptr<const RB>> &rbs, const std::vector<P3D> &points, Matrix &dpdq, Matrix *dRdq) const;
+
+    /**
+     * sets the inertia of every dof in dofDynamics to that of the rigid body
+     * it carries, if any
+     */
+    void setDofInertiasFromRigidBodies() const;
+
+    /**
+     * shared implementation of the recursive Newton-Euler algorithm: qDDot is
+     * optional (zero if null)
+     */
+    void computeRNEA(const dVector *qDDot, bool includeGravity, dVector &generalizedForces) const;
+
+    /**
+     * the world coordinates of a point of rb, given relative to rb's pivot
+     * (i.e. location of the parent joint)
+     */
+    inline P3D getWorldCoordinatesFromPivot(const V3D &offset, int qStartIndex) const {
+        return P3D(q[0], q[1], q[2]) + worldPivotForQ[qStartIndex] + worldRotationForQ[qStartIndex] * offset;
+    }
+
 public:
     /** the constructor */
     GeneralizedCoordinatesRobotRepresentation(const std::shared_ptr<Robot> &a);
@@ -226,6 +301,20 @@ public:
      */
     void compute_angular_jacobian(const std::shared_ptr<const RB> &rb, Matrix &dRdq) const;
 
+    /**
+     * computes the jacobians of many points at once (e.g. all end effectors,
+     * or the COMs of all rigid bodies): rows 3i to 3i+2 of dpdq hold dp/dq for
+     * point points[i], expressed in the local coordinates of rbs[i]. All
+     * jacobians are read off the same per-dof world axes and pivots.
+     */
+    void compute_dpdq(const std::vector<std::shared_ptr<const RB>> &rbs, const std::vector<P3D> &points, Matrix &dpdq) const;
+
+    /**
+     * same as above, but also computes the angular jacobians of the rigid
+     * bodies: rows 3i to 3i+2 of dRdq hold the angular jacobian of rbs[i].
+     */
+    void compute_jacobians(const std::vector<std::shared_ptr<const RB>> &rbs, const std::vector<P3D> &points, Matrix &dpdq, Matrix &dRdq) const;
+
     /**
      * estimates the angular jacobian using finite differences
      */
@@ -284,6 +373,28 @@ public:
      */
     void computeCoriolisAndCentrifugalForcesTerm(dVector &C) const;
 
+    /**
+     * computes the mass matrix for the whole robot with the composite rigid
+     * body algorithm. Same result as computeMassMatrix, but the cost grows
+     * with |q| times the depth of the hierarchy, rather than with |q|^2 times
+     * the number of rigid bodies
+     */
+    void computeMassMatrixCRBA(Matrix &massMatrix) const;
+
+    /**
+     * computes the generalized forces needed to accelerate the robot with
+     * qDDot, given the current q and qDot: M(q) qDDot + C(q, qDot) qDot + g(q),
+     * with the recursive Newton-Euler algorithm in O(|q|)
+     */
+    void computeInverseDynamicsRNEA(const dVector &qDDot, dVector &generalizedForces, bool includeGravity = true) const;
+
+    /**
+     * computes the bias forces C(q, qDot) qDot + g(q) (i.e. the generalized
+     * forces for zero acceleration) with the recursive Newton-Euler algorithm.
+     * Without gravity, same result as computeCoriolisAndCentrifugalForcesTerm
+     */
+    void computeBiasForcesRNEA(dVector &biasForces, bool includeGravity = true) const;
+
     /**
      * returns the qIndex at which this joint starts
      */
@@ -297,6 +408,13 @@ public:
         return jointIndexForQ[QIndex];
     }
 
+    /**
+     * returns the index of the hierarchical parent of q(qIndex), or -1 for q(0)
+     */
+    inline int getParentQIndex(int qIndex) const {
+        return qParentIndex[qIndex];
+    }
+
     inline std::shared_ptr<RBJoint> getJointForQ(int QIndex) {
         return robot->jointList[getJointIndexForQ(QIndex)];
     }
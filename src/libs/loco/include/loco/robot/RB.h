@@ -6,6 +6,7 @@
 #include "loco/robot/RBJoint.h"
 #include "loco/robot/RBProperties.h"
 #include "loco/robot/RBState.h"
+#include "loco/robot/RBStateStore.h"
 #include "loco/robot/RBUtils.h"
 
 namespace crl::loco {
@@ -29,9 +30,11 @@ public:
     std::string name;
 
 private:
-    // state of the rigid body
+    // state of the rigid body, which lives in a store that it shares with
+    // the other bodies of its robot (a store of its own until then)
     // this should be safe. always modify state with getter/setter.
-    RBState state;
+    std::shared_ptr<RBStateStore> stateStore = std::make_shared<RBStateStore>(1);
+    int stateId = 0;
 
 public:
     /**
@@ -44,6 +47,31 @@ public:
      */
     virtual ~RB() = default;
 
+    // a copy would share its state with the original
+    RB(const RB &) = delete;
+    RB &operator=(const RB &) = delete;
+
+    /**
+     * moves the state of the rigid body into the given store, where it has
+     * the given id, and keeps it there from now on
+     */
+    void moveStateTo(const std::shared_ptr<RBStateStore> &store, int id) {
+        store->setState(id, getState());
+        stateStore = store;
+        stateId = id;
+    }
+
+    /**
+     * the store the state of the rigid body lives in, and its id there
+     */
+    inline const std::shared_ptr<RBStateStore> &getStateStore() const {
+        return stateStore;
+    }
+
+    inline int getStateId() const {
+        return stateId;
+    }
+
     /**
      *  returns the world coords moment of inertia of the rigid body.
      */
@@ -55,9 +83,11 @@ public:
     Matrix3x3 getWorldMOI(const V3D &v) const;
 
     /**
-     *  returns true if it is hit, false otherwise.
+     *  returns true if the abstract (skeleton) view of the rigid body is hit,
+     *  false otherwise. Its meshes are cast rays at where they are drawn (see
+     *  locoGui's RBRenderer)
      */
-    bool getRayIntersectionPoint(const Ray &ray, P3D &intersectionPoint, bool checkMeshes, bool checkSkeleton);
+    bool getRayIntersectionPoint(const Ray &ray, P3D &intersectionPoint) const;
 
     /**
      * This method returns the coordinates of the point that is passed in as a
@@ -65,7 +95,7 @@ public:
      */
     inline P3D getWorldCoordinates(const P3D &pLocal = P3D()) const {
         // pWorld = pos + R * V3D(origin, pLocal)
-        return state.pos + state.orientation * V3D(pLocal);
+        return stateStore->positions[stateId] + stateStore->orientations[stateId] * V3D(pLocal);
     }
 
     /**
@@ -75,7 +105,7 @@ public:
     inline V3D getWorldCoordinates(const V3D &vLocal) const {
         // the rigid body's orientation is a unit quaternion. Using this, we can
         // obtain the global coordinates of a local vector
-        return state.orientation * vLocal;
+        return stateStore->orientations[stateId] * vLocal;
     }
 
     /**
@@ -83,7 +113,7 @@ public:
      * passed in as a parameter (expressed in global coordinates)
      */
     inline P3D getLocalCoordinates(const P3D &pWorld) {
-        return P3D() + state.orientation.inverse() * (V3D(state.pos, pWorld));
+        return P3D() + stateStore->orientations[stateId].inverse() * (V3D(stateStore->positions[stateId], pWorld));
     }
 
     /**
@@ -93,7 +123,7 @@ public:
     inline V3D getLocalCoordinates(const V3D &vWorld) {
         // the rigid body's orientation is a unit quaternion. Using this, we can
         // obtain the global coordinates of a local vector
-        return state.orientation.inverse() * vWorld;
+        return stateStore->orientations[stateId].inverse() * vWorld;
     }
 
     /**
@@ -108,7 +138,7 @@ public:
         // the velocity is given by omega x r + v. omega and v are already
         // expressed in world coordinates, so we need to express r in world
         // coordinates first.
-        return state.angularVelocity.cross(getWorldCoordinates(r)) + state.velocity;
+        return stateStore->angularVelocities[stateId].cross(getWorldCoordinates(r)) + stateStore->velocities[stateId];
     }
 
     /**
@@ -119,40 +149,41 @@ public:
     inline V3D getVelocityForPoint_global(const P3D &pWorld) const {
         // we need to compute the vector r, from the origin of the body to the
         // point of interest
-        V3D r(state.pos, pWorld);
+        V3D r(stateStore->positions[stateId], pWorld);
         // the velocity is given by omega x r + v. omega and v are already
         // expressed in world coordinates, so we need to express r in world
         // coordinates first.
-        return state.angularVelocity.cross(r) + state.velocity;
+        return stateStore->angularVelocities[stateId].cross(r) + stateStore->velocities[stateId];
     }
 
     inline Quaternion getOrientation() const {
-        return state.orientation;
+        return stateStore->orientations[stateId];
     }
 
     inline V3D getAngularVelocity() const {
-        return state.angularVelocity;
+        return stateStore->angularVelocities[stateId];
     }
 
-    inline const RBState &getState() const {
-        return state;
+    inline RBState getState() const {
+        return stateStore->getState(stateId);
     }
 
     inline void setPosition(const P3D &pWorld) {
-        state.pos = pWorld;
+        stateStore->positions[stateId] = pWorld;
     }
 
     inline void setOrientation(const Quaternion &q) {
-        state.orientation = q;
-        state.orientation.normalize();
+        Quaternion &orientation = stateStore->orientations[stateId];
+        orientation = q;
+        orientation.normalize();
     }
 
     inline void setVelocity(const V3D &vWorld) {
-        state.velocity = vWorld;
+        stateStore->velocities[stateId] = vWorld;
     }
 
     inline void setAngularVelocity(const V3D &wWorld) {
-        state.angularVelocity = wWorld;
+        stateStore->angularVelocities[stateId] = wWorld;
     }
 };
 
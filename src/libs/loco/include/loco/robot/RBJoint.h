@@ -7,6 +7,7 @@
 #include <string>
 
 #include "loco/robot/RB.h"
+#include "loco/robot/RBStateStore.h"
 
 namespace crl::loco {
 
@@ -105,6 +106,14 @@ public:
      */
     void fixJointConstraints(bool fixPositions, bool fixOrientations, bool fixLinVelocities, bool fixAngularVelocities);
 
+    /**
+     * the same, for the parent and the child in state p of parentStates and
+     * state c of childStates, for kernels that run over the states of all
+     * the joints of a robot (see Robot::forEachJoint)
+     */
+    void fixJointConstraints(const RBStateStore &parentStates, int p, RBStateStore &childStates, int c, bool fixPositions, bool fixOrientations,
+                             bool fixLinVelocities, bool fixAngularVelocities) const;
+
     /**
      * this value ranges from -pi to pi
      */
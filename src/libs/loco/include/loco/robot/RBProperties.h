@@ -1,6 +1,5 @@
 #pragma once
 
-#include <crl-basic/gui/model.h>
 #include <crl-basic/utils/mathUtils.h>
 
 #include <memory>
@@ -8,22 +7,21 @@
 namespace crl::loco {
 
 /**
- * This class holds gui model (mesh)
+ * This class describes a mesh that visualizes a rigid body. The mesh itself
+ * is only loaded where it is drawn (see locoGui's RBRenderer)
  */
-class RB3DModel : public crl::gui::Model {
+class RB3DModel {
 public:
     RB3DModel() {}
 
-    RB3DModel(const std::string& path) : path(path) {
-        loadModel(path);
-    }
-
-    ~RB3DModel() override = default;
+    RB3DModel(const std::string& path) : path(path) {}
 
     RigidTransformation localT;
     std::string description;
     std::string path;
     V3D color = V3D(0.9, 0.9, 0.9);
+    // scale about the x, y, and z axes, applied before localT
+    V3D scale = V3D(1, 1, 1);
 };
 
 /**
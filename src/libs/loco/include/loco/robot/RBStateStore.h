@@ -0,0 +1,117 @@
+#pragma once
+
+#include <new>
+#include <vector>
+
+#include "loco/robot/RBState.h"
+
+namespace crl::loco {
+
+/**
+ * Allocates arrays that start on a cache line of their own.
+ */
+template <typename T>
+struct CacheAlignedAllocator {
+    typedef T value_type;
+
+    static constexpr std::size_t alignment = 64;
+
+    CacheAlignedAllocator() = default;
+
+    template <typename U>
+    CacheAlignedAllocator(const CacheAlignedAllocator<U> &) {}
+
+    T *allocate(std::size_t n) {
+        return static_cast<T *>(::operator new(n * sizeof(T), std::align_val_t(alignment)));
+    }
+
+    void deallocate(T *p, std::size_t) {
+        ::operator delete(p, std::align_val_t(alignment));
+    }
+
+    template <typename U>
+    bool operator==(const CacheAlignedAllocator<U> &) const {
+        return true;
+    }
+
+    template <typename U>
+    bool operator!=(const CacheAlignedAllocator<U> &) const {
+        return false;
+    }
+};
+
+template <typename T>
+using CacheAlignedArray = std::vector<T, CacheAlignedAllocator<T>>;
+
+/**
+ * The states of a set of rigid bodies (e.g. all the bodies of a robot),
+ * stored as a structure of arrays: the positions, orientations, velocities
+ * and angular velocities of all the bodies each lie in one contiguous,
+ * cache aligned array, indexed by body id. Rigid bodies are views into a
+ * store (see RB), and kernels that update or read the states of all of them
+ * run through these arrays directly, rather than from one body to the next
+ * across the heap.
+ */
+class RBStateStore {
+public:
+    // indexed by body id, all of them getBodyCount() long
+    CacheAlignedArray<P3D> positions;
+    CacheAlignedArray<Quaternion> orientations;
+    CacheAlignedArray<V3D> velocities;
+    CacheAlignedArray<V3D> angularVelocities;
+
+public:
+    explicit RBStateStore(int nBodies = 0) {
+        for (int i = 0; i < nBodies; i++)
+            addBody();
+    }
+
+    int getBodyCount() const {
+        return (int)positions.size();
+    }
+
+    /**
+     * adds a body in the given state, and returns its id
+     */
+    int addBody(const RBState &state = RBState()) {
+        positions.push_back(state.pos);
+        orientations.push_back(state.orientation);
+        velocities.push_back(state.velocity);
+        angularVelocities.push_back(state.angularVelocity);
+        return getBodyCount() - 1;
+    }
+
+    RBState getState(int id) const {
+        RBState state;
+        state.pos = positions[id];
+        state.orientation = orientations[id];
+        state.velocity = velocities[id];
+        state.angularVelocity = angularVelocities[id];
+        return state;
+    }
+
+    void setState(int id, const RBState &state) {
+        positions[id] = state.pos;
+        orientations[id] = state.orientation;
+        velocities[id] = state.velocity;
+        angularVelocities[id] = state.angularVelocity;
+    }
+
+    /**
+     * calls f(id, position, orientation, velocity, angularVelocity) for every
+     * body, in the order of their ids
+     */
+    template <typename F>
+    void forEachBody(F &&f) {
+        for (int i = 0; i < getBodyCount(); i++)
+            f(i, positions[i], orientations[i], velocities[i], angularVelocities[i]);
+    }
+
+    template <typename F>
+    void forEachBody(F &&f) const {
+        for (int i = 0; i < getBodyCount(); i++)
+            f(i, positions[i], orientations[i], velocities[i], angularVelocities[i]);
+    }
+};
+
+}  // namespace crl::loco
@@ -4,7 +4,6 @@
 
 #include "loco/robot/RB.h"
 #include "loco/robot/RBJoint.h"
-#include "loco/robot/RBRenderer.h"
 #include "loco/robot/RBUtils.h"
 #include "loco/robot/RobotState.h"
 
@@ -36,6 +35,10 @@ protected:
     // keep lists of all the joints and all the RBs of the robot, for easy access
     std::vector<std::shared_ptr<RBJoint>> jointList;
     std::vector<std::shared_ptr<RB>> rbList;
+    // the states of all the RBs, in the order of rbList
+    std::shared_ptr<RBStateStore> stateStore = nullptr;
+    // for every joint, the id of the state of its parent
+    std::vector<int> jointParentStateIds;
 
     //useful to know which way is "forward" for this robot.
     V3D forward = V3D(0, 0, 1);
@@ -85,7 +88,7 @@ public:
         return jointList[i];
     }
 
-    inline int getRigidBodyCount() {
+    inline int getRigidBodyCount() const {
         return (int)jointList.size() + 1;
     }
 
@@ -93,7 +96,7 @@ public:
      * returns a pointer to the ith rigid body of the virtual robot, where the
      * root is at 0, and the rest follow afterwards...
      */
-    inline std::shared_ptr<RB> getRigidBody(int i) {
+    inline std::shared_ptr<RB> getRigidBody(int i) const {
         if (i == 0)
             return root;
         if (i <= (int)jointList.size())
@@ -101,6 +104,26 @@ public:
         return nullptr;
     }
 
+    /**
+     * returns the store that holds the states of all the rigid bodies, where
+     * the id of each one is its index for getRigidBody
+     */
+    inline const std::shared_ptr<RBStateStore> &getStateStore() const {
+        return stateStore;
+    }
+
+    /**
+     * calls f(joint, parentId, childId) for every joint, parents before
+     * children, with the ids of the states of the parent and the child in the
+     * state store. Kernels that update or read the states of all the bodies
+     * work on the store directly, without going through the RBs
+     */
+    template <typename F>
+    void forEachJoint(F &&f) const {
+        for (uint j = 0; j < jointList.size(); j++)
+            f(*jointList[j], jointParentStateIds[j], (int)j + 1);
+    }
+
     /**
      * this method is used to return the current heading of the robot
      */
@@ -217,35 +240,9 @@ public:
      */
     std::shared_ptr<RB> getRBByName(const char *jName);
 
-    /**
-     * returns NULL if no RBs are hit by the ray...
-     */
-    std::shared_ptr<RB> getFirstRBHitByRay(const Ray &ray, P3D &intersectionPoint, bool checkMeshes, bool checkSkeleton) {
-        std::shared_ptr<RB> selectedRB = nullptr;
-        double t = DBL_MAX;
-        P3D tmpIntersectionPoint = P3D(0, 0, 0);
-
-        for (uint i = 0; i < rbList.size(); i++) {
-            if (rbList[i]->getRayIntersectionPoint(ray, tmpIntersectionPoint, checkMeshes, checkSkeleton)) {
-                double tTmp = ray.getRayParameterFor(tmpIntersectionPoint);
-                if (tTmp < t) {
-                    selectedRB = rbList[i];
-                    t = tTmp;
-                    intersectionPoint = tmpIntersectionPoint;
-                }
-            }
-        }
-        return selectedRB;
-    }
-
     V3D getForward() const {
         return forward;
     }
-
-    /**
-     * draws the robot at its current state
-     */
-    void draw(const gui::Shader &rbShader, float alpha = 1.0);
 };
 
 }  // namespace crl::loco
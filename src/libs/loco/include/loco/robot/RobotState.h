@@ -33,6 +33,8 @@ public:
 
     RobotState(const RobotState &other);
 
+    RobotState &operator=(const RobotState &other) = default;
+
     RobotState(int jCount = 0, int aJCount = 0);
 
     RobotState(const Robot &robot, bool useDefaultAngles = false);
@@ -120,6 +122,13 @@ public:
 
     bool operator==(const RobotState &other) const;
 
+    /**
+     * returns the state a fraction t (in [0, 1]) of the way from a to b:
+     * positions and velocities are interpolated linearly, orientations
+     * spherically. Both states must have the same number of joints.
+     */
+    static RobotState interpolate(const RobotState &a, const RobotState &b, double t);
+
     void writeToFile(const char *fName);
 
     void readFromFile(const char *fName);
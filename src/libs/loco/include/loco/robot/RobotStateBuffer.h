@@ -0,0 +1,65 @@
+#pragma once
+
+#include <crl-basic/utils/tripleBuffer.h>
+
+#include "loco/robot/RobotState.h"
+
+namespace crl::loco {
+
+/**
+ * Hands the states of a robot that is simulated on one thread to a thread
+ * that draws it (e.g. a copy of the robot), without locks. After every step,
+ * the simulation publishes the state of its robot, and the drawing thread
+ * picks up the latest complete one. The simulated robot itself is never read
+ * by the drawing thread, so frames are never drawn from a state that is only
+ * partly updated.
+ *
+ * Only one thread may publish, and only one may pick up states. Every
+ * published value holds the last two states, so that the drawing thread can
+ * draw the robot in between them.
+ */
+class RobotStateBuffer {
+public:
+    struct Snapshot {
+        RobotState previous;
+        RobotState current;
+        // the number of states published so far, this one included
+        long version = 0;
+    };
+
+public:
+    /**
+     * simulation thread: publishes the state the robot is in
+     */
+    void publish(const Robot &robot);
+
+    /**
+     * drawing thread: picks up the latest published state, if there is one
+     * the drawing thread does not have yet. Returns true if there was
+     */
+    bool update() {
+        return snapshots.update();
+    }
+
+    /**
+     * drawing thread: the states picked up by the last call to update
+     */
+    const Snapshot &getSnapshot() const {
+        return snapshots.getFrontBuffer();
+    }
+
+    /**
+     * drawing thread: sets the robot to the state a fraction t (in [0, 1])
+     * of the way from the state before the latest one to the latest one.
+     * Does nothing if no state was picked up yet
+     */
+    void apply(Robot &robot, double t) const;
+
+private:
+    TripleBuffer<Snapshot> snapshots;
+    // owned by the simulation thread
+    RobotState latest;
+    long nPublished = 0;
+};
+
+}  // namespace crl::loco
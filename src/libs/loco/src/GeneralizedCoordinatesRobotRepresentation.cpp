@@ -4,14 +4,11 @@
 
 namespace crl::loco {
 
-// TODO: for this implementation, we have chosen not to precompute any
-// quantities (e.g. world coords of joints or joint axes, position/orientations
-// of RBs, etc), trading speed in favor of a conceptually clean implementation.
-// If ever the need will arise, things like RB orientations, positions and
-// rotation axes of joints, etc can be precomputed as soon as the q's get set,
-// which presumably will make things faster, but it will also make this class
-// more difficult to work with as things would always need to be kept in sync
-// properly...
+// NOTE: the world orientation, rotation axis and pivot location of every dof
+// are precomputed whenever the q's get set (see updateWorldTransforms), so
+// that positions, orientations and jacobians can be read off without walking
+// up the hierarchy. Every change of q must therefore go through setQ (or
+// setQVal), which only updates the subtrees below the dofs that changed.
 
 GeneralizedCoordinatesRobotRepresentation::GeneralizedCoordinatesRobotRepresentation(const std::shared_ptr<Robot> &a) {
     robot = a;
@@ -58,6 +55,46 @@ void GeneralizedCoordinatesRobotRepresentation::setupGeneralizedCoordinatesStruc
 
     resize(q, nTotalDim);
     resize(qDot, nTotalDim);
+
+    worldRotationForQ.assign(nTotalDim, Quaternion::Identity());
+    worldAxisForQ.assign(nTotalDim, V3D(0, 0, 0));
+    worldPivotForQ.assign(nTotalDim, V3D(0, 0, 0));
+    worldTransformDirty.assign(nTotalDim, 1);
+    dofDynamics.assign(nTotalDim, DofDynamics());
+    updateWorldTransforms(0);
+}
+
+void GeneralizedCoordinatesRobotRepresentation::updateWorldTransforms(int firstIndex) {
+    for (int qIndex = firstIndex; qIndex < (int)q.size(); qIndex++) {
+        int qIndexParent = qParentIndex[qIndex];
+        if (!worldTransformDirty[qIndex] && (qIndexParent < 0 || !worldTransformDirty[qIndexParent]))
+            continue;
+        worldTransformDirty[qIndex] = 1;
+
+        // 2 here is the index of the first translational DOF of the root --
+        // these dofs do not contribute to the orientation of the rigid bodies,
+        // and the pivots are relative to the position of the root
+        if (qIndexParent > 2) {
+            worldRotationForQ[qIndex] = worldRotationForQ[qIndexParent] * getRelOrientationForQ(qIndex);
+            worldPivotForQ[qIndex] = worldPivotForQ[qIndexParent] + worldRotationForQ[qIndexParent] * getOffsetFromParentToQ(qIndex);
+        } else {
+            worldRotationForQ[qIndex] = getRelOrientationForQ(qIndex);
+            worldPivotForQ[qIndex] = V3D(0, 0, 0);
+        }
+        worldAxisForQ[qIndex] = worldRotationForQ[qIndex] * getQAxis(qIndex);
+    }
+
+    for (int qIndex = firstIndex; qIndex < (int)q.size(); qIndex++)
+        worldTransformDirty[qIndex] = 0;
+}
+
+void GeneralizedCoordinatesRobotRepresentation::setQVal(int qIndex, double val) {
+    q[qIndex] = val;
+    // the translational dofs of the root do not move any of the pivots
+    if (qIndex > 2) {
+        worldTransformDirty[qIndex] = 1;
+        updateWorldTransforms(qIndex);
+    }
 }
 
 // returns the qIndex at which this joint starts
@@ -73,7 +110,8 @@ void GeneralizedCoordinatesRobotRepresentation::integrateGenerlizedAccelerations
 // updates q and qDot given current state of robot
 void GeneralizedCoordinatesRobotRepresentation::syncGeneralizedCoordinatesWithRobotState() {
     // write out the position of the root...
-    RobotState state(*robot);
+    robot->populateState(reducedState);
+    const RobotState &state = reducedState;
     P3D pos = state.getPosition();
     Quaternion orientation = state.getOrientation();
 
@@ -97,13 +135,15 @@ void GeneralizedCoordinatesRobotRepresentation::syncGeneralizedCoordinatesWithRo
         // printf("joint %d: err %15.15lf\n", i,
         // Qerr.angularDistance(Quaternion::Identity()));
     }
+    std::fill(worldTransformDirty.begin(), worldTransformDirty.end(), 1);
+    updateWorldTransforms(0);
 
     // now update the velocities qDot
-    std::vector<V3D> worldRelJointVelocities;
+    worldRelJointVelocities.resize(robot->jointList.size());
     for (uint i = 0; i < robot->jointList.size(); i++)
         // the reduced state stores angular velocities in parent coords, so
         // change them to world
-        worldRelJointVelocities.push_back(getOrientationFor(robot->jointList[i]->parent) * (state.getJointRelativeAngVelocity(i)));
+        worldRelJointVelocities[i] = getOrientationFor(robot->jointList[i]->parent) * (state.getJointRelativeAngVelocity(i));
 
     projectWorldCoordsValuesIntoGeneralizedSpace(state.getVelocity(), state.getAngularVelocity(), worldRelJointVelocities, qDot);
 }
@@ -152,9 +192,10 @@ P3D GeneralizedCoordinatesRobotRepresentation::getPivotPointLocalPosition(const
 }
 
 void GeneralizedCoordinatesRobotRepresentation::syncRobotStateWithGeneralizedCoordinates() const {
-    RobotState rs(*robot);
-    getReducedRobotState(rs);
-    robot->setState(rs);
+    // getReducedRobotState overwrites everything but the joint count
+    reducedState.setJointCount((int)robot->jointList.size());
+    getReducedRobotState(reducedState);
+    robot->setState(reducedState);
 }
 
 // given the current state of the generalized representation, output the reduced
@@ -196,7 +237,16 @@ void GeneralizedCoordinatesRobotRepresentation::setQ(const dVector &qNew) {
     // NOTE: we don't update the angular velocities. The assumption is that the
     // correct behavior is that the joint relative angular velocities don't
     // change, although the world relative values of the rotations do
+    int firstChanged = (int)q.size();
+    // the translational dofs of the root do not move any of the pivots
+    for (int i = 3; i < (int)q.size(); i++) {
+        if (q[i] != qNew[i]) {
+            worldTransformDirty[i] = 1;
+            firstChanged = std::min(firstChanged, i);
+        }
+    }
     q = qNew;
+    updateWorldTransforms(firstChanged);
 }
 
 // gets the current q values
@@ -311,37 +361,16 @@ void GeneralizedCoordinatesRobotRepresentation::projectWorldCoordsValuesIntoGene
 // coordinates of rb (relative to its COM): p(q)
 P3D GeneralizedCoordinatesRobotRepresentation::getWorldCoordinates(const P3D &p, const std::shared_ptr<const RB> &rb) const {
     V3D offset(p);
-    int qIndex = getQStartIndexForRB(rb);
-
     if (rb->pJoint != nullptr)
         offset = V3D(rb->pJoint->cJPos, p);
 
-    // 2 here is the index of the first translational DOF of the root
-    while (qIndex > 2) {
-        V3D qAxis = getQAxis(qIndex);
-        V3D offsetRot = rotateVec(offset, q[qIndex], qAxis);
-        V3D offsetFromParent = getOffsetFromParentToQ(qIndex);
-        offset = offsetFromParent + offsetRot;
-        qIndex = qParentIndex[qIndex];
-    }
-
-    return P3D() + V3D(getQAxis(0) * q[0] + getQAxis(1) * q[1] + getQAxis(2) * q[2] + offset);
+    return getWorldCoordinatesFromPivot(offset, getQStartIndexForRB(rb));
 }
 
 // returns the world coordinates for vector b, which is specified in the local
 // coordinates of rb: v(q)
 V3D GeneralizedCoordinatesRobotRepresentation::getWorldCoordinates(const V3D &v, const std::shared_ptr<const RB> &rb) const {
-    V3D theVector(v);
-    int qIndex = getQStartIndexForRB(rb);
-
-    // 2 here is the index of the first translational DOF of the root
-    while (qIndex > 2) {
-        V3D qAxis = getQAxis(qIndex);
-        theVector = rotateVec(theVector, q[qIndex], qAxis);
-        qIndex = qParentIndex[qIndex];
-    }
-
-    return theVector;
+    return worldRotationForQ[getQStartIndexForRB(rb)] * v;
 }
 
 // returns the velocity (world coordinates) of the point p, which is specified
@@ -370,14 +399,7 @@ V3D GeneralizedCoordinatesRobotRepresentation::getAngularVelocityFor(const std::
 
 // returns the global orientation associated with a specific dof q...
 Quaternion GeneralizedCoordinatesRobotRepresentation::getWorldRotationForQ(int qIndex) const {
-    Quaternion qRes = Quaternion::Identity();
-    // 2 here is the index of the first translational DOF of the root -- these
-    // dofs do not contribute to the orientation of the rigid bodies...
-    while (qIndex > 2) {
-        qRes = getRelOrientationForQ(qIndex) * qRes;
-        qIndex = qParentIndex[qIndex];
-    }
-    return qRes;
+    return worldRotationForQ[qIndex];
 }
 
 Quaternion GeneralizedCoordinatesRobotRepresentation::getRelOrientationForQ(int qIndex) const {
@@ -386,12 +408,8 @@ Quaternion GeneralizedCoordinatesRobotRepresentation::getRelOrientationForQ(int
     return getRotationQuaternion(q[qIndex], getQAxis(qIndex));
 }
 
-// this is a somewhat slow function to use if we must iterate through multiple
-// rigid bodies...
 V3D GeneralizedCoordinatesRobotRepresentation::getWorldCoordsAxisForQ(int qIndex) const {
-    if (qIndex < 3)
-        return getQAxis(qIndex);
-    return getWorldRotationForQ(qIndex) * getQAxis(qIndex);
+    return worldAxisForQ[qIndex];
 }
 
 // returns the world-relative orientation for rb
@@ -418,49 +436,22 @@ Quaternion GeneralizedCoordinatesRobotRepresentation::getOrientationFor(const st
 // change with q. p is expressed in the local coordinates of rb
 void GeneralizedCoordinatesRobotRepresentation::compute_dpdq(const P3D &p, const std::shared_ptr<const RB> &rb, Matrix &dpdq) const {
     resize(dpdq, 3, q.size());
-    dpdq.fill(0);
 
-    // todo: this bit of code (and other jacobians/higher order derivatives) can
-    // probably be made faster if ever they become the bottleneck... seems like
-    // it would be easy enough to precompute orientations/joint
-    // positions/offsets in a first pass from the bottom up, instead of always
-    // recomputing them for each j... after all, we know that dpdq_i is the
-    // cross product of the vector from pos of q_i to p (all in world coords)
-    // with the rotation axis of q_i (in world coords)...
+    V3D offset(p);
+    if (rb->pJoint != nullptr)
+        offset = V3D(rb->pJoint->cJPos, p);
 
     int startIndex = getQStartIndexForRB(rb);
+    // p, relative to the position of the root (like the pivots)
+    V3D pRel = worldPivotForQ[startIndex] + worldRotationForQ[startIndex] * offset;
 
-    int loopIndex = startIndex;
+    // rotating about q moves p about the world coordinates axis of q, through
+    // the pivot of q
+    int qIndex = startIndex;
     // 2 here is the index of the first translational DOF of the root
-    while (loopIndex > 2) {
-        V3D offset(p);
-        if (rb->pJoint != nullptr)
-            offset = V3D(rb->pJoint->cJPos, p);
-        int qIndex = startIndex;
-
-        // compute the offset from the location of joint qIndex to point p - if
-        // these quantitites were known in world coordinates, then it would be
-        // clear we wouldn't need the loop
-        while (qIndex > loopIndex) {
-            offset = getOffsetFromParentToQ(qIndex) + rotateVec(offset, q[qIndex], getQAxis(qIndex));
-            qIndex = qParentIndex[qIndex];
-        }
-
-        // this is how the vector computed above changes with the rotation angle
-        offset = getQAxis(qIndex).cross(offset);
-
-        // and now bring this vector to world coordinates, since the step above
-        // was computed in the coordinate frame of joint q. again, if RB
-        // orientations were precomputed, we could just read it off now...
-        while (qIndex > 2) {
-            offset = rotateVec(offset, q[qIndex], getQAxis(qIndex));
-            qIndex = qParentIndex[qIndex];
-        }
-
-        for (int i = 0; i < 3; i++)
-            dpdq(i, loopIndex) = offset[i];
-
-        loopIndex = qParentIndex[loopIndex];
+    while (qIndex > 2) {
+        dpdq.col(qIndex) = worldAxisForQ[qIndex].cross(V3D(pRel - worldPivotForQ[qIndex]));
+        qIndex = qParentIndex[qIndex];
     }
 
     dpdq(0, 0) = 1;
@@ -472,32 +463,15 @@ void GeneralizedCoordinatesRobotRepresentation::compute_dpdq(const P3D &p, const
 // change with q. p is expressed in the local coordinates of rb
 void GeneralizedCoordinatesRobotRepresentation::compute_dvdq(const V3D &v, const std::shared_ptr<const RB> &rb, Matrix &dvdq) const {
     resize(dvdq, 3, q.size());
-    dvdq.fill(0);
 
     int startIndex = getQStartIndexForRB(rb);
+    V3D vWorld = worldRotationForQ[startIndex] * v;
 
-    int loopIndex = startIndex;
+    int qIndex = startIndex;
     // 2 here is the index of the first translational DOF of the root
-    while (loopIndex > 2) {
-        V3D theVector(v);
-        int qIndex = startIndex;
-
-        while (qIndex > loopIndex) {
-            theVector = rotateVec(theVector, q[qIndex], getQAxis(qIndex));
-            qIndex = qParentIndex[qIndex];
-        }
-
-        theVector = getQAxis(qIndex).cross(theVector);
-
-        while (qIndex > 2) {
-            theVector = rotateVec(theVector, q[qIndex], getQAxis(qIndex));
-            qIndex = qParentIndex[qIndex];
-        }
-
-        for (int i = 0; i < 3; i++)
-            dvdq(i, loopIndex) = theVector[i];
-
-        loopIndex = qParentIndex[loopIndex];
+    while (qIndex > 2) {
+        dvdq.col(qIndex) = worldAxisForQ[qIndex].cross(vWorld);
+        qIndex = qParentIndex[qIndex];
     }
 }
 
@@ -509,13 +483,13 @@ void GeneralizedCoordinatesRobotRepresentation::estimate_linear_jacobian(const P
         double val = q[i];
         double h = 0.0001;
 
-        q[i] = val + h;
+        setQVal(i, val + h);
         P3D p_p = getWorldCoordinates(p, rb);
 
-        q[i] = val - h;
+        setQVal(i, val - h);
         P3D p_m = getWorldCoordinates(p, rb);
 
-        q[i] = val;
+        setQVal(i, val);
         V3D dpdq_i = V3D(p_m, p_p) / (2 * h);
         dpdq(0, i) = dpdq_i[0];
         dpdq(1, i) = dpdq_i[1];
@@ -531,13 +505,13 @@ void GeneralizedCoordinatesRobotRepresentation::estimate_linear_jacobian(const V
         double val = q[i];
         double h = 0.0001;
 
-        q[i] = val + h;
+        setQVal(i, val + h);
         V3D p_p = getWorldCoordinates(v, rb);
 
-        q[i] = val - h;
+        setQVal(i, val - h);
         V3D p_m = getWorldCoordinates(v, rb);
 
-        q[i] = val;
+        setQVal(i, val);
         V3D dvdq_i = (p_p - p_m) / (2 * h);
         dvdq(0, i) = dvdq_i[0];
         dvdq(1, i) = dvdq_i[1];
@@ -623,36 +597,25 @@ bool GeneralizedCoordinatesRobotRepresentation::compute_ddpdq_dqi(const P3D &p,
     if (!isAncestor)
         return false;
 
+    V3D offset(p);
+    if (rb->pJoint != nullptr)
+        offset = V3D(rb->pJoint->cJPos, p);
+    V3D pRel = worldPivotForQ[startIndex] + worldRotationForQ[startIndex] * offset;
+
+    // how p moves with q_i
+    V3D dpdq_i = worldAxisForQ[q_i].cross(V3D(pRel - worldPivotForQ[q_i]));
+
     // input is valid, so we must compute this derivative...
     int loopIndex = startIndex;
     // 2 here is the index of the first translational DOF of the root
     while (loopIndex > 2) {
-        V3D offset(p);
-        if (rb->pJoint != nullptr)
-            offset = V3D(rb->pJoint->cJPos, p);
-        int qIndex = startIndex;
-
-        int stopIndex = loopIndex;
-        if (q_i > loopIndex)
-            stopIndex = q_i;
-
-        while (qIndex > stopIndex) {
-            offset = getOffsetFromParentToQ(qIndex) + rotateVec(offset, q[qIndex], getQAxis(qIndex));
-            qIndex = qParentIndex[qIndex];
-        }
-
-        while (qIndex > 2) {
-            if (qIndex == loopIndex)
-                offset = getQAxis(qIndex).cross(offset);
-            if (qIndex == q_i)
-                offset = getQAxis(qIndex).cross(offset);
-
-            offset = rotateVec(offset, q[qIndex], getQAxis(qIndex));
-            qIndex = qParentIndex[qIndex];
-        }
-
-        for (int i = 0; i < 3; i++)
-            ddpdq_dqi(i, loopIndex) = offset[i];
+        V3D dpdq_loop = worldAxisForQ[loopIndex].cross(V3D(pRel - worldPivotForQ[loopIndex]));
+        // q_i either rotates the axis and pivot of loopIndex together with p
+        // (it is an ancestor of loopIndex), or it only moves p
+        if (q_i < loopIndex)
+            ddpdq_dqi.col(loopIndex) = worldAxisForQ[q_i].cross(dpdq_loop);
+        else
+            ddpdq_dqi.col(loopIndex) = worldAxisForQ[loopIndex].cross(dpdq_i);
 
         loopIndex = qParentIndex[loopIndex];
     }
@@ -683,34 +646,21 @@ bool GeneralizedCoordinatesRobotRepresentation::compute_ddvdq_dqi(const V3D &v,
     if (!isAncestor)
         return false;
 
+    V3D vWorld = worldRotationForQ[startIndex] * v;
+
+    // how v changes with q_i
+    V3D dvdq_i = worldAxisForQ[q_i].cross(vWorld);
+
     // input is valid, so we must compute this derivative...
     int loopIndex = startIndex;
     // 2 here is the index of the first translational DOF of the root
     while (loopIndex > 2) {
-        V3D theVector(v);
-        int qIndex = startIndex;
-
-        int stopIndex = loopIndex;
-        if (q_i > loopIndex)
-            stopIndex = q_i;
-
-        while (qIndex > stopIndex) {
-            theVector = rotateVec(theVector, q[qIndex], getQAxis(qIndex));
-            qIndex = qParentIndex[qIndex];
-        }
-
-        while (qIndex > 2) {
-            if (qIndex == loopIndex)
-                theVector = getQAxis(qIndex).cross(theVector);
-            if (qIndex == q_i)
-                theVector = getQAxis(qIndex).cross(theVector);
-
-            theVector = rotateVec(theVector, q[qIndex], getQAxis(qIndex));
-            qIndex = qParentIndex[qIndex];
-        }
-
-        for (int i = 0; i < 3; i++)
-            ddvdq_dqi(i, loopIndex) = theVector[i];
+        // q_i either rotates the axis of loopIndex together with v (it is an
+        // ancestor of loopIndex), or it only rotates v
+        if (q_i < loopIndex)
+            ddvdq_dqi.col(loopIndex) = worldAxisForQ[q_i].cross(worldAxisForQ[loopIndex].cross(vWorld));
+        else
+            ddvdq_dqi.col(loopIndex) = worldAxisForQ[loopIndex].cross(dvdq_i);
 
         loopIndex = qParentIndex[loopIndex];
     }
@@ -728,13 +678,13 @@ void GeneralizedCoordinatesRobotRepresentation::estimate_ddpdq_dqi(const P3D &p,
     double val = q[q_i];
     double h = 0.0001;
 
-    q[q_i] = val + h;
+    setQVal(q_i, val + h);
     compute_dpdq(p, rb, dpdq_p);
 
-    q[q_i] = val - h;
+    setQVal(q_i, val - h);
     compute_dpdq(p, rb, dpdq_m);
 
-    q[q_i] = val;
+    setQVal(q_i, val);
 
     ddpdq_dqi = (dpdq_p - dpdq_m) / (2 * h);
 }
@@ -749,13 +699,13 @@ void GeneralizedCoordinatesRobotRepresentation::estimate_ddvdq_dqi(const V3D &v,
     double val = q[q_i];
     double h = 0.0001;
 
-    q[q_i] = val + h;
+    setQVal(q_i, val + h);
     compute_dvdq(v, rb, dvdq_p);
 
-    q[q_i] = val - h;
+    setQVal(q_i, val - h);
     compute_dvdq(v, rb, dvdq_m);
 
-    q[q_i] = val;
+    setQVal(q_i, val);
 
     ddvdq_dqi = (dvdq_p - dvdq_m) / (2 * h);
 }
@@ -817,53 +767,55 @@ void GeneralizedCoordinatesRobotRepresentation::compute_angular_jacobian(const s
     // up the hierarchy... so the jacobian consists of the world-coords axes
     resize(dRdq, 3, (int)q.size());
 
-    std::vector<int> qIndices;
+    int qIndex = getQStartIndexForRB(rb);
+    // 2 here is the index of the first translational DOF of the root
+    while (qIndex > 2) {
+        dRdq.col(qIndex) = worldAxisForQ[qIndex];
+        qIndex = qParentIndex[qIndex];
+    }
+}
 
-    int startIndex = getQStartIndexForRB(rb);
+// computes the linear jacobians of many points at once, and optionally the
+// angular jacobians of their rigid bodies
+void GeneralizedCoordinatesRobotRepresentation::computeJacobiansForPoints(const std::vector<std::shared_ptr<const RB>> &rbs, const std::vector<P3D> &points,
+                                                                          Matrix &dpdq, Matrix *dRdq) const {
+    assert(rbs.size() == points.size());
+    resize(dpdq, 3 * (int)rbs.size(), (int)q.size());
+    if (dRdq)
+        resize(*dRdq, 3 * (int)rbs.size(), (int)q.size());
 
-    while (startIndex > 2) {
-        qIndices.push_back(startIndex);
-        startIndex = qParentIndex[startIndex];
-    }
+    for (int i = 0; i < (int)rbs.size(); i++) {
+        V3D offset(points[i]);
+        if (rbs[i]->pJoint != nullptr)
+            offset = V3D(rbs[i]->pJoint->cJPos, points[i]);
+
+        int startIndex = getQStartIndexForRB(rbs[i]);
+        // p, relative to the position of the root (like the pivots)
+        V3D pRel = worldPivotForQ[startIndex] + worldRotationForQ[startIndex] * offset;
+
+        int qIndex = startIndex;
+        // 2 here is the index of the first translational DOF of the root
+        while (qIndex > 2) {
+            dpdq.block<3, 1>(3 * i, qIndex) = worldAxisForQ[qIndex].cross(V3D(pRel - worldPivotForQ[qIndex]));
+            if (dRdq)
+                dRdq->block<3, 1>(3 * i, qIndex) = worldAxisForQ[qIndex];
+            qIndex = qParentIndex[qIndex];
+        }
 
-    Quaternion Q = Quaternion::Identity();
-    // q rotates the rigid body (grand...child) about its world coordinate
-    // axis... these will be the entries of dR/dq...
-    while (qIndices.size() > 0) {
-        int index = qIndices.back();
-        Q = Q * getRelOrientationForQ(qIndices.back());
-        // this is just the rotation axis in world coordinates, as this is what
-        // we are rotating about to get the orientation of the rigid body if
-        // everything else is fixed...
-        V3D dRdq_i = Q * getQAxis(index);
-        dRdq(0, index) = dRdq_i[0];
-        dRdq(1, index) = dRdq_i[1];
-        dRdq(2, index) = dRdq_i[2];
-
-        qIndices.pop_back();
+        dpdq(3 * i + 0, 0) = 1;
+        dpdq(3 * i + 1, 1) = 1;
+        dpdq(3 * i + 2, 2) = 1;
     }
+}
 
-    /*
-            while (rb->pJoint != nullptr) {
-                    int jIndex = rb->pJoint->jIndex;
-                    //q rotates the rigid body (grand...child) about its world
-       coordinate axis... these will be the entries of dp/dq... for (int i = 0;
-       i<jointCoordsDimSize[jIndex]; i++) { int index =
-       jointCoordStartIndex[jIndex] + jointCoordsDimSize[jIndex] - i - 1; V3D
-       dRdq_i = getWorldCoordsAxisForQ(index); dRdq(0, index) = dRdq_i[0];
-                            dRdq(1, index) = dRdq_i[1];
-                            dRdq(2, index) = dRdq_i[2];
-                    }
-                    rb = rb->pJoint->parent;
-            }
+void GeneralizedCoordinatesRobotRepresentation::compute_dpdq(const std::vector<std::shared_ptr<const RB>> &rbs, const std::vector<P3D> &points,
+                                                             Matrix &dpdq) const {
+    computeJacobiansForPoints(rbs, points, dpdq, nullptr);
+}
 
-            for (int index = 3; index<6; index++) {
-                    V3D dRdq_i = getWorldCoordsAxisForQ(index);
-                    dRdq(0, index) = dRdq_i[0];
-                    dRdq(1, index) = dRdq_i[1];
-                    dRdq(2, index) = dRdq_i[2];
-            }
-    */
+void GeneralizedCoordinatesRobotRepresentation::compute_jacobians(const std::vector<std::shared_ptr<const RB>> &rbs, const std::vector<P3D> &points,
+                                                                  Matrix &dpdq, Matrix &dRdq) const {
+    computeJacobiansForPoints(rbs, points, dpdq, &dRdq);
 }
 
 // estimates the angular jacobian using finite differences
@@ -874,13 +826,13 @@ void GeneralizedCoordinatesRobotRepresentation::estimate_angular_jacobian(const
         double val = q[i];
         double h = 0.001;
 
-        q[i] = val + h;
+        setQVal(i, val + h);
         Quaternion R_p = getOrientationFor(rb);
 
-        q[i] = val - h;
+        setQVal(i, val - h);
         Quaternion R_m = getOrientationFor(rb);
 
-        q[i] = val;
+        setQVal(i, val);
         Quaternion rotate = R_p * R_m.inverse();
         AngleAxisd aa(rotate);
         V3D axis = aa.axis().normalized();
@@ -925,64 +877,28 @@ bool GeneralizedCoordinatesRobotRepresentation::compute_dangular_jacobian_dqi(co
 
     int startIndex = getQStartIndexForRB(rb);
 
-    std::vector<int> qIndices;
-
     // if q_i is not one of the ancestors of rb, then it means the jacobian dpdq
     // does not depent on it, so check first...
     int qIndex = startIndex;
     bool isAncestor = false;
-
-    Quaternion Q_qi = Quaternion::Identity();
-
     while (qIndex > 2) {
-        qIndices.push_back(qIndex);
-
         if (q_i == qIndex) {
             isAncestor = true;
+            break;
         }
-        if (isAncestor)
-            Q_qi = getRelOrientationForQ(qIndex) * Q_qi;
         qIndex = qParentIndex[qIndex];
     }
 
     if (!isAncestor)
         return false;
 
-    V3D q_i_rotAxisWorld = Q_qi * getQAxis(q_i);
-
-    Quaternion Q = Quaternion::Identity();
-    // q rotates the rigid body (grand...child) about its world coordinate
-    // axis... these will be the entries of dR/dq...
-    while (qIndices.size() > 0) {
-        int index = qIndices.back();
-        Q = Q * getRelOrientationForQ(qIndices.back());
-
-        if (index > q_i) {
-            V3D derivativeVal = q_i_rotAxisWorld.cross(Q * getQAxis(index));
-
-            ddRdqdqi(0, index) = derivativeVal(0);
-            ddRdqdqi(1, index) = derivativeVal(1);
-            ddRdqdqi(2, index) = derivativeVal(2);
-        }
-        qIndices.pop_back();
+    // q_i rotates the world coordinates axes of all its descendants
+    qIndex = startIndex;
+    while (qIndex > q_i) {
+        ddRdqdqi.col(qIndex) = worldAxisForQ[q_i].cross(worldAxisForQ[qIndex]);
+        qIndex = qParentIndex[qIndex];
     }
 
-    /*
-
-            //input is valid, so we must compute this derivative...
-            int loopIndex = startIndex;
-            //2 here is the index of the first translational DOF of the root
-            while (loopIndex > q_i) {
-    //		Logger::consolePrint("NEW: adding contribution for index: %d\n",
-    loopIndex); V3D derivativeVal =
-    getWorldCoordsAxisForQ(q_i).cross(getWorldCoordsAxisForQ(loopIndex));
-                    ddRdqdqi(0, loopIndex) = derivativeVal(0);
-                    ddRdqdqi(1, loopIndex) = derivativeVal(1);
-                    ddRdqdqi(2, loopIndex) = derivativeVal(2);
-
-                    loopIndex = qParentIndex[loopIndex];
-            }
-    */
     return true;
 }
 
@@ -997,13 +913,13 @@ void GeneralizedCoordinatesRobotRepresentation::estimate_dangular_jacobian_dqi(c
     double val = q[q_i];
     double h = 0.0001;
 
-    q[q_i] = val + h;
+    setQVal(q_i, val + h);
     compute_angular_jacobian(rb, dRdq_p);
 
-    q[q_i] = val - h;
+    setQVal(q_i, val - h);
     compute_angular_jacobian(rb, dRdq_m);
 
-    q[q_i] = val;
+    setQVal(q_i, val);
 
     ddRdq_dqi = (dRdq_p - dRdq_m) / (2 * h);
 }
@@ -1063,15 +979,29 @@ void GeneralizedCoordinatesRobotRepresentation::computeMassMatrixForRB(const std
 
 // computes the mass matrix for the whole robot
 void GeneralizedCoordinatesRobotRepresentation::computeMassMatrix(Matrix &massMatrix) const {
-    resize(massMatrix, q.size(), q.size());
-
-    computeMassMatrixForRB(robot->root, massMatrix);
-
-    Matrix curMassMatrix;
-    for (uint i = 0; i < robot->jointList.size(); ++i) {
-        computeMassMatrixForRB(robot->jointList[i]->child, curMassMatrix);
-        massMatrix += curMassMatrix;
+    // M = sum over rigid bodies of J'McJ. With the jacobians of all COMs
+    // stacked, this is M = Jp' m Jp + JR' MoI JR, where m and MoI are block
+    // diagonal
+    std::vector<std::shared_ptr<const RB>> rbs;
+    rbs.push_back(robot->root);
+    for (uint i = 0; i < robot->jointList.size(); ++i)
+        rbs.push_back(robot->jointList[i]->child);
+    std::vector<P3D> coms(rbs.size(), P3D(0, 0, 0));
+
+    Matrix dpdq, dRdq;
+    compute_jacobians(rbs, coms, dpdq, dRdq);
+
+    Matrix mdpdq(dpdq.rows(), dpdq.cols()), MoIdRdq(dRdq.rows(), dRdq.cols());
+    for (int i = 0; i < (int)rbs.size(); i++) {
+        // the MOI here needs to be in global coordinates
+        Matrix3x3 MoI = rbs[i]->rbProps.getMOI(getOrientationFor(rbs[i]).toRotationMatrix());
+        mdpdq.middleRows<3>(3 * i) = rbs[i]->rbProps.mass * dpdq.middleRows<3>(3 * i);
+        MoIdRdq.middleRows<3>(3 * i).noalias() = MoI * dRdq.middleRows<3>(3 * i);
     }
+
+    resize(massMatrix, q.size(), q.size());
+    massMatrix.noalias() = dpdq.transpose() * mdpdq;
+    massMatrix.noalias() += dRdq.transpose() * MoIdRdq;
 }
 
 // computes dpdq_dot, dpdq_dot = sigma(dpdq_dqi * qiDot): JDot = dJ/dq * qDot
@@ -1140,6 +1070,158 @@ void GeneralizedCoordinatesRobotRepresentation::computeCoriolisMatrix(const std:
     coriolisMatrix.noalias() += (dRdq.transpose() * MoI * dRdq_dot + dRdq.transpose() * omega * MoI * dRdq);
 }
 
+// NOTE: CRBA and RNEA below work with spatial vectors expressed in world
+// coordinates, about the root's current position: a spatial velocity is
+// (w, v), where v is the velocity of the material point that is currently at
+// the root's position. Since all dofs share this frame, quantities never need
+// to be transformed from one dof to the next.
+
+// the spatial velocity of the motion induced by a unit qDot_i, i.e. column i of
+// the robot's spatial jacobian
+static inline void getMotionSubspace(int qIndex, const V3D &worldAxis, const V3D &worldPivot, V3D &w, V3D &v) {
+    if (qIndex < 3) {
+        // translational dofs of the root
+        w = V3D(0, 0, 0);
+        v = worldAxis;
+    } else {
+        w = worldAxis;
+        v = worldPivot.cross(worldAxis);
+    }
+}
+
+void GeneralizedCoordinatesRobotRepresentation::setDofInertiasFromRigidBodies() const {
+    for (auto &dof : dofDynamics) {
+        dof.mass = 0;
+        dof.firstMoment = V3D(0, 0, 0);
+        dof.MoI.setZero();
+    }
+
+    P3D rootPosition(q[0], q[1], q[2]);
+    auto addRB = [&](const std::shared_ptr<const RB> &rb) {
+        DofDynamics &dof = dofDynamics[getQStartIndexForRB(rb)];
+        double m = rb->rbProps.mass;
+        V3D c(rootPosition, getWorldCoordinates(P3D(0, 0, 0), rb));
+        // the MOI here needs to be in global coordinates, and about the root's
+        // position (parallel axis theorem)
+        dof.mass += m;
+        dof.firstMoment += m * c;
+        Matrix3x3 cx = getSkewSymmetricMatrix(c);
+        dof.MoI += rb->rbProps.getMOI(getOrientationFor(rb).toRotationMatrix()) + m * cx * cx.transpose();
+    };
+
+    addRB(robot->root);
+    for (uint i = 0; i < robot->jointList.size(); ++i)
+        addRB(robot->jointList[i]->child);
+}
+
+// computes the mass matrix for the whole robot with the composite rigid body
+// algorithm
+void GeneralizedCoordinatesRobotRepresentation::computeMassMatrixCRBA(Matrix &massMatrix) const {
+    int nDim = (int)q.size();
+    resize(massMatrix, nDim, nDim);
+
+    // composite inertias: every dof moves its own rigid body and all the
+    // rigid bodies of its descendants. Children have higher indices than their
+    // parents, so one backwards pass accumulates them
+    setDofInertiasFromRigidBodies();
+    for (int i = nDim - 1; i > 0; i--) {
+        DofDynamics &dof = dofDynamics[i];
+        DofDynamics &parent = dofDynamics[qParentIndex[i]];
+        parent.mass += dof.mass;
+        parent.firstMoment += dof.firstMoment;
+        parent.MoI += dof.MoI;
+    }
+
+    for (int i = nDim - 1; i >= 0; i--) {
+        const DofDynamics &dof = dofDynamics[i];
+        V3D w, v;
+        getMotionSubspace(i, worldAxisForQ[i], worldPivotForQ[i], w, v);
+
+        // the spatial force (torque, force) needed to accelerate the subtree
+        // of dof i with a unit qDDot_i
+        V3D torque = V3D(dof.MoI * w) + dof.firstMoment.cross(v);
+        V3D force = w.cross(dof.firstMoment) + dof.mass * v;
+
+        // M(i, j) is the part of this force that dof j has to provide, which
+        // is only non-zero for ancestors of i
+        for (int j = i; j >= 0; j = qParentIndex[j]) {
+            getMotionSubspace(j, worldAxisForQ[j], worldPivotForQ[j], w, v);
+            massMatrix(i, j) = massMatrix(j, i) = w.dot(torque) + v.dot(force);
+        }
+    }
+}
+
+// computes the generalized forces M(q) qDDot + C(q, qDot) qDot + g(q) with the
+// recursive Newton-Euler algorithm
+void GeneralizedCoordinatesRobotRepresentation::computeRNEA(const dVector *qDDot, bool includeGravity, dVector &generalizedForces) const {
+    int nDim = (int)q.size();
+    resize(generalizedForces, nDim);
+
+    setDofInertiasFromRigidBodies();
+
+    // forward pass: spatial velocities and accelerations of all dofs. Gravity
+    // is accounted for by accelerating the world upwards
+    V3D gravityAcceleration = includeGravity ? V3D(RBGlobals::worldUp * -RBGlobals::g) : V3D(0, 0, 0);
+    for (int i = 0; i < nDim; i++) {
+        DofDynamics &dof = dofDynamics[i];
+        V3D w, v;
+        getMotionSubspace(i, worldAxisForQ[i], worldPivotForQ[i], w, v);
+
+        V3D parentAngularVelocity(0, 0, 0), parentLinearVelocity(0, 0, 0);
+        V3D parentAngularAcceleration(0, 0, 0), parentLinearAcceleration = gravityAcceleration;
+        if (qParentIndex[i] >= 0) {
+            const DofDynamics &parent = dofDynamics[qParentIndex[i]];
+            parentAngularVelocity = parent.angularVelocity;
+            parentLinearVelocity = parent.linearVelocity;
+            parentAngularAcceleration = parent.angularAcceleration;
+            parentLinearAcceleration = parent.linearAcceleration;
+        }
+
+        // the motion subspace moves with the parent, so its rate of change is
+        // the parent's velocity crossed with it
+        V3D wJ = w * qDot[i], vJ = v * qDot[i];
+        dof.angularVelocity = parentAngularVelocity + wJ;
+        dof.linearVelocity = parentLinearVelocity + vJ;
+        dof.angularAcceleration = parentAngularAcceleration + parentAngularVelocity.cross(wJ);
+        dof.linearAcceleration = parentLinearAcceleration + parentAngularVelocity.cross(vJ) + parentLinearVelocity.cross(wJ);
+        if (qDDot != nullptr) {
+            dof.angularAcceleration += w * (*qDDot)[i];
+            dof.linearAcceleration += v * (*qDDot)[i];
+        }
+
+        // the spatial force acting on the rigid body carried by the dof:
+        // f = I a + v x* (I v)
+        V3D angularMomentum = V3D(dof.MoI * dof.angularVelocity) + dof.firstMoment.cross(dof.linearVelocity);
+        V3D linearMomentum = dof.angularVelocity.cross(dof.firstMoment) + dof.mass * dof.linearVelocity;
+        dof.torque = V3D(dof.MoI * dof.angularAcceleration) + dof.firstMoment.cross(dof.linearAcceleration) +
+                     dof.angularVelocity.cross(angularMomentum) + dof.linearVelocity.cross(linearMomentum);
+        dof.force = dof.angularAcceleration.cross(dof.firstMoment) + dof.mass * dof.linearAcceleration + dof.angularVelocity.cross(linearMomentum);
+    }
+
+    // backward pass: every dof transmits the forces of its whole subtree, and
+    // provides their component along its motion subspace
+    for (int i = nDim - 1; i >= 0; i--) {
+        const DofDynamics &dof = dofDynamics[i];
+        V3D w, v;
+        getMotionSubspace(i, worldAxisForQ[i], worldPivotForQ[i], w, v);
+        generalizedForces[i] = w.dot(dof.torque) + v.dot(dof.force);
+
+        if (qParentIndex[i] >= 0) {
+            DofDynamics &parent = dofDynamics[qParentIndex[i]];
+            parent.torque += dof.torque;
+            parent.force += dof.force;
+        }
+    }
+}
+
+void GeneralizedCoordinatesRobotRepresentation::computeInverseDynamicsRNEA(const dVector &qDDot, dVector &generalizedForces, bool includeGravity) const {
+    computeRNEA(&qDDot, includeGravity, generalizedForces);
+}
+
+void GeneralizedCoordinatesRobotRepresentation::computeBiasForcesRNEA(dVector &biasForces, bool includeGravity) const {
+    computeRNEA(nullptr, includeGravity, biasForces);
+}
+
 void testGeneralizedCoordinateRepresentation(const std::shared_ptr<Robot> &robot) {
     std::cout << "testing generalized coordinates representation..." << std::endl;
 
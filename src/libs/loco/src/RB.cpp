@@ -3,7 +3,7 @@
 namespace crl::loco {
 
 Matrix3x3 RB::getWorldMOI() const {
-    return rbProps.getMOI(state.orientation);
+    return rbProps.getMOI(getOrientation());
 }
 
 Matrix3x3 RB::getWorldMOI(const V3D &v) const {
@@ -29,47 +29,23 @@ Matrix3x3 RB::getWorldMOI(const V3D &v) const {
         }                                                                          \
     }
 
-bool RB::getRayIntersectionPoint(const Ray &ray, P3D &intersectionPoint, bool checkMeshes, bool checkSkeleton) {
+bool RB::getRayIntersectionPoint(const Ray &ray, P3D &intersectionPoint) const {
     P3D tmpIntersectionPoint;
     double tMin = DBL_MAX;
-    double t = tMin;
-    // we will check all meshes and all cylinders that are used to show the
-    // abstract view...
+    // we will check all cylinders that are used to show the abstract view...
+    double cylRadius = rbProps.abstractViewCylRadius;
 
-    // meshes first...
+    if (pJoint != nullptr)
+        UPDATE_RAY_INTERSECTION(pJoint->getWorldPosition(), stateStore->positions[stateId]);
 
-    if (checkMeshes)
-        for (uint i = 0; i < rbProps.models.size(); i++) {
-            RigidTransformation meshTransform(state.orientation, state.pos);
-            meshTransform *= rbProps.models[i].localT;
+    for (uint i = 0; i < cJoints.size(); i++)
+        UPDATE_RAY_INTERSECTION(stateStore->positions[stateId], cJoints[i]->getWorldPosition());
 
-            rbProps.models[i].position = meshTransform.T;
-            rbProps.models[i].orientation = meshTransform.R;
-
-            if (rbProps.models[i].hitByRay(ray.origin, ray.dir, t)) {
-                if (t < tMin) {
-                    intersectionPoint = ray.origin + ray.dir * t;
-                    tMin = t;
-                }
-            }
-        }
-
-    if (checkSkeleton) {
-        // and now the cylinders...
-        double cylRadius = rbProps.abstractViewCylRadius;
-
-        if (pJoint != nullptr)
-            UPDATE_RAY_INTERSECTION(pJoint->getWorldPosition(), state.pos);
-
-        for (uint i = 0; i < cJoints.size(); i++)
-            UPDATE_RAY_INTERSECTION(state.pos, cJoints[i]->getWorldPosition());
-
-        if (cJoints.size() == 0) {
-            for (uint i = 0; i < rbProps.endEffectorPoints.size(); i++) {
-                P3D startPos = getWorldCoordinates(P3D(0, 0, 0));
-                P3D endPos = getWorldCoordinates(rbProps.endEffectorPoints[i].endEffectorOffset);
-                UPDATE_RAY_INTERSECTION(startPos, endPos);
-            }
+    if (cJoints.size() == 0) {
+        for (uint i = 0; i < rbProps.endEffectorPoints.size(); i++) {
+            P3D startPos = getWorldCoordinates(P3D(0, 0, 0));
+            P3D endPos = getWorldCoordinates(rbProps.endEffectorPoints[i].endEffectorOffset);
+            UPDATE_RAY_INTERSECTION(startPos, endPos);
         }
     }
 
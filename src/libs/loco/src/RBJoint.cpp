@@ -15,10 +15,20 @@ Quaternion RBJoint::computeRelativeOrientation() const {
 
 void RBJoint::fixJointConstraints(bool fixPositions, bool fixOrientations, bool fixLinVelocities, bool fixAngularVelocities) {
     assert(child && parent);
+    fixJointConstraints(*parent->getStateStore(), parent->getStateId(), *child->getStateStore(), child->getStateId(), fixPositions, fixOrientations,
+                        fixLinVelocities, fixAngularVelocities);
+}
+
+void RBJoint::fixJointConstraints(const RBStateStore &ps, int p, RBStateStore &cs, int c, bool fixPositions, bool fixOrientations, bool fixLinVelocities,
+                                  bool fixAngularVelocities) const {
+    const Quaternion &qp = ps.orientations[p];
+    const V3D &wp = ps.angularVelocities[p];
+    Quaternion &qc = cs.orientations[c];
+    V3D &wc = cs.angularVelocities[c];
 
     // first fix the relative orientation
     if (fixOrientations) {
-        Quaternion qRel = computeRelativeOrientation();
+        Quaternion qRel = (qp.inverse() * qc).normalized();
         // make sure that the relative rotation between the child and the parent
         // is around the a axis
         V3D axis = qRel.vec().normalized();
@@ -29,26 +39,27 @@ void RBJoint::fixJointConstraints(bool fixPositions, bool fixOrientations, bool
         // world frame now)
         double ang = axis.dot(rotationAxis) * rotAngle;
         // compute the correct child orientation
-        child->setOrientation(parent->getOrientation() * getRotationQuaternion(ang, rotationAxis));
+        qc = qp * getRotationQuaternion(ang, rotationAxis);
+        qc.normalize();
     }
 
     // now worry about the joint positions
     if (fixPositions) {
         // compute the vector rc from the child's joint position to the child's
         // center of mass (in rbEngine coordinates)
-        V3D rc = child->getWorldCoordinates(V3D(cJPos, P3D(0, 0, 0)));
+        V3D rc = qc * V3D(cJPos, P3D(0, 0, 0));
         // and the vector rp that represents the same quanity but for the parent
-        V3D rp = parent->getWorldCoordinates(V3D(pJPos, P3D(0, 0, 0)));
+        V3D rp = qp * V3D(pJPos, P3D(0, 0, 0));
 
         // the location of the child's CM is now: pCM - rp + rc
-        child->setPosition(parent->getWorldCoordinates(P3D()) + (rc - rp));
+        cs.positions[c] = ps.positions[p] + (rc - rp);
     }
 
     if (fixAngularVelocities) {
-        V3D wRel = child->getAngularVelocity() - parent->getAngularVelocity();
-        V3D worldRotAxis = parent->getWorldCoordinates(rotationAxis);
+        V3D wRel = wc - wp;
+        V3D worldRotAxis = qp * rotationAxis;
         // only keep the part that is aligned with the rotation axis...
-        child->setAngularVelocity(parent->getAngularVelocity() + worldRotAxis * wRel.dot(worldRotAxis));
+        wc = wp + worldRotAxis * wRel.dot(worldRotAxis);
     }
 
     // fix the velocities, if need be
@@ -56,11 +67,10 @@ void RBJoint::fixJointConstraints(bool fixPositions, bool fixOrientations, bool
         // we want to get the relative velocity at the joint to be 0. This can
         // be accomplished in many different ways, but this approach only
         // changes the linear velocity of the child
-        V3D pJPosVel = parent->getVelocityForPoint_local(pJPos);
-        V3D cJPosVel = child->getVelocityForPoint_local(cJPos);
-        child->setVelocity(child->getVelocityForPoint_local(P3D()) - (cJPosVel - pJPosVel));
-        V3D testVel = parent->getVelocityForPoint_local(pJPos) - child->getVelocityForPoint_local(cJPos);
-        assert(IS_ZERO(testVel.norm()));
+        V3D pJPosVel = wp.cross(qp * V3D(pJPos)) + ps.velocities[p];
+        V3D cJPosVel = wc.cross(qc * V3D(cJPos)) + cs.velocities[c];
+        cs.velocities[c] -= cJPosVel - pJPosVel;
+        assert(IS_ZERO((wp.cross(qp * V3D(pJPos)) + ps.velocities[p] - wc.cross(qc * V3D(cJPos)) - cs.velocities[c]).norm()));
     }
 }
 
@@ -72,6 +72,16 @@ void RBLoader::populateRobot(Robot &robot) {
     for (uint i = 0; i < robot.jointList.size(); i++)
         robot.jointList[i]->jIndex = i;
 
+    // and keep the states of all the RBs together, in the order of rbList
+    robot.stateStore = std::make_shared<RBStateStore>();
+    for (const auto &rb : robot.rbList)
+        rb->moveStateTo(robot.stateStore, robot.stateStore->addBody());
+    for (const auto &joint : robot.jointList) {
+        // the child of joint i is rigid body i + 1 (see Robot::getRigidBody)
+        assert(joint->child->getStateId() == joint->jIndex + 1);
+        robot.jointParentStateIds.push_back(joint->parent->getStateId());
+    }
+
     // fix link states
     // this is necessary for the case that joints are created from random orders
     // this is not the case for rbs but for urdf the joints are created from
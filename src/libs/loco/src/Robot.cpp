@@ -35,15 +35,22 @@ void Robot::populateState(RobotState &state, bool useDefaultAngles) const {
     // state relative to its parent. we are assuming here that each joint is
     // revolute!!!
 
-    for (uint i = 0; i < jointList.size(); i++) {
-        if (!useDefaultAngles) {
-            state.setJointRelativeOrientation(getRelativeOrientationForJoint(jointList[i]), i);
-            state.setJointRelativeAngVelocity(getRelativeLocalCoordsAngularVelocityForJoint(jointList[i]), i);
-        } else {
+    if (useDefaultAngles) {
+        for (uint i = 0; i < jointList.size(); i++) {
             state.setJointRelativeAngVelocity(V3D(0, 0, 0), i);
             state.setJointRelativeOrientation(getRotationQuaternion(jointList[i]->defaultJointAngle, jointList[i]->rotationAxis), i);
         }
+        return;
     }
+
+    // the same as getRelativeOrientationForJoint and
+    // getRelativeLocalCoordsAngularVelocityForJoint, on the state store
+    const RBStateStore &s = *stateStore;
+    forEachJoint([&](const RBJoint &joint, int p, int c) {
+        const Quaternion &qp = s.orientations[p];
+        state.setJointRelativeOrientation((qp.inverse() * s.orientations[c]).normalized(), joint.jIndex);
+        state.setJointRelativeAngVelocity(qp.inverse() * V3D(s.angularVelocities[c] - s.angularVelocities[p]), joint.jIndex);
+    });
 }
 
 void Robot::setDefaultState() {
@@ -72,17 +79,22 @@ void Robot::setState(const RobotState &state) {
     // now each joint introduces one more rigid body, so we'll only record its
     // state relative to its parent. we are assuming here that each joint is
     // revolute!!!
-    for (uint j = 0; j < jointList.size(); j++) {
-        setRelativeOrientationForJoint(jointList[j], state.getJointRelativeOrientation((int)j).normalized());
-        setRelativeLocalCoordsAngularVelocityForJoint(jointList[j], state.getJointRelativeAngVelocity((int)j));
+    // (the same as setRelativeOrientationForJoint and
+    // setRelativeLocalCoordsAngularVelocityForJoint, on the state store)
+    RBStateStore &s = *stateStore;
+    forEachJoint([&](const RBJoint &joint, int p, int c) {
+        Quaternion &qc = s.orientations[c];
+        qc = s.orientations[p] * state.getJointRelativeOrientation(joint.jIndex).normalized();
+        qc.normalize();
+        s.angularVelocities[c] = s.angularVelocities[p] + s.orientations[p] * state.getJointRelativeAngVelocity(joint.jIndex);
         // and now set the linear position and velocity
-        jointList[j]->fixJointConstraints(true, true, true, true);
-    }
+        joint.fixJointConstraints(s, p, s, c, true, true, true, true);
+    });
 }
 
 void Robot::fixJointConstraints() {
-    for (size_t j = 0; j < jointList.size(); j++)
-        jointList[j]->fixJointConstraints(true, true, true, true);
+    RBStateStore &s = *stateStore;
+    forEachJoint([&](const RBJoint &joint, int p, int c) { joint.fixJointConstraints(s, p, s, c, true, true, true, true); });
 }
 
 P3D Robot::computeCOM() const {
@@ -165,37 +177,4 @@ std::shared_ptr<RB> Robot::getRBByName(const char *jName) {
     return nullptr;
 }
 
-void Robot::draw(const gui::Shader &rbShader, float alpha) {
-    // Draw abstract view first
-    if (showSkeleton)
-        for (const auto &rb : rbList)
-            RBRenderer::drawSkeletonView(rb, rbShader, showJointAxes, showJointLimits, showJointAngles, alpha);
-
-    // Then draw meshes (because of blending)
-    if (showMeshes)
-        for (const auto &rb : rbList)
-            RBRenderer::drawMeshes(rb, rbShader, alpha);
-
-    // Then draw collsion spheres
-    if (showCollisionSpheres)
-        for (const auto &rb : rbList)
-            RBRenderer::drawCollisionShapes(rb, rbShader);
-
-    // Then draw end effectors
-    if (showEndEffectors)
-        for (const auto &rb : rbList)
-            RBRenderer::drawEndEffectors(rb, rbShader);
-
-    // and now MOIs
-    if (showMOI)
-        for (const auto &rb : rbList)
-            RBRenderer::drawMOI(rb, rbShader);
-
-    // and now coordinate frames
-    if (showCoordFrame) {
-        for (const auto &rb : rbList)
-            RBRenderer::drawCoordFrame(rb, rbShader);
-    }
-}
-
 }  // namespace crl::loco
@@ -21,6 +21,19 @@ RobotState::RobotState(const Robot &robot, bool useDefaultAngles) {
     robot.populateState(*this, useDefaultAngles);
 }
 
+RobotState RobotState::interpolate(const RobotState &a, const RobotState &b, double t) {
+    RobotState s(a);
+    s.rootQ = a.rootQ.slerp(t, b.rootQ);
+    s.rootPos = a.rootPos + V3D(V3D(a.rootPos, b.rootPos) * t);
+    s.rootVel = a.rootVel + t * (b.rootVel - a.rootVel);
+    s.rootAngVel = a.rootAngVel + t * (b.rootAngVel - a.rootAngVel);
+    for (uint i = 0; i < s.joints.size(); i++) {
+        s.joints[i].qRel = a.joints[i].qRel.slerp(t, b.joints[i].qRel);
+        s.joints[i].angVelRel = a.joints[i].angVelRel + t * (b.joints[i].angVelRel - a.joints[i].angVelRel);
+    }
+    return s;
+}
+
 bool RobotState::operator==(const RobotState &other) const {
     if (getJointCount() != other.getJointCount()) {
         //			Logger::consolePrint("jCount: %d vs %d\n",
@@ -0,0 +1,24 @@
+#include "loco/robot/RobotStateBuffer.h"
+
+#include "loco/robot/Robot.h"
+
+namespace crl::loco {
+
+void RobotStateBuffer::publish(const Robot &robot) {
+    Snapshot &s = snapshots.getBackBuffer();
+    robot.populateState(s.current);
+    // the first state has no state before it
+    s.previous = nPublished > 0 ? latest : s.current;
+    latest = s.current;
+    s.version = ++nPublished;
+    snapshots.publish();
+}
+
+void RobotStateBuffer::apply(Robot &robot, double t) const {
+    const Snapshot &s = getSnapshot();
+    if (s.version == 0)
+        return;
+    robot.setState(t >= 1 ? s.current : RobotState::interpolate(s.previous, s.current, t));
+}
+
+}  // namespace crl::loco
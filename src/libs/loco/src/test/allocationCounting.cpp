@@ -0,0 +1,81 @@
+#include "allocationCounting.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace crl::loco {
+std::atomic<int> allocationCount{0};
+}  // namespace crl::loco
+
+extern "C" {
+void *__real_malloc(std::size_t size);
+void *__real_calloc(std::size_t n, std::size_t size);
+void *__real_realloc(void *p, std::size_t size);
+void *__real_aligned_alloc(std::size_t alignment, std::size_t size);
+
+void *__wrap_malloc(std::size_t size) {
+    crl::loco::allocationCount++;
+    return __real_malloc(size);
+}
+
+void *__wrap_calloc(std::size_t n, std::size_t size) {
+    crl::loco::allocationCount++;
+    return __real_calloc(n, size);
+}
+
+void *__wrap_realloc(void *p, std::size_t size) {
+    crl::loco::allocationCount++;
+    return __real_realloc(p, size);
+}
+
+void *__wrap_aligned_alloc(std::size_t alignment, std::size_t size) {
+    crl::loco::allocationCount++;
+    return __real_aligned_alloc(alignment, size);
+}
+}
+
+// the default operator new calls malloc from within the standard library,
+// which is not wrapped
+void *operator new(std::size_t size) {
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size) {
+    if (void *p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+    std::size_t a = static_cast<std::size_t>(alignment);
+    // aligned_alloc wants a multiple of the alignment
+    if (void *p = std::aligned_alloc(a, (size + a - 1) / a * a))
+        return p;
+    throw std::bad_alloc();
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+#include <atomic>
+
+namespace crl::loco {
+// calls to malloc, calloc, realloc and aligned_alloc, which the allocation
+// tests are linked to wrap (-Wl,--wrap). operator new and Eigen both allocate
+// through them, in the tests and in the libraries alike
+extern std::atomic<int> allocationCount;
+}  // namespace crl::loco
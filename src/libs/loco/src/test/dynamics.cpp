@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+
+#include "loco/robot/GeneralizedCoordinatesRobotRepresentation.h"
+#include "loco/robot/Robot.h"
+
+namespace crl::loco {
+
+/**
+ * Bob, with every dof (root included) moved away from the rest pose and a
+ * random generalized velocity.
+ */
+class GCRRDynamicsTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        robot = std::make_shared<Robot>(CRL_DATA_FOLDER "/robots/bob/bob_RB.rbs");
+        robot->setRootState(P3D(0, 0.9, 0));
+        gcrr = std::make_shared<GCRR>(robot);
+
+        srand(0);
+        dVector q, qDot;
+        gcrr->getQ(q);
+        resize(qDot, q.size());
+        for (int i = 0; i < q.size(); i++) {
+            q[i] += getRandomNumberInRange(-0.5, 0.5);
+            qDot[i] = getRandomNumberInRange(-2.0, 2.0);
+        }
+        gcrr->setQ(q);
+        gcrr->setQDot(qDot);
+    }
+
+    std::shared_ptr<Robot> robot;
+    std::shared_ptr<GCRR> gcrr;
+};
+
+TEST_F(GCRRDynamicsTest, crbaMassMatrixMatchesReference) {
+    Matrix M, MCRBA;
+    gcrr->computeMassMatrix(M);
+    gcrr->computeMassMatrixCRBA(MCRBA);
+
+    ASSERT_EQ(MCRBA.rows(), M.rows());
+    ASSERT_EQ(MCRBA.cols(), M.cols());
+    EXPECT_LT((MCRBA - M).norm(), 1e-10 * M.norm());
+}
+
+TEST_F(GCRRDynamicsTest, rneaCoriolisTermMatchesReference) {
+    dVector C, CRNEA;
+    gcrr->computeCoriolisAndCentrifugalForcesTerm(C);
+    gcrr->computeBiasForcesRNEA(CRNEA, false);
+
+    ASSERT_EQ(CRNEA.size(), C.size());
+    EXPECT_LT((CRNEA - C).norm(), 1e-10 * C.norm());
+}
+
+TEST_F(GCRRDynamicsTest, rneaGravityTermMatchesReference) {
+    // g(q) = -sum over rigid bodies of Jp' m gravity
+    dVector g;
+    resize(g, gcrr->getDimensionSize());
+    V3D gravity = RBGlobals::worldUp * RBGlobals::g;
+    Matrix dpdq;
+    auto addRB = [&](const std::shared_ptr<const RB> &rb) {
+        gcrr->compute_dpdq(P3D(0, 0, 0), rb, dpdq);
+        g -= dpdq.transpose() * (rb->rbProps.mass * gravity);
+    };
+    addRB(robot->getRoot());
+    for (int i = 0; i < robot->getJointCount(); i++)
+        addRB(robot->getJoint(i)->child);
+
+    dVector withGravity, withoutGravity;
+    gcrr->computeBiasForcesRNEA(withGravity, true);
+    gcrr->computeBiasForcesRNEA(withoutGravity, false);
+
+    EXPECT_LT((withGravity - withoutGravity - g).norm(), 1e-10 * g.norm());
+}
+
+TEST_F(GCRRDynamicsTest, rneaInverseDynamicsMatchesMassMatrixAndBiasForces) {
+    dVector qDDot;
+    resize(qDDot, gcrr->getDimensionSize());
+    for (int i = 0; i < qDDot.size(); i++)
+        qDDot[i] = getRandomNumberInRange(-5.0, 5.0);
+
+    Matrix M;
+    dVector bias, tau;
+    gcrr->computeMassMatrixCRBA(M);
+    gcrr->computeBiasForcesRNEA(bias);
+    gcrr->computeInverseDynamicsRNEA(qDDot, tau);
+
+    dVector expected = M * qDDot + bias;
+    EXPECT_LT((tau - expected).norm(), 1e-10 * expected.norm());
+}
+
+}  // namespace crl::loco
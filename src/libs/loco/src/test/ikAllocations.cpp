@@ -0,0 +1,59 @@
+#include "allocationCounting.h"
+
+#include <gtest/gtest.h>
+
+#include "loco/kinematics/IK_Solver.h"
+#include "loco/robot/LeggedRobot.h"
+#include "menu.h"
+
+namespace crl::loco {
+
+/**
+ * Counts the heap allocations made by IK solves once the solver has warmed up,
+ * with the same targets (one per limb of Bob) that KinematicTrackingController
+ * adds every frame.
+ */
+int countSteadyStateAllocations(IK_TargetMode targetMode, int nFrames) {
+    auto robot = locoApp::loadRobot(*locoApp::findModelOption("Bob"));
+
+    std::vector<P3D> restPositions;
+    for (int i = 0; i < robot->getLimbCount(); i++)
+        restPositions.push_back(robot->getLimb(i)->getEEWorldPos());
+
+    IK_Solver solver(robot);
+    solver.setTargetMode(targetMode);
+
+    auto solveFrame = [&](int frame) {
+        // move every end effector a little, differently every frame
+        for (int i = 0; i < robot->getLimbCount(); i++) {
+            const auto &limb = robot->getLimb(i);
+            V3D offset(0.05 * sin(0.1 * frame + i), 0.03 * cos(0.2 * frame + i), 0.05 * sin(0.3 * frame));
+            solver.addEndEffectorTarget(limb->eeRB, limb->ee->endEffectorOffset, restPositions[i] + offset);
+        }
+        solver.solve();
+    };
+
+    // the first frames size all buffers
+    for (int frame = 0; frame < 3; frame++)
+        solveFrame(frame);
+
+    allocationCount = 0;
+    for (int frame = 3; frame < 3 + nFrames; frame++)
+        solveFrame(frame);
+
+    return allocationCount;
+}
+
+TEST(IKSolverTest, decomposedSolveDoesNotAllocate) {
+    EXPECT_EQ(countSteadyStateAllocations(IK_TargetMode::DECOMPOSED, 100), 0);
+}
+
+TEST(IKSolverTest, stackedSolveDoesNotAllocate) {
+    EXPECT_EQ(countSteadyStateAllocations(IK_TargetMode::STACKED, 100), 0);
+}
+
+TEST(IKSolverTest, sequentialSolveDoesNotAllocate) {
+    EXPECT_EQ(countSteadyStateAllocations(IK_TargetMode::SEQUENTIAL, 100), 0);
+}
+
+}  // namespace crl::loco
@@ -0,0 +1,435 @@
+#include <gtest/gtest.h>
+
+#include "loco/crowd/Crowd.h"
+#include "loco/planner/AsynchronousPlanner.h"
+#include "loco/planner/GaitPlanner.h"
+#include "loco/planner/SimpleLocomotionTrajectoryPlanner.h"
+#include "menu.h"
+
+#include <chrono>
+#include <thread>
+
+namespace crl::loco {
+
+/**
+ * Bob, with the limbs the locomotion app tracks, walking forward and turning.
+ */
+class PlannerTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        robot = loadRobot();
+    }
+
+    static std::shared_ptr<LeggedRobot> loadRobot() {
+        return locoApp::loadRobot(*locoApp::findModelOption("Bob"));
+    }
+
+    std::shared_ptr<SimpleLocomotionTrajectoryPlanner> makePlanner() {
+        return makePlanner(robot);
+    }
+
+    std::shared_ptr<SimpleLocomotionTrajectoryPlanner> makePlanner(const std::shared_ptr<LeggedRobot> &robot) {
+        auto planner = std::make_shared<SimpleLocomotionTrajectoryPlanner>(robot);
+        planner->trunkHeight = 0.9;
+        planner->speedForward = 1.0;
+        planner->turningSpeed = 0.3;
+        return planner;
+    }
+
+    void replan(SimpleLocomotionTrajectoryPlanner &planner) {
+        planner.advanceInTime(1 / 30.0);
+        planner.appendPeriodicGaitIfNeeded(gaitPlanner);
+        planner.generateTrajectoriesFromCurrentState();
+    }
+
+    std::shared_ptr<LeggedRobot> robot;
+    BipedalGaitPlanner gaitPlanner;
+};
+
+TEST_F(PlannerTest, parallelLimbTrajectoriesMatchSerialOnes) {
+    auto planner = makePlanner();
+    auto threadPool = std::make_shared<ThreadPool>(4);
+
+    for (int k = 0; k < 30; k++) {
+        replan(*planner);
+        std::vector<P3D> expected;
+        for (int i = 0; i < robot->getLimbCount(); i++)
+            for (double t = planner->simTime; t < planner->simTime + planner->tPlanningHorizon; t += 0.01)
+                expected.push_back(planner->getTargetLimbEEPositionAtTime(robot->getLimb(i), t));
+
+        // plan again from the same state, in parallel this time
+        planner->threadPool = threadPool;
+        planner->generateTrajectoriesFromCurrentState();
+        planner->threadPool = nullptr;
+
+        int j = 0;
+        for (int i = 0; i < robot->getLimbCount(); i++)
+            for (double t = planner->simTime; t < planner->simTime + planner->tPlanningHorizon; t += 0.01) {
+                P3D p = planner->getTargetLimbEEPositionAtTime(robot->getLimb(i), t);
+                // bit for bit
+                ASSERT_EQ(p.x, expected[j].x);
+                ASSERT_EQ(p.y, expected[j].y);
+                ASSERT_EQ(p.z, expected[j].z);
+                j++;
+            }
+    }
+}
+
+TEST_F(PlannerTest, extendedPlansMatchPlansGeneratedAtOnce) {
+    const int nFrames = 20;
+
+    // both planners share the contact schedule, long enough for all frames,
+    // and plan from the same (standing) state of the robot
+    auto incrementalPlanner = makePlanner();
+    auto planner = makePlanner();
+    for (auto p : {incrementalPlanner, planner}) {
+        p->advanceInTime(1 / 30.0);
+        for (int i = 0; i < 5; i++)
+            p->appendPeriodicGait(gaitPlanner.getPeriodicGait(robot, *p->gaitParameters, p->speedForward));
+    }
+
+    incrementalPlanner->incrementalReplanning = true;
+    incrementalPlanner->generateTrajectoriesFromCurrentState();
+    int nKnotsFullPlan = incrementalPlanner->getRecomputedKnotCount();
+    for (int k = 0; k < nFrames; k++) {
+        incrementalPlanner->advanceInTime(1 / 30.0);
+        incrementalPlanner->generateTrajectoriesFromCurrentState();
+        EXPECT_LT(incrementalPlanner->getRecomputedKnotCount(), nKnotsFullPlan / 5);
+    }
+
+    // the other one plans the whole time span in one go
+    planner->tPlanningHorizon += nFrames / 30.0;
+    planner->generateTrajectoriesFromCurrentState();
+
+    double tEnd = incrementalPlanner->simTime + incrementalPlanner->tPlanningHorizon - 0.05;
+    for (double t = incrementalPlanner->simTime; t < tEnd; t += 0.01) {
+        EXPECT_LT(V3D(planner->getTargetTrunkPositionAtTime(t), incrementalPlanner->getTargetTrunkPositionAtTime(t)).norm(), 1e-10);
+        for (int i = 0; i < robot->getLimbCount(); i++)
+            EXPECT_LT(V3D(planner->getTargetLimbEEPositionAtTime(robot->getLimb(i), t),
+                          incrementalPlanner->getTargetLimbEEPositionAtTime(robot->getLimb(i), t))
+                          .norm(),
+                      1e-10);
+    }
+}
+
+TEST_F(PlannerTest, changedTargetsTriggerAFullReplan) {
+    auto planner = makePlanner();
+    planner->incrementalReplanning = true;
+    for (int k = 0; k < 10; k++)
+        replan(*planner);
+
+    planner->speedForward = 0.5;
+    replan(*planner);
+    std::vector<P3D> expected;
+    for (int i = 0; i < robot->getLimbCount(); i++)
+        for (double t = planner->simTime; t < planner->simTime + planner->tPlanningHorizon; t += 0.01)
+            expected.push_back(planner->getTargetLimbEEPositionAtTime(robot->getLimb(i), t));
+
+    // plan again from the same state, without reusing anything
+    int nKnots = planner->getRecomputedKnotCount();
+    planner->incrementalReplanning = false;
+    planner->generateTrajectoriesFromCurrentState();
+    EXPECT_EQ(planner->getRecomputedKnotCount(), nKnots);
+
+    int j = 0;
+    for (int i = 0; i < robot->getLimbCount(); i++)
+        for (double t = planner->simTime; t < planner->simTime + planner->tPlanningHorizon; t += 0.01) {
+            P3D p = planner->getTargetLimbEEPositionAtTime(robot->getLimb(i), t);
+            ASSERT_EQ(p.x, expected[j].x);
+            ASSERT_EQ(p.y, expected[j].y);
+            ASSERT_EQ(p.z, expected[j].z);
+            j++;
+        }
+}
+
+TEST_F(PlannerTest, rebakedGroundTriggersAFullReplan) {
+    // a flat square around where bob walks, baked twice into the same height field
+    std::vector<P3D> vertices = {P3D(-10, 0, -10), P3D(10, 0, -10), P3D(10, 0, 10), P3D(-10, 0, 10)};
+    std::vector<int> triangles = {0, 1, 2, 0, 2, 3};
+    auto ground = std::make_shared<HeightField>();
+    ground->bake(vertices, triangles);
+
+    auto planner = makePlanner();
+    planner->setGround(ground);
+    planner->incrementalReplanning = true;
+    for (int k = 0; k < 10; k++)
+        replan(*planner);
+
+    for (auto &v : vertices)
+        v.y = 0.1;
+    ground->bake(vertices, triangles);
+    replan(*planner);
+    std::vector<P3D> expected;
+    for (int i = 0; i < robot->getLimbCount(); i++)
+        for (double t = planner->simTime; t < planner->simTime + planner->tPlanningHorizon; t += 0.01)
+            expected.push_back(planner->getTargetLimbEEPositionAtTime(robot->getLimb(i), t));
+
+    // plan again from the same state, without reusing anything
+    int nKnots = planner->getRecomputedKnotCount();
+    planner->incrementalReplanning = false;
+    planner->generateTrajectoriesFromCurrentState();
+    EXPECT_EQ(planner->getRecomputedKnotCount(), nKnots);
+
+    int j = 0;
+    for (int i = 0; i < robot->getLimbCount(); i++)
+        for (double t = planner->simTime; t < planner->simTime + planner->tPlanningHorizon; t += 0.01) {
+            P3D p = planner->getTargetLimbEEPositionAtTime(robot->getLimb(i), t);
+            ASSERT_EQ(p.x, expected[j].x);
+            ASSERT_EQ(p.y, expected[j].y);
+            ASSERT_EQ(p.z, expected[j].z);
+            j++;
+        }
+}
+
+TEST_F(PlannerTest, contactScheduleQueriesMatchALinearScan) {
+    ContactSchedule cs;
+    const auto &limb = robot->getLimb(0);
+    cs.addSwingPhaseForLimb(limb, 0.2, 0.5);
+    // merged with the previous swing phase
+    cs.addSwingPhaseForLimb(limb, 0.5, 0.6);
+    cs.addSwingPhaseForLimb(limb, 1.0, 1.3);
+    cs.addSwingPhaseForLimb(limb, 1.5, 1.7);
+    cs.addSwingPhaseForLimb(limb, 2.5, 2.6);
+    ASSERT_EQ(cs.getSwingPhaseContainerForLimb(limb)->swingPhases.size(), 4);
+
+    // what the schedule should say at t, found by going through all the swing phases
+    auto expected = [&](double t) {
+        const auto &swingPhases = cs.getSwingPhaseContainerForLimb(limb)->swingPhases;
+        if (t < swingPhases.front().first)
+            return ContactPhaseInfo(false, swingPhases.front().first - t, swingPhases.front().first - t);
+        for (uint i = 0; i < swingPhases.size(); i++) {
+            if (t <= swingPhases[i].second)
+                return ContactPhaseInfo(true, swingPhases[i].second - swingPhases[i].first, swingPhases[i].second - t);
+            if (i + 1 < swingPhases.size() && t <= swingPhases[i + 1].first)
+                return ContactPhaseInfo(false, swingPhases[i + 1].first - swingPhases[i].second, swingPhases[i + 1].first - t);
+        }
+        return ContactPhaseInfo(false, 100, 50);
+    };
+    auto expectSame = [](const ContactPhaseInfo &a, const ContactPhaseInfo &b, double t) {
+        EXPECT_EQ(a.isSwing(), b.isSwing()) << "t = " << t;
+        EXPECT_EQ(a.getDuration(), b.getDuration()) << "t = " << t;
+        EXPECT_EQ(a.getTimeLeft(), b.getTimeLeft()) << "t = " << t;
+    };
+
+    // on and around the ends of the swing phases, and in between
+    std::vector<double> ts = {0, 0.2, 0.6, 1.0, 1.3, 1.5, 1.7, 2.5, 2.6, 3};
+    for (double t = -0.1; t < 3; t += 0.01)
+        ts.push_back(t);
+    std::sort(ts.begin(), ts.end());
+
+    ContactPhaseCursor cursor(cs, limb);
+    for (double t : ts) {
+        expectSame(cs.getContactPhaseInformation(limb, t), expected(t), t);
+        expectSame(cursor.getContactPhaseInformation(t), expected(t), t);
+    }
+    // going back in time
+    for (auto t = ts.rbegin(); t != ts.rend(); t++)
+        expectSame(cursor.getContactPhaseInformation(*t), expected(*t), *t);
+
+    // limbs without swing phases are always in stance
+    EXPECT_TRUE(cs.getContactPhaseInformation(robot->getLimb(1), 1.1).isStance());
+    EXPECT_TRUE(ContactPhaseCursor(cs, robot->getLimb(1)).getContactPhaseInformation(1.1).isStance());
+
+    // swing phases that are over are dropped, the others stay as they are
+    cs.getSwingPhaseContainerForLimb(limb)->clearSwingPhasesBefore(1.4);
+    ASSERT_EQ(cs.getSwingPhaseContainerForLimb(limb)->swingPhases.size(), 2);
+    EXPECT_EQ(cs.getSwingPhaseContainerForLimb(limb)->swingPhases.front().first, 1.5);
+}
+
+TEST_F(PlannerTest, contactTimelinesMatchTheSchedule) {
+    ContactPlanManager cpm;
+    const auto &limb = robot->getLimb(0);
+    cpm.cs.addSwingPhaseForLimb(limb, 0.2, 0.5);
+    cpm.cs.addSwingPhaseForLimb(limb, 1.0, 1.3);
+    cpm.cs.addSwingPhaseForLimb(robot->getLimb(1), 0.7, 0.9);
+
+    const double dt = 1 / 30.0;
+    const ContactTimeline &timeline = cpm.getTimeline(0.6, dt, 30);
+
+    // every query a cursor makes, at the sample times or not, is answered the
+    // same as by the schedule
+    auto expectCursorsMatchTheSchedule = [&]() {
+        std::vector<double> ts = timeline.times;
+        for (double t = 0; t < 2; t += 0.01)
+            ts.push_back(t);
+        std::sort(ts.begin(), ts.end());
+        for (int i = 0; i < 3; i++) {
+            ContactPhaseCursor cursor = cpm.getCPCursorFor(robot->getLimb(i));
+            for (double t : ts) {
+                ContactPhaseInfo a = cursor.getContactPhaseInformation(t);
+                ContactPhaseInfo b = cpm.getCPInformationFor(robot->getLimb(i), t);
+                EXPECT_EQ(a.isSwing(), b.isSwing()) << "limb " << i << ", t = " << t;
+                EXPECT_EQ(a.getDuration(), b.getDuration()) << "limb " << i << ", t = " << t;
+                EXPECT_EQ(a.getTimeLeft(), b.getTimeLeft()) << "limb " << i << ", t = " << t;
+            }
+        }
+    };
+
+    ASSERT_EQ(timeline.times.size(), 30);
+    for (int k = 0; k < 30; k++) {
+        for (int i = 0; i < 2; i++) {
+            ContactPhaseInfo cpi = cpm.getCPInformationFor(robot->getLimb(i), timeline.times[k]);
+            EXPECT_EQ(timeline.isSwing[i][k] != 0, cpi.isSwing());
+            EXPECT_EQ(timeline.duration[i][k], cpi.getDuration());
+            EXPECT_EQ(timeline.timeLeft[i][k], cpi.getTimeLeft());
+            EXPECT_EQ(timeline.progress[i][k], cpi.getPercentageOfTimeElapsed());
+        }
+        EXPECT_EQ(timeline.getSampleIndex(timeline.times[k]), k);
+    }
+    // limbs without swing phases are not sampled
+    EXPECT_FALSE(timeline.hasSamplesFor(2));
+    expectCursorsMatchTheSchedule();
+
+    // samples are not taken again for times that were sampled already
+    cpm.getTimeline(timeline.times[5], dt, 25);
+    EXPECT_EQ(timeline.tStart, 0.6);
+
+    // cursors do not use samples the schedule changed under, be it because
+    // a swing phase was added...
+    cpm.cs.addSwingPhaseForLimb(limb, 1.6, 1.8);
+    expectCursorsMatchTheSchedule();
+    cpm.getTimeline(0.6, dt, 30);
+    // ...or because the swing phase right before the first sample was dropped,
+    // which the stance phase that follows it was measured from
+    cpm.tidyUp(0.55);
+    expectCursorsMatchTheSchedule();
+}
+
+TEST_F(PlannerTest, asynchronousPlansMatchSynchronousOnes) {
+    const int nPlans = 5;
+    const double dt = 1 / 30.0;
+
+    auto reference = makePlanner();
+    std::vector<LocomotionPlan> referencePlans(nPlans);
+    for (auto &referencePlan : referencePlans) {
+        reference->advanceInTime(dt);
+        reference->appendPeriodicGaitIfNeeded(gaitPlanner);
+        reference->generateTrajectoriesFromCurrentState(dt);
+        referencePlan.sample(*reference, dt);
+    }
+
+    // the planner thread plans for its own copy of the robot
+    auto targets = makePlanner();
+    AsynchronousPlanner asyncPlanner(makePlanner(loadRobot()), std::make_shared<BipedalGaitPlanner>(), 1000);
+
+    for (int k = 1; k <= nPlans; k++) {
+        targets->advanceInTime(dt);
+        asyncPlanner.requestPlan(*robot, *targets, dt);
+
+        // the first plan is there right away, the others once the planner
+        // thread gets to them
+        auto start = std::chrono::steady_clock::now();
+        while (asyncPlanner.getLatestPlan().version < k && std::chrono::steady_clock::now() - start < std::chrono::seconds(10))
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        const LocomotionPlan &plan = asyncPlanner.getLatestPlan();
+        const LocomotionPlan &referencePlan = referencePlans[k - 1];
+        ASSERT_EQ(plan.version, k);
+        EXPECT_EQ(plan.planGenerationTime, referencePlan.planGenerationTime);
+        EXPECT_EQ(&asyncPlanner.getTrackedPlan(), &plan);
+        EXPECT_EQ(asyncPlanner.getPublishedPlanVersion(), k);
+        EXPECT_EQ(asyncPlanner.getPublishedPlanGenerationTime(), plan.planGenerationTime);
+
+        ASSERT_EQ(plan.trunkPositions.getKnotCount(), referencePlan.trunkPositions.getKnotCount());
+        for (int j = 0; j < plan.trunkPositions.getKnotCount(); j++) {
+            double t = plan.trunkPositions.getKnotPosition(j);
+            EXPECT_LT(V3D(plan.getTargetTrunkPositionAtTime(t), referencePlan.getTargetTrunkPositionAtTime(t)).norm(), 1e-9);
+            EXPECT_LT(plan.getTargetTrunkOrientationAtTime(t).angularDistance(referencePlan.getTargetTrunkOrientationAtTime(t)), 1e-9);
+            for (int i = 0; i < robot->getLimbCount(); i++)
+                EXPECT_LT(V3D(plan.getTargetLimbEEPositionAtTime(robot->getLimb(i), t), referencePlan.getTargetLimbEEPositionAtTime(robot->getLimb(i), t)).norm(),
+                          1e-9);
+        }
+    }
+
+    // without new requests, there are no new plans
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_EQ(asyncPlanner.getLatestPlan().version, nPlans);
+}
+
+TEST_F(PlannerTest, gaitParametersAreTabulatedPerCharacter) {
+    // the curves are linear in between the walk to run transition and
+    // initSpeed, so the tables are exact away from them
+    // (the default strides follow Nilsson et al. (1985))
+    GaitParameters gait;
+    for (double speed = 0; speed <= gait.getMaxSpeed(); speed += 0.0137) {
+        if (std::abs(speed - gait.getWalkToRunTransitionSpeed()) < gait.getSpeedStep() || std::abs(speed - gait.getInitSpeed()) < gait.getSpeedStep())
+            continue;
+        bool walking = speed < gait.getWalkToRunTransitionSpeed();
+        double strideDuration = walking ? -0.419 * speed + 1.927 : -0.041 * speed + 0.901;
+        double swingPhaseDuration = walking ? (3.4 * std::max(speed, gait.getInitSpeed()) + 37.1) / 100.0 : 0.6;
+        EXPECT_NEAR(gait.getStrideDuration(speed), strideDuration, 1e-12) << speed;
+        EXPECT_NEAR(gait.getRelativeSwingPhaseDuration(speed), swingPhaseDuration, 1e-12) << speed;
+    }
+    EXPECT_EQ(gait.getStrideDuration(-1), gait.getStrideDuration(0));
+    EXPECT_EQ(gait.getStrideDuration(2 * gait.getMaxSpeed()), gait.getStrideDuration(gait.getMaxSpeed()));
+
+    // setting a parameter updates the tables
+    gait.setWalkToRunTransitionSpeed(3);
+    EXPECT_NEAR(gait.getStrideDuration(2.5), -0.419 * 2.5 + 1.927, 1e-12);
+    EXPECT_NEAR(gait.getRelativeSwingPhaseDuration(2.5), (3.4 * 2.5 + 37.1) / 100.0, 1e-12);
+
+    // two characters, with strides of their own
+    auto slow = makePlanner(loadRobot());
+    auto fast = makePlanner(loadRobot());
+    auto fastGait = std::make_shared<GaitParameters>();
+    fastGait->setWalkingStrideDuration(-0.419, 1.5);
+    fast->gaitParameters = fastGait;
+    for (auto p : {slow, fast}) {
+        p->appendPeriodicGait(gaitPlanner.getPeriodicGait(p->robot, *p->gaitParameters, p->speedForward));
+        p->generateTrajectoriesFromCurrentState();
+    }
+    double speed = slow->speedForward;
+    EXPECT_DOUBLE_EQ(slow->cpm.timeUntilEndOfPlanningHorizon(0), GaitParameters().getStrideDuration(speed));
+    EXPECT_DOUBLE_EQ(fast->cpm.timeUntilEndOfPlanningHorizon(0), 1.5 - 0.419 * speed);
+}
+
+TEST_F(PlannerTest, crowdCharactersWalkAsIfTheyWereAlone) {
+    const int nCharacters = 3;
+    const int nSteps = 60;
+    const double dt = 1 / 60.0;
+    auto speed = [](int i) { return 0.6 + 0.5 * i; };
+
+    Crowd crowd(4);
+    crowd.stepsPerPlan = 2;
+    for (int i = 0; i < nCharacters; i++) {
+        auto robot = loadRobot();
+        robot->setRootState(P3D(2.0 * i, 0.9, 0));
+        crowd.addCharacter(robot, std::make_shared<BipedalGaitPlanner>(), 0.9, 1.0, speed(i));
+    }
+    for (int k = 0; k < nSteps; k++)
+        crowd.step(dt);
+    EXPECT_EQ(crowd.getStepCount(), nSteps);
+
+    // every character on its own, one after the other, replanning on the
+    // same steps
+    for (int i = 0; i < nCharacters; i++) {
+        auto robot = loadRobot();
+        robot->setRootState(P3D(2.0 * i, 0.9, 0));
+        auto planner = std::make_shared<SimpleLocomotionTrajectoryPlanner>(robot);
+        planner->trunkHeight = 0.9;
+        planner->targetStepHeight = 1.0;
+        planner->speedForward = speed(i);
+        KinematicTrackingController controller(planner);
+        auto plan = [&]() {
+            planner->appendPeriodicGaitIfNeeded(gaitPlanner);
+            controller.generateMotionTrajectories();
+        };
+        plan();
+        for (int k = 1; k <= nSteps; k++) {
+            controller.computeAndApplyControlSignals(dt);
+            controller.advanceInTime(dt);
+            if ((k + i) % 2 == 0)
+                plan();
+        }
+
+        const auto &character = crowd.getCharacter(i).robot;
+        P3D pos = character->getTrunk()->getWorldCoordinates(P3D());
+        EXPECT_EQ(V3D(pos, robot->getTrunk()->getWorldCoordinates(P3D())).norm(), 0);
+        for (int j = 0; j < robot->getJointCount(); j++)
+            EXPECT_EQ(character->getJoint(j)->getCurrentJointAngle(), robot->getJoint(j)->getCurrentJointAngle());
+
+        // and at its own speed
+        EXPECT_NEAR(pos.z, speed(i) * nSteps * dt, 0.1 * speed(i));
+    }
+}
+
+}  // namespace crl::loco
@@ -0,0 +1,48 @@
+#include "allocationCounting.h"
+
+#include <gtest/gtest.h>
+
+#include "loco/planner/GaitPlanner.h"
+#include "loco/planner/SimpleLocomotionTrajectoryPlanner.h"
+#include "menu.h"
+
+namespace crl::loco {
+
+/**
+ * Counts the heap allocations made per replan of Bob (with the limbs the
+ * locomotion app tracks) walking forward, once the planner has warmed up.
+ */
+int countAllocationsPerReplan(int nReplans) {
+    auto robot = locoApp::loadRobot(*locoApp::findModelOption("Bob"));
+
+    SimpleLocomotionTrajectoryPlanner planner(robot);
+    planner.trunkHeight = 0.9;
+    planner.speedForward = 1.0;
+    BipedalGaitPlanner gaitPlanner;
+
+    auto replan = [&]() {
+        planner.advanceInTime(1 / 30.0);
+        planner.appendPeriodicGaitIfNeeded(gaitPlanner);
+        planner.generateTrajectoriesFromCurrentState();
+    };
+
+    // the first replans fill the contact schedule and size all buffers
+    for (int i = 0; i < 3; i++)
+        replan();
+
+    allocationCount = 0;
+    for (int i = 0; i < nReplans; i++)
+        replan();
+
+    return allocationCount / nReplans;
+}
+
+TEST(PlannerTest, replanningDoesNotCopyPlans) {
+    // the footstep plan (ground model included) and the body frame
+    // trajectories are no longer passed around by value. A replan still makes
+    // about 400 allocations (those of Eigen included), mostly for the limb
+    // motion properties that are rebuilt every time
+    EXPECT_LE(countAllocationsPerReplan(20), 420);
+}
+
+}  // namespace crl::loco
@@ -0,0 +1,137 @@
+#include <gtest/gtest.h>
+
+#include "loco/robot/GeneralizedCoordinatesRobotRepresentation.h"
+#include "loco/robot/Robot.h"
+
+namespace crl::loco {
+
+/**
+ * Bob, with every dof (root included) moved away from the rest pose and a
+ * random generalized velocity.
+ */
+class RobotStateTest : public ::testing::Test {
+protected:
+    void SetUp() override {
+        robot = std::make_shared<Robot>(CRL_DATA_FOLDER "/robots/bob/bob_RB.rbs");
+        robot->setRootState(P3D(0, 0.9, 0));
+        gcrr = std::make_shared<GCRR>(robot);
+
+        srand(0);
+        dVector q, qDot;
+        gcrr->getQ(q);
+        resize(qDot, q.size());
+        for (int i = 0; i < q.size(); i++) {
+            q[i] += getRandomNumberInRange(-0.5, 0.5);
+            qDot[i] = getRandomNumberInRange(-2.0, 2.0);
+        }
+        gcrr->setQ(q);
+        gcrr->setQDot(qDot);
+        gcrr->syncRobotStateWithGeneralizedCoordinates();
+    }
+
+    /**
+     * the child of joint, placed relative to its parent one rigid body at a
+     * time, through the getters and setters of the rigid bodies
+     */
+    static void fixJointConstraints(RBJoint &joint) {
+        const auto &parent = joint.parent;
+        const auto &child = joint.child;
+
+        // keep only the rotation about the axis of the joint
+        Quaternion qRel = joint.computeRelativeOrientation();
+        V3D axis = qRel.vec().normalized();
+        double ang = axis.dot(joint.rotationAxis) * getRotationAngle(qRel, axis);
+        child->setOrientation(parent->getOrientation() * getRotationQuaternion(ang, joint.rotationAxis));
+
+        V3D rc = child->getWorldCoordinates(V3D(joint.cJPos, P3D(0, 0, 0)));
+        V3D rp = parent->getWorldCoordinates(V3D(joint.pJPos, P3D(0, 0, 0)));
+        child->setPosition(parent->getWorldCoordinates(P3D()) + (rc - rp));
+
+        V3D wRel = child->getAngularVelocity() - parent->getAngularVelocity();
+        V3D worldRotAxis = parent->getWorldCoordinates(joint.rotationAxis);
+        child->setAngularVelocity(parent->getAngularVelocity() + worldRotAxis * wRel.dot(worldRotAxis));
+
+        V3D pJPosVel = parent->getVelocityForPoint_local(joint.pJPos);
+        V3D cJPosVel = child->getVelocityForPoint_local(joint.cJPos);
+        child->setVelocity(child->getVelocityForPoint_local(P3D()) - (cJPosVel - pJPosVel));
+    }
+
+    std::shared_ptr<Robot> robot;
+    std::shared_ptr<GCRR> gcrr;
+};
+
+TEST_F(RobotStateTest, interpolatedStatesGoFromOneStateToTheOther) {
+    RobotState a(*robot);
+    dVector q;
+    gcrr->getQ(q);
+    for (int i = 0; i < q.size(); i++)
+        q[i] += getRandomNumberInRange(-0.5, 0.5);
+    gcrr->setQ(q);
+    gcrr->syncRobotStateWithGeneralizedCoordinates();
+    RobotState b(*robot);
+    ASSERT_FALSE(a == b);
+
+    EXPECT_TRUE(RobotState::interpolate(a, b, 0) == a);
+    EXPECT_TRUE(RobotState::interpolate(a, b, 1) == b);
+
+    // half way, every joint is rotated by as much from a as from b
+    RobotState m = RobotState::interpolate(a, b, 0.5);
+    EXPECT_GT(V3D(a.getPosition(), b.getPosition()).norm(), 0);
+    EXPECT_NEAR(V3D(a.getPosition(), m.getPosition()).norm(), V3D(m.getPosition(), b.getPosition()).norm(), 1e-10);
+    for (int i = 0; i < m.getJointCount(); i++) {
+        double fromA = m.getJointRelativeOrientation(i).angularDistance(a.getJointRelativeOrientation(i));
+        double toB = m.getJointRelativeOrientation(i).angularDistance(b.getJointRelativeOrientation(i));
+        EXPECT_NEAR(fromA, toB, 1e-10);
+    }
+}
+
+TEST_F(RobotStateTest, stateStoreKernelsMatchPerBodyUpdates) {
+    // every rigid body is a view into the store of the robot
+    const RBStateStore &store = *robot->getStateStore();
+    EXPECT_EQ(store.getBodyCount(), robot->getRigidBodyCount());
+    for (int i = 0; i < robot->getRigidBodyCount(); i++) {
+        EXPECT_EQ(robot->getRigidBody(i)->getStateStore().get(), &store);
+        EXPECT_EQ(robot->getRigidBody(i)->getStateId(), i);
+    }
+    EXPECT_EQ((uintptr_t)store.positions.data() % 64, 0u);
+    EXPECT_EQ((uintptr_t)store.orientations.data() % 64, 0u);
+
+    // off the axes of the joints, for setState to project away
+    RobotState state(*robot);
+    for (int i = 0; i < state.getJointCount(); i++)
+        state.setJointRelativeAngVelocity(V3D(getRandomNumberInRange(-2.0, 2.0), getRandomNumberInRange(-2.0, 2.0), 0), i);
+
+    // setState, and the same, one body at a time
+    Robot bulk(CRL_DATA_FOLDER "/robots/bob/bob_RB.rbs");
+    bulk.setState(state);
+    Robot perBody(CRL_DATA_FOLDER "/robots/bob/bob_RB.rbs");
+    perBody.getRoot()->setPosition(state.getPosition());
+    perBody.getRoot()->setOrientation(state.getOrientation());
+    perBody.getRoot()->setVelocity(state.getVelocity());
+    perBody.getRoot()->setAngularVelocity(state.getAngularVelocity());
+    for (int j = 0; j < perBody.getJointCount(); j++) {
+        Robot::setRelativeOrientationForJoint(perBody.getJoint(j), state.getJointRelativeOrientation(j).normalized());
+        Robot::setRelativeLocalCoordsAngularVelocityForJoint(perBody.getJoint(j), state.getJointRelativeAngVelocity(j));
+        fixJointConstraints(*perBody.getJoint(j));
+    }
+
+    for (int i = 0; i < bulk.getRigidBodyCount(); i++) {
+        RBState a = bulk.getRigidBody(i)->getState(), b = perBody.getRigidBody(i)->getState();
+        EXPECT_LT(V3D(a.pos, b.pos).norm(), 1e-10);
+        EXPECT_LT(a.orientation.angularDistance(b.orientation), 1e-10);
+        EXPECT_LT((a.velocity - b.velocity).norm(), 1e-10);
+        EXPECT_LT((a.angularVelocity - b.angularVelocity).norm(), 1e-10);
+    }
+
+    // and back
+    RobotState populated(bulk);
+    EXPECT_LT(V3D(populated.getPosition(), state.getPosition()).norm(), 1e-10);
+    for (int j = 0; j < bulk.getJointCount(); j++) {
+        const auto &joint = perBody.getJoint(j);
+        V3D wRel = joint->parent->getLocalCoordinates(V3D(joint->child->getAngularVelocity() - joint->parent->getAngularVelocity()));
+        EXPECT_LT(populated.getJointRelativeOrientation(j).angularDistance(state.getJointRelativeOrientation(j)), 1e-10);
+        EXPECT_LT((populated.getJointRelativeAngVelocity(j) - wRel).norm(), 1e-10);
+    }
+}
+
+}  // namespace crl::loco
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+
+#include "loco/robot/Robot.h"
+#include "loco/robot/RobotStateBuffer.h"
+
+#include <atomic>
+#include <thread>
+
+namespace crl::loco {
+
+namespace {
+
+// the state the simulated robot is in at step k: every joint rotated by an
+// angle that depends on k, and the root k cm forward
+RobotState stateAtStep(Robot &robot, long k) {
+    RobotState state(robot);
+    state.setPosition(P3D(0.01 * k, 0.9, 0));
+    for (int i = 0; i < robot.getJointCount(); i++)
+        state.setJointRelativeOrientation(getRotationQuaternion(0.5 * std::sin(0.01 * k + i), robot.getJoint(i)->rotationAxis), i);
+    return state;
+}
+
+// the step the robot was drawn at, or -1 if its joints and its root are not
+// all at the same step
+long drawnStep(Robot &robot) {
+    RobotState drawn(robot);
+    long k = std::lround(drawn.getPosition().x / 0.01);
+    for (int i = 0; i < robot.getJointCount(); i++) {
+        Quaternion expected = getRotationQuaternion(0.5 * std::sin(0.01 * k + i), robot.getJoint(i)->rotationAxis);
+        if (drawn.getJointRelativeOrientation(i).angularDistance(expected) > 1e-8)
+            return -1;
+    }
+    return k;
+}
+
+}  // namespace
+
+TEST(RobotStateBufferTest, drawnStatesAreNeverTorn) {
+    const long nSteps = 20000;
+    Robot simulated(CRL_DATA_FOLDER "/robots/bob/bob_RB.rbs");
+    Robot drawn(CRL_DATA_FOLDER "/robots/bob/bob_RB.rbs");
+    RobotStateBuffer buffer;
+
+    // nothing to draw yet
+    EXPECT_FALSE(buffer.update());
+    buffer.apply(drawn, 1);
+
+    std::atomic<bool> simulationDone(false);
+    std::thread simulation([&]() {
+        for (long k = 1; k <= nSteps; k++) {
+            simulated.setState(stateAtStep(simulated, k));
+            buffer.publish(simulated);
+        }
+        simulationDone = true;
+    });
+
+    long lastStep = 0;
+    int nTorn = 0, nBackwards = 0, nFrames = 0;
+    while (true) {
+        bool done = simulationDone;
+        if (!buffer.update()) {
+            if (done)
+                break;
+            continue;
+        }
+        const auto &snapshot = buffer.getSnapshot();
+        nFrames++;
+
+        // the previous state is the one of the step before
+        buffer.apply(drawn, 0);
+        if (drawnStep(drawn) != std::max(snapshot.version - 1, 1L))
+            nTorn++;
+
+        buffer.apply(drawn, 1);
+        long k = drawnStep(drawn);
+        if (k != snapshot.version)
+            nTorn++;
+        if (k <= lastStep)
+            nBackwards++;
+        lastStep = snapshot.version;
+    }
+    simulation.join();
+
+    EXPECT_GT(nFrames, 0);
+    EXPECT_EQ(lastStep, nSteps);
+    EXPECT_EQ(nTorn, 0);
+    EXPECT_EQ(nBackwards, 0);
+}
+
+}  // namespace crl::loco
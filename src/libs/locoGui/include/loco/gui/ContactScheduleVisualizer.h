@@ -0,0 +1,27 @@
+#pragma once
+
+#include <loco/planner/FootFallPattern.h>
+
+namespace crl::loco {
+
+/**
+ * Draws the contact schedule of a ContactPlanManager, with Dear ImGui.
+ */
+class ContactScheduleVisualizer {
+public:
+    // visualization options here...
+    double visTimeWindow = 3;
+    // this is the overall window width we want for the visualizer...
+    double cpmWindowWidth = 1300;
+    double labelWindowWidth = 50;
+    bool drawLabels = true;
+
+public:
+    // use Dear ImGUI code to visualize the contact schedule of cpm at time t...
+    void visualize(const ContactPlanManager &cpm, double t, double gridStartTime = -1, double dt_grid = 1 / 30.0, int nGridSteps = 30);
+
+private:
+    float getWindowCoord(double tVal, double tStart, double tEnd) const;
+};
+
+}  // namespace crl::loco
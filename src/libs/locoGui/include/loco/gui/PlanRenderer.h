@@ -0,0 +1,17 @@
+#pragma once
+
+#include <crl-basic/gui/shader.h>
+
+#include "loco/planner/LocomotionPlan.h"
+
+namespace crl::loco {
+
+class PlanRenderer {
+public:
+    /**
+     * draws the knots of the trunk and limb trajectories of the plan
+     */
+    static void drawTrajectories(const LocomotionPlan &plan, const gui::Shader &shader);
+};
+
+}  // namespace crl::loco
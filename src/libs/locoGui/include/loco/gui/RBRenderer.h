@@ -4,11 +4,17 @@
 #include <crl-basic/gui/shader.h>
 
 #include "loco/robot/RBJoint.h"
+#include "loco/robot/Robot.h"
 
 namespace crl::loco {
 
 class RBRenderer {
 public:
+    /**
+     * draws the robot at its current state, with the views its options show
+     */
+    static void drawRobot(const Robot &robot, const gui::Shader &shader, float alpha = 1.0);
+
     /* methods used to draw different types of views of the rigid body... */
     static void drawSkeletonView(const std::shared_ptr<const RB> &rb, const gui::Shader &shader, bool showJointAxes, bool showJointLimits, bool showJointAngle,
                                  float alpha = 1.0);
@@ -37,6 +43,23 @@ public:
      * draw joint angle
      */
     static void drawJointAngle(const std::shared_ptr<const RBJoint> &j, const gui::Shader &shader);
+
+    /**
+     * returns true if the meshes (checkMeshes) or the abstract view
+     * (checkSkeleton) of the rigid body are hit, false otherwise.
+     */
+    static bool getRayIntersectionPoint(const std::shared_ptr<const RB> &rb, const Ray &ray, P3D &intersectionPoint, bool checkMeshes, bool checkSkeleton);
+
+    /**
+     * returns NULL if no RBs are hit by the ray...
+     */
+    static std::shared_ptr<RB> getFirstRBHitByRay(const Robot &robot, const Ray &ray, P3D &intersectionPoint, bool checkMeshes, bool checkSkeleton);
+
+private:
+    /**
+     * the mesh m describes, placed where it is on the rigid body
+     */
+    static const gui::Model &getModel(const std::shared_ptr<const RB> &rb, const RB3DModel &m);
 };
 
 }  // namespace crl::loco
\ No newline at end of file
@@ -0,0 +1,16 @@
+#include "loco/gui/PlanRenderer.h"
+
+#include "crl-basic/gui/renderer.h"
+
+namespace crl::loco {
+
+void PlanRenderer::drawTrajectories(const LocomotionPlan &plan, const gui::Shader &shader) {
+    for (int i = 0; i < plan.trunkPositions.getKnotCount(); i++)
+        drawSphere(P3D() + plan.trunkPositions.getKnotValue(i), 0.02, shader);
+
+    for (uint i = 0; i < plan.limbPositions.size(); i++)
+        for (int j = 0; j < plan.limbPositions[i].getKnotCount(); j++)
+            drawSphere(P3D() + plan.limbPositions[i].getKnotValue(j), 0.01, shader, V3D(1, 1, 0));
+}
+
+}  // namespace crl::loco
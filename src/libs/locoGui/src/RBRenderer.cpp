@@ -1,9 +1,60 @@
-#include "loco/robot/RBRenderer.h"
+#include "loco/gui/RBRenderer.h"
+
+#include <map>
 
 #include "crl-basic/gui/renderer.h"
 
 namespace crl::loco {
 
+void RBRenderer::drawRobot(const Robot &robot, const gui::Shader &shader, float alpha) {
+    // Draw abstract view first
+    if (robot.showSkeleton)
+        for (int i = 0; i < robot.getRigidBodyCount(); i++)
+            drawSkeletonView(robot.getRigidBody(i), shader, robot.showJointAxes, robot.showJointLimits, robot.showJointAngles, alpha);
+
+    // Then draw meshes (because of blending)
+    if (robot.showMeshes)
+        for (int i = 0; i < robot.getRigidBodyCount(); i++)
+            drawMeshes(robot.getRigidBody(i), shader, alpha);
+
+    // Then draw collsion spheres
+    if (robot.showCollisionSpheres)
+        for (int i = 0; i < robot.getRigidBodyCount(); i++)
+            drawCollisionShapes(robot.getRigidBody(i), shader);
+
+    // Then draw end effectors
+    if (robot.showEndEffectors)
+        for (int i = 0; i < robot.getRigidBodyCount(); i++)
+            drawEndEffectors(robot.getRigidBody(i), shader);
+
+    // and now MOIs
+    if (robot.showMOI)
+        for (int i = 0; i < robot.getRigidBodyCount(); i++)
+            drawMOI(robot.getRigidBody(i), shader);
+
+    // and now coordinate frames
+    if (robot.showCoordFrame) {
+        for (int i = 0; i < robot.getRigidBodyCount(); i++)
+            drawCoordFrame(robot.getRigidBody(i), shader);
+    }
+}
+
+const gui::Model &RBRenderer::getModel(const std::shared_ptr<const RB> &rb, const RB3DModel &m) {
+    // the meshes are loaded the first time they are needed, once per file, and
+    // are shared by all the robots loaded from the same files. Only the thread
+    // that draws uses them
+    static std::map<std::string, gui::Model> models;
+    const gui::Model &model = models.try_emplace(m.path, m.path).first->second;
+
+    RigidTransformation meshTransform(rb->getOrientation(), rb->getWorldCoordinates(P3D()));
+    meshTransform *= m.localT;
+
+    model.position = meshTransform.T;
+    model.orientation = meshTransform.R;
+    model.scale = m.scale;
+    return model;
+}
+
 void RBRenderer::drawCoordFrame(const std::shared_ptr<const RB> &rb, const gui::Shader &shader) {
     drawArrow3d(rb->getWorldCoordinates(P3D()), V3D(rb->getWorldCoordinates(V3D(1, 0, 0)) * 0.1), 0.01, shader, V3D(1.0, 0.0, 0.0));
     drawArrow3d(rb->getWorldCoordinates(P3D()), V3D(rb->getWorldCoordinates(V3D(0, 1, 0)) * 0.1), 0.01, shader, V3D(0.0, 1.0, 0.0));
@@ -65,16 +116,10 @@ void RBRenderer::drawSkeletonView(const std::shared_ptr<const RB> &rb, const gui
 
 void RBRenderer::drawMeshes(const std::shared_ptr<const RB> &rb, const gui::Shader &shader, float alpha) {
     for (auto &m : rb->rbProps.models) {
-        RigidTransformation meshTransform(rb->getOrientation(), rb->getWorldCoordinates(P3D()));
-        meshTransform *= m.localT;
-
-        m.position = meshTransform.T;
-        m.orientation = meshTransform.R;
-
         if (rb->rbProps.selected)
-            m.draw(shader, rb->rbProps.highlightColor, alpha, true);
+            getModel(rb, m).draw(shader, rb->rbProps.highlightColor, alpha, true);
         else
-            m.draw(shader, m.color, alpha, true);
+            getModel(rb, m).draw(shader, m.color, alpha, true);
     }
 }
 
@@ -205,4 +250,53 @@ void RBRenderer::drawJointAngle(const std::shared_ptr<const RBJoint> &j, const g
     drawSector(p, from, to, n, shader, V3D(1, 0, 0));
 }
 
-}  // namespace crl::loco
\ No newline at end of file
+bool RBRenderer::getRayIntersectionPoint(const std::shared_ptr<const RB> &rb, const Ray &ray, P3D &intersectionPoint, bool checkMeshes,
+                                         bool checkSkeleton) {
+    double tMin = DBL_MAX;
+    double t = tMin;
+    // we will check all meshes and all cylinders that are used to show the
+    // abstract view...
+
+    // meshes first...
+    if (checkMeshes)
+        for (auto &m : rb->rbProps.models) {
+            if (getModel(rb, m).hitByRay(ray.origin, ray.dir, t)) {
+                if (t < tMin) {
+                    intersectionPoint = ray.origin + ray.dir * t;
+                    tMin = t;
+                }
+            }
+        }
+
+    // and now the cylinders...
+    P3D skeletonIntersectionPoint;
+    if (checkSkeleton && rb->getRayIntersectionPoint(ray, skeletonIntersectionPoint)) {
+        t = ray.getRayParameterFor(skeletonIntersectionPoint);
+        if (t < tMin) {
+            intersectionPoint = skeletonIntersectionPoint;
+            tMin = t;
+        }
+    }
+
+    return tMin < DBL_MAX / 2.0;
+}
+
+std::shared_ptr<RB> RBRenderer::getFirstRBHitByRay(const Robot &robot, const Ray &ray, P3D &intersectionPoint, bool checkMeshes, bool checkSkeleton) {
+    std::shared_ptr<RB> selectedRB = nullptr;
+    double t = DBL_MAX;
+    P3D tmpIntersectionPoint = P3D(0, 0, 0);
+
+    for (int i = 0; i < robot.getRigidBodyCount(); i++) {
+        if (getRayIntersectionPoint(robot.getRigidBody(i), ray, tmpIntersectionPoint, checkMeshes, checkSkeleton)) {
+            double tTmp = ray.getRayParameterFor(tmpIntersectionPoint);
+            if (tTmp < t) {
+                selectedRB = robot.getRigidBody(i);
+                t = tTmp;
+                intersectionPoint = tmpIntersectionPoint;
+            }
+        }
+    }
+    return selectedRB;
+}
+
+}  // namespace crl::loco
@@ -0,0 +1,109 @@
+#pragma once
+
+#include <limits>
+#include <vector>
+
+#include "crl-basic/utils/geoms.h"
+#include "crl-basic/utils/mathUtils.h"
+
+namespace crl {
+
+/**
+ * A bounding volume hierarchy over the triangles of a mesh, for ray casts
+ * that only test the triangles along the ray rather than all of them. Nodes
+ * are split with the surface area heuristic (SAH).
+ */
+class TriangleBVH {
+public:
+    // where a ray hits a triangle: the ray parameter, the index of the
+    // triangle, and the barycentric coordinates of the hit with respect to the
+    // triangle's second (u) and third (v) vertex
+    struct Hit {
+        double t = std::numeric_limits<double>::infinity();
+        int triangle = -1;
+        double u = 0, v = 0;
+    };
+
+private:
+    // axis aligned bounding box
+    struct AABB {
+        V3D lo = V3D(1, 1, 1) * std::numeric_limits<double>::infinity();
+        V3D hi = V3D(1, 1, 1) * -std::numeric_limits<double>::infinity();
+
+        void add(const V3D &p) {
+            lo = lo.cwiseMin(p);
+            hi = hi.cwiseMax(p);
+        }
+
+        void add(const AABB &b) {
+            lo = lo.cwiseMin(b.lo);
+            hi = hi.cwiseMax(b.hi);
+        }
+
+        double getSurfaceArea() const {
+            V3D d = hi - lo;
+            if (d.x() < 0)
+                return 0;
+            return 2 * (d.x() * d.y() + d.y() * d.z() + d.z() * d.x());
+        }
+    };
+
+    // inner nodes have two children, the first of which directly follows
+    // them; the second one is at secondChild. Leaves (count > 0) hold
+    // triangles first to first + count - 1.
+    struct Node {
+        AABB box;
+        int secondChild = -1;
+        int first = 0, count = 0;
+    };
+
+    // triangles are stored as a vertex and two edges, ordered by the leaves
+    // they are in
+    struct Triangle {
+        V3D v0, e1, e2;
+        int index;
+    };
+
+    std::vector<Node> nodes;
+    std::vector<Triangle> triangles;
+
+public:
+    TriangleBVH() {}
+
+    /**
+     * builds the hierarchy for the triangles (three vertex indices each)
+     */
+    void build(const std::vector<P3D> &vertices, const std::vector<int> &triangleIndices);
+
+    bool isEmpty() const {
+        return triangles.empty();
+    }
+
+    int getTriangleCount() const {
+        return (int)triangles.size();
+    }
+
+    /**
+     * finds the closest hit of the ray with parameter t in (tMin, hit.t).
+     * Hits are accepted from both sides of the triangles. Returns false (and
+     * leaves hit untouched) if there is none.
+     */
+    bool intersect(const Ray &ray, Hit &hit, double tMin = 1e-8) const;
+
+    /**
+     * casts the n rays, writing their closest hits to hits (hits[i].triangle
+     * is -1 if rays[i] does not hit anything). Returns the number of rays
+     * that hit.
+     */
+    int intersect(const Ray *rays, Hit *hits, int n, double tMin = 1e-8) const;
+
+private:
+    /**
+     * builds the subtree, at the given depth, for triangles first to
+     * first + count - 1, with bounding boxes boxes and centroids centroids (in
+     * the same order)
+     */
+    void buildNode(int first, int count, int depth, std::vector<AABB> &boxes, std::vector<V3D> &centroids);
+};
+
+}  // namespace crl
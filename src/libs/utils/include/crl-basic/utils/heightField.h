@@ -0,0 +1,121 @@
+#pragma once
+
+#include <algorithm>
+#include <vector>
+
+#include "crl-basic/utils/mathUtils.h"
+
+namespace crl {
+
+/**
+ * The top surface (along y) of a triangle mesh such as a terrain, for fast
+ * height and normal queries. The mesh is bucketed into a regular grid over
+ * the xz plane, every cell listing the triangles that overlap it, so a query
+ * only looks at the few triangles around it no matter how large the mesh is.
+ * Where the mesh has no surface, the height is defaultHeight.
+ */
+class HeightField {
+public:
+    // the height wherever there is no surface
+    double defaultHeight = 0;
+
+private:
+    // a triangle, projected onto the xz plane: heights are interpolated with
+    // the barycentric coordinates of the query point
+    struct Triangle {
+        P3D a, b, c;
+        double oneOverArea;
+    };
+    std::vector<Triangle> triangles;
+
+    // the grid starts at (xMin, zMin), and has nX by nZ cells of size
+    // cellSize. The triangles of cell (i, j) are
+    // cellTriangles[cellStart[j * nX + i]] to
+    // cellTriangles[cellStart[j * nX + i + 1] - 1].
+    double xMin = 0, zMin = 0;
+    double cellSize = 1;
+    int nX = 0, nZ = 0;
+    std::vector<int> cellStart;
+    std::vector<int> cellTriangles;
+
+    // bumped by clear, which every bake starts with
+    int version = 0;
+
+public:
+    HeightField() {}
+
+    /**
+     * builds the grid for the triangles (three vertex indices each, in world
+     * coordinates). If cellSize is not positive, it is picked based on the
+     * size of the triangles, such that the grid has no more than maxCells
+     * cells.
+     */
+    void bake(const std::vector<P3D> &vertices, const std::vector<int> &triangleIndices, double cellSize = -1, int maxCells = 1 << 20);
+
+    /**
+     * removes all triangles, leaving a flat plane at defaultHeight
+     */
+    void clear();
+
+    bool isEmpty() const {
+        return triangles.empty();
+    }
+
+    double getCellSize() const {
+        return cellSize;
+    }
+
+    /**
+     * the number of times the height field was baked or cleared. Whoever
+     * keeps results that depend on the surface (e.g. a planner) can tell from
+     * it whether the surface changed since
+     */
+    int getVersion() const {
+        return version;
+    }
+
+    /**
+     * returns the height of the surface at (x, z)
+     */
+    double getHeight(double x, double z) const {
+        const Triangle *t = getTopTriangle(x, z);
+        return t ? getHeight(*t, x, z) : defaultHeight;
+    }
+
+    /**
+     * returns the normal of the surface at (x, z)
+     */
+    V3D getNormal(double x, double z) const;
+
+    /**
+     * returns the heights of the surface at the n points (x[k], z[k])
+     */
+    void getHeights(const double *x, const double *z, double *heights, int n) const;
+
+private:
+    /**
+     * returns the highest triangle above or below (x, z), i.e. the one a ray
+     * cast from above hits, or nullptr if there is none
+     */
+    const Triangle *getTopTriangle(double x, double z) const;
+
+    /**
+     * computes the barycentric coordinates of (x, z) with respect to t.
+     * Returns false if the point is not in the triangle.
+     */
+    static bool getBarycentricCoordinates(const Triangle &t, double x, double z, double &wa, double &wb, double &wc) {
+        const double eps = 1e-9;
+        wb = ((x - t.a.x) * (t.c.z - t.a.z) - (t.c.x - t.a.x) * (z - t.a.z)) * t.oneOverArea;
+        wc = ((t.b.x - t.a.x) * (z - t.a.z) - (x - t.a.x) * (t.b.z - t.a.z)) * t.oneOverArea;
+        wa = 1 - wb - wc;
+        return wa >= -eps && wb >= -eps && wc >= -eps;
+    }
+
+    static double getHeight(const Triangle &t, double x, double z) {
+        double wa, wb, wc;
+        getBarycentricCoordinates(t, x, z, wa, wb, wc);
+        return wa * t.a.y + wb * t.b.y + wc * t.c.y;
+    }
+};
+
+}  // namespace crl
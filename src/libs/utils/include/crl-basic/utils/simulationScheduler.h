@@ -0,0 +1,115 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+namespace crl {
+
+/**
+ * Runs a simulation at a fixed time step, whatever the frame rate of whoever
+ * displays it. Either a frame loop hands over the time each frame took
+ * (advance) and takes the steps that are due, or the scheduler takes them on
+ * a thread of its own (start/stop). Every step covers the same amount of
+ * simulated time, so the simulation does not depend on the frame rate. When
+ * it falls behind, at most maxCatchUpSteps steps are due at once, and the
+ * time that is left over is dropped: the simulation slows down instead of
+ * falling further and further behind.
+ */
+class SimulationScheduler {
+public:
+    explicit SimulationScheduler(double timeStep = 1.0 / 60.0, int maxCatchUpSteps = 4);
+
+    /**
+     * stops the simulation thread, if it runs
+     */
+    ~SimulationScheduler();
+
+    SimulationScheduler(const SimulationScheduler &) = delete;
+    SimulationScheduler &operator=(const SimulationScheduler &) = delete;
+
+    /**
+     * the simulated time of one step, in seconds. It may only be changed
+     * while the simulation thread is not running
+     */
+    void setTimeStep(double dt);
+
+    double getTimeStep() const {
+        return timeStep;
+    }
+
+    void setMaxCatchUpSteps(int n);
+
+    int getMaxCatchUpSteps() const {
+        return maxCatchUpSteps;
+    }
+
+    /**
+     * adds the time that passed since the last call, and returns the number
+     * of steps the caller should take now
+     */
+    int advance(double elapsedTime);
+
+    /**
+     * drops the time that was not stepped yet, e.g. when the simulation is
+     * resumed after a pause
+     */
+    void reset();
+
+    /**
+     * how far the displayed time is past the last step, as a fraction of a
+     * step (in [0, 1]). Drawing the state that far in between the last two
+     * steps makes the motion smooth when frames and steps do not line up
+     */
+    double getInterpolationFactor() const;
+
+    /**
+     * calls step every time step, in real time, on a thread of its own, until
+     * stop is called
+     */
+    void start(const std::function<void()> &step);
+
+    /**
+     * stops the simulation thread, and returns once the step it may be
+     * taking is done and the thread has finished. Does nothing if the thread
+     * does not run
+     */
+    void stop();
+
+    bool isRunning() const {
+        return thread.joinable();
+    }
+
+    /**
+     * the number of steps taken so far (or due, with advance)
+     */
+    long getStepCount() const {
+        return stepCount;
+    }
+
+private:
+    typedef std::chrono::steady_clock clock;
+
+    void threadLoop();
+
+    double timeStep;
+    int maxCatchUpSteps;
+
+    // the time that was not stepped yet (with advance)
+    double accumulatedTime = 0;
+    std::atomic<long> stepCount;
+
+    // for the simulation thread
+    std::function<void()> step;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable stopRequested;
+    bool stopping = false;
+    // when the thread last took a step, in clock ticks
+    std::atomic<clock::rep> lastStepTime;
+};
+
+}  // namespace crl
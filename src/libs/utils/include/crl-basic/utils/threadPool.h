@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace crl {
+
+/**
+ * A fixed set of worker threads for data parallel loops. parallelFor hands
+ * out the indices of a loop to the workers and to the calling thread, and
+ * returns once all of them are done. Which thread runs which index is not
+ * deterministic, so for deterministic results every index should only write
+ * to its own outputs.
+ */
+class ThreadPool {
+public:
+    /**
+     * starts nThreads - 1 workers (the thread calling parallelFor makes up the
+     * last one). If nThreads is not positive, there is one thread per core.
+     */
+    explicit ThreadPool(int nThreads = -1);
+
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /**
+     * the number of threads loops run on, the calling thread included
+     */
+    int getThreadCount() const {
+        return (int)workers.size() + 1;
+    }
+
+    /**
+     * calls f(i) for i = 0 to n - 1, in parallel. If calls throw, the first
+     * exception is rethrown here once the loop is done. Loops from different
+     * threads run one after the other; f must not start a loop on the same
+     * pool itself.
+     */
+    void parallelFor(int n, const std::function<void(int)> &f);
+
+private:
+    void workerLoop();
+
+    // runs indices of the current loop until there are none left
+    void runIndices();
+
+    std::vector<std::thread> workers;
+
+    // one loop at a time
+    std::mutex loopMutex;
+
+    // guards everything below, except nextIndex
+    std::mutex mutex;
+    std::condition_variable loopStarted, loopDone;
+    const std::function<void(int)> *loop = nullptr;
+    int loopSize = 0;
+    std::atomic<int> nextIndex;
+    // counts loops, so that workers can tell a new one from the last one
+    unsigned long loopCount = 0;
+    // workers that have not finished the current loop yet
+    int nBusyWorkers = 0;
+    std::exception_ptr exception;
+    bool stopping = false;
+};
+
+}  // namespace crl
@@ -1,5 +1,7 @@
 #pragma once
 
+#include <algorithm>
+#include <cmath>
 #include <limits>
 
 #include "crl-basic/utils/mathDefs.h"
@@ -17,49 +19,130 @@ namespace crl {
  */
 template <class T>
 class GenericTrajectory {
-protected:
-    // A caching variable to optimize searching for knots
-    mutable int lastIndex;
-
 protected:
     DynamicArray<double> tValues;
     DynamicArray<T> values;
 
+    // knots that are (up to round-off) uniformly spaced, e.g. because they were
+    // sampled at a fixed time step, can be looked up in constant time. This is
+    // kept up to date whenever the knots change, so that lookups stay const
+    // and trajectories can be evaluated from several threads at once.
+    bool uniformSpacing = false;
+    double knotSpacing = 0;
+
+    // the slope estimates at every knot that catmull-rom interpolation uses
+    // (see getSlopeEstimateAtKnot), one-sided at the two end knots. These only
+    // depend on the neighbouring knots, so they are updated along with them.
+    DynamicArray<T> tangents;
+
+    /**
+     * Recomputes the tangents at knots first to last (clamped to the range of
+     * knots), i.e. those affected by changes to knots first + 1 to last - 1.
+     */
+    void updateTangents(int first, int last) {
+        int size = (int)tValues.size();
+        tangents.resize(size);
+        for (int i = std::max(first, 0); i <= std::min(last, size - 1); i++)
+            tangents[i] = getSlopeEstimateAtKnot(i);
+    }
+
+    /**
+     * Hermite interpolation between knots index - 1 and index, using the cached
+     * tangents. It is assumed that t is within that interval.
+     */
+    T evaluate_catmull_rom_in_interval(double t, int index, bool equalEndpointSlopes) const {
+        int size = (int)tValues.size();
+        double dt = tValues[index] - tValues[index - 1];
+
+        // now that we found the interval, get a value that indicates how far we
+        // are along it
+        t = (t - tValues[index - 1]) / dt;
+
+        // the derivatives at the two ends
+        const T &p1 = values[index - 1];
+        const T &p2 = values[index];
+
+        T m1, m2;
+        if (equalEndpointSlopes && (index - 1 == 0 || index == size - 1)) {
+            T endpointSlope = static_cast<T>((tangents[0] + tangents[size - 1]) / 2.0);
+            m1 = static_cast<T>((index - 1 == 0 ? endpointSlope : tangents[index - 1]) * dt);
+            m2 = static_cast<T>((index == size - 1 ? endpointSlope : tangents[index]) * dt);
+        } else {
+            m1 = static_cast<T>(tangents[index - 1] * dt);
+            m2 = static_cast<T>(tangents[index] * dt);
+        }
+
+        double t2, t3;
+        t2 = t * t;
+        t3 = t2 * t;
+
+        // and now perform the interpolation using the four hermite basis
+        // functions from wikipedia
+        return p1 * (2 * t3 - 3 * t2 + 1) + m1 * (t3 - 2 * t2 + t) + p2 * (-2 * t3 + 3 * t2) + m2 * (t3 - t2);
+    }
+
     /**
      * This method returns the index of the first knot whose value is larger
      * than the parameter value t. If no such index exists (i.e. t is larger
      * than any of the values stored), then values.size() is returned.
-     *
-     * TODO: might want to use a binary search here... or something like
-     * http://www.cplusplus.com/reference/algorithm/lower_bound/
      */
     inline int getFirstLargerIndex(double t) const {
         int size = (int)tValues.size();
-        if (size == 0)
+        if (size == 0 || t < tValues[0])
             return 0;
-
-        if (t < tValues[(lastIndex + size - 1) % size])
-            lastIndex = 0;
-        for (int i = 0; i < size; i++) {
-            int index = (i + lastIndex) % size;
-            if (t < tValues[index]) {
-                lastIndex = index;
-                return index;
-            }
+        if (!(t < tValues[size - 1]))
+            return size;
+
+        if (uniformSpacing) {
+            // t is in between the first and last knots, so the guess is within
+            // [1, size - 1], and off by at most one because of round-off
+            int index = std::min((int)((t - tValues[0]) / knotSpacing) + 1, size - 1);
+            if (t < tValues[index - 1])
+                index--;
+            else if (tValues[index] <= t)
+                index++;
+            return index;
         }
-        return size;
+
+        return (int)(std::upper_bound(tValues.begin(), tValues.end(), t) - tValues.begin());
     }
 
-public:
-    GenericTrajectory(void) {
-        lastIndex = 0;
+    /**
+     * Checks whether the knots are uniformly spaced, i.e. every knot is within
+     * a small fraction of the spacing of where a uniform grid would put it.
+     */
+    void updateUniformSpacing() {
+        int size = (int)tValues.size();
+        uniformSpacing = false;
+        if (size < 2)
+            return;
+
+        double spacing = (tValues[size - 1] - tValues[0]) / (size - 1);
+        if (!(spacing > 0))
+            return;
+        for (int i = 1; i < size - 1; i++)
+            if (fabs(tValues[i] - (tValues[0] + i * spacing)) > UNIFORM_SPACING_TOLERANCE * spacing)
+                return;
+
+        uniformSpacing = true;
+        knotSpacing = spacing;
     }
 
+    static constexpr double UNIFORM_SPACING_TOLERANCE = 1e-6;
+
+public:
+    GenericTrajectory(void) {}
+
     GenericTrajectory(const GenericTrajectory<T> &other) {
-        lastIndex = 0;
         copy(other);
     }
 
+    GenericTrajectory<T> &operator=(const GenericTrajectory<T> &other) {
+        if (this != &other)
+            copy(other);
+        return *this;
+    }
+
     virtual ~GenericTrajectory(void) {
         clear();
     }
@@ -190,27 +273,39 @@ public:
             return values[0];
         if (t >= tValues[size - 1])
             return values[size - 1];
-        int index = getFirstLargerIndex(t);
-
-        // now that we found the interval, get a value that indicates how far we
-        // are along it
-        t = (t - tValues[index - 1]) / (tValues[index] - tValues[index - 1]);
-
-        // approximate the derivatives at the two ends
-
-        T p1 = values[index - 1];
-        T p2 = values[index];
-
-        T m1 = getSlopeEstimateAtKnot(index - 1, equalEndpointSlopes) * (tValues[index] - tValues[index - 1]);
-        T m2 = getSlopeEstimateAtKnot(index, equalEndpointSlopes) * (tValues[index] - tValues[index - 1]);
+        return evaluate_catmull_rom_in_interval(t, getFirstLargerIndex(t), equalEndpointSlopes);
+    }
 
-        double t2, t3;
-        t2 = t * t;
-        t3 = t2 * t;
+    /**
+     * Evaluate using catmull rom interpolation at the n times in ts, writing the
+     * results to out. Sorted times are found by walking along the knots from
+     * one query to the next, rather than by searching for each of them.
+     */
+    void evaluate_catmull_rom(const double *ts, T *out, int n, bool equalEndpointSlopes = false) const {
+        int size = (int)tValues.size();
+        int index = 0;
+        for (int i = 0; i < n; i++) {
+            double t = ts[i];
+            if (size == 0) {
+                out[i] = T(0);
+                continue;
+            }
+            if (t <= tValues[0]) {
+                out[i] = values[0];
+                continue;
+            }
+            if (t >= tValues[size - 1]) {
+                out[i] = values[size - 1];
+                continue;
+            }
 
-        // and now perform the interpolation using the four hermite basis
-        // functions from wikipedia
-        return p1 * (2 * t3 - 3 * t2 + 1) + m1 * (t3 - 2 * t2 + t) + p2 * (-2 * t3 + 3 * t2) + m2 * (t3 - t2);
+            // only search again if the times are not sorted
+            if (index == 0 || t < tValues[index - 1])
+                index = getFirstLargerIndex(t);
+            while (tValues[index] <= t)
+                index++;
+            out[i] = evaluate_catmull_rom_in_interval(t, index, equalEndpointSlopes);
+        }
     }
 
     /**
@@ -235,6 +330,7 @@ public:
      */
     void setKnotValue(int i, const T &val) {
         values[i] = val;
+        updateTangents(i - 1, i + 1);
     }
 
     /**
@@ -247,6 +343,8 @@ public:
         if ((uint)(i + 1) < tValues.size() - 1 && tValues[i + 1] <= pos)
             return;
         tValues[i] = pos;
+        updateUniformSpacing();
+        updateTangents(i - 1, i + 1);
     }
 
     /**
@@ -280,9 +378,21 @@ public:
     void addKnot(double t, T val) {
         // first we need to know where to insert it, based on the t-values
         int index = getFirstLargerIndex(t);
+        int size = (int)tValues.size();
 
         tValues.insert(tValues.begin() + index, t);
         values.insert(values.begin() + index, val);
+        tangents.insert(tangents.begin() + index, val);
+        updateTangents(index - 1, index + 1);
+
+        // appending a knot (the common case) keeps a uniform grid uniform if
+        // the new knot falls on it, and can never make other knots uniform
+        if (index == size && size >= 2) {
+            if (uniformSpacing && fabs(t - (tValues[0] + size * knotSpacing)) > UNIFORM_SPACING_TOLERANCE * knotSpacing)
+                uniformSpacing = false;
+        } else {
+            updateUniformSpacing();
+        }
     }
 
     /**
@@ -292,6 +402,26 @@ public:
     void removeKnot(int i) {
         tValues.erase(tValues.begin() + i);
         values.erase(values.begin() + i);
+        tangents.erase(tangents.begin() + i);
+        updateUniformSpacing();
+        updateTangents(i - 1, i);
+    }
+
+    /**
+     * Removes the knots before t, except for the last of them, so that the
+     * trajectory can still be interpolated at t. This is meant for
+     * trajectories that keep being extended at the end while time moves on.
+     */
+    void removeKnotsBefore(double t) {
+        int n = getFirstLargerIndex(t) - 1;
+        if (n <= 0)
+            return;
+        tValues.erase(tValues.begin(), tValues.begin() + n);
+        values.erase(values.begin(), values.begin() + n);
+        tangents.erase(tangents.begin(), tangents.begin() + n);
+        updateUniformSpacing();
+        // the new first knot now gets a one-sided slope estimate
+        updateTangents(0, 0);
     }
 
     /**
@@ -300,6 +430,8 @@ public:
     void clear() {
         tValues.clear();
         values.clear();
+        tangents.clear();
+        uniformSpacing = false;
     }
 
     void copy(const GenericTrajectory<T> &other) {
@@ -313,6 +445,9 @@ public:
             tValues.push_back(other.tValues[i]);
             values.push_back(other.values[i]);
         }
+        uniformSpacing = other.uniformSpacing;
+        knotSpacing = other.knotSpacing;
+        tangents = other.tangents;
     }
 
 private:
@@ -0,0 +1,80 @@
+#pragma once
+
+#include <atomic>
+
+namespace crl {
+
+/**
+ * Hands the latest of a stream of values from one thread (the writer) to
+ * another (the reader) without locks, and without either of them ever
+ * waiting for the other. There are three copies of the value: the writer
+ * fills the back one and publishes it, the reader reads the front one, and
+ * the third one holds the latest published value until the reader picks it
+ * up. Values the reader has not picked up before the next one gets published
+ * are skipped.
+ *
+ * Only one thread may write, and only one may read. The copies are reused,
+ * so values that keep their storage when assigned (e.g. vectors of the same
+ * size) do not allocate once all three have been written.
+ */
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() = default;
+
+    TripleBuffer(const TripleBuffer &) = delete;
+    TripleBuffer &operator=(const TripleBuffer &) = delete;
+
+    /**
+     * writer: the copy to fill in next. It is not visible to the reader until
+     * it gets published
+     */
+    T &getBackBuffer() {
+        return buffers[back];
+    }
+
+    /**
+     * writer: makes the back buffer the latest value, and hands the writer
+     * another copy to fill in
+     */
+    void publish() {
+        back = middle.exchange(back | freshBit, std::memory_order_acq_rel) & indexMask;
+    }
+
+    /**
+     * reader: picks up the latest published value, if there is one the reader
+     * does not have yet. Returns true if the front buffer changed
+     */
+    bool update() {
+        if ((middle.load(std::memory_order_relaxed) & freshBit) == 0)
+            return false;
+        front = middle.exchange(front, std::memory_order_acq_rel) & indexMask;
+        return true;
+    }
+
+    /**
+     * reader: the value picked up by the last call to update
+     */
+    const T &getFrontBuffer() const {
+        return buffers[front];
+    }
+
+    T &getFrontBuffer() {
+        return buffers[front];
+    }
+
+private:
+    static const int indexMask = 3;
+    // set in middle when it holds a value the reader has not picked up yet
+    static const int freshBit = 4;
+
+    T buffers[3];
+    // owned by the writer
+    int back = 0;
+    // the index of the copy in between, and freshBit
+    std::atomic<int> middle{1};
+    // owned by the reader
+    int front = 2;
+};
+
+}  // namespace crl
@@ -0,0 +1,225 @@
+#include "crl-basic/utils/bvh.h"
+
+#include <algorithm>
+
+namespace crl {
+
+namespace {
+
+// number of bins used to evaluate the SAH along every axis
+const int nSAHBins = 16;
+// relative cost of traversing a node, compared to intersecting a triangle
+const double traversalCost = 1.0;
+const int maxLeafSize = 4;
+// deeper nodes are not split any further, which bounds the traversal stack
+const int maxDepth = 64;
+
+// the entry and exit ray parameters of the box, with 1 / dir precomputed
+inline bool intersectBox(const V3D &lo, const V3D &hi, const V3D &origin, const V3D &invDir, double tMin, double tMax, double &tEnter) {
+    for (int k = 0; k < 3; k++) {
+        double t0 = (lo[k] - origin[k]) * invDir[k];
+        double t1 = (hi[k] - origin[k]) * invDir[k];
+        if (t0 > t1)
+            std::swap(t0, t1);
+        tMin = t0 > tMin ? t0 : tMin;
+        tMax = t1 < tMax ? t1 : tMax;
+        if (tMin > tMax)
+            return false;
+    }
+    tEnter = tMin;
+    return true;
+}
+
+}  // namespace
+
+void TriangleBVH::build(const std::vector<P3D> &vertices, const std::vector<int> &triangleIndices) {
+    nodes.clear();
+    triangles.clear();
+
+    int nTriangles = (int)triangleIndices.size() / 3;
+    std::vector<AABB> boxes(nTriangles);
+    std::vector<V3D> centroids(nTriangles);
+    triangles.resize(nTriangles);
+    for (int k = 0; k < nTriangles; k++) {
+        V3D a(vertices[triangleIndices[3 * k + 0]]);
+        V3D b(vertices[triangleIndices[3 * k + 1]]);
+        V3D c(vertices[triangleIndices[3 * k + 2]]);
+        triangles[k].v0 = a;
+        triangles[k].e1 = b - a;
+        triangles[k].e2 = c - a;
+        triangles[k].index = k;
+        boxes[k].add(a);
+        boxes[k].add(b);
+        boxes[k].add(c);
+        centroids[k] = (a + b + c) / 3.0;
+    }
+    if (nTriangles == 0)
+        return;
+
+    nodes.reserve(2 * nTriangles);
+    buildNode(0, nTriangles, 0, boxes, centroids);
+}
+
+void TriangleBVH::buildNode(int first, int count, int depth, std::vector<AABB> &boxes, std::vector<V3D> &centroids) {
+    int nodeIndex = (int)nodes.size();
+    nodes.push_back(Node());
+
+    AABB box, centroidBox;
+    for (int k = first; k < first + count; k++) {
+        box.add(boxes[k]);
+        centroidBox.add(centroids[k]);
+    }
+    nodes[nodeIndex].box = box;
+
+    // find the cheapest split into binned centroid intervals along any axis
+    int bestAxis = -1, bestSplit = 0;
+    double bestCost = count;
+    if (count > maxLeafSize && depth < maxDepth) {
+        for (int axis = 0; axis < 3; axis++) {
+            double lo = centroidBox.lo[axis], extent = centroidBox.hi[axis] - lo;
+            if (!(extent > 0))
+                continue;
+
+            AABB binBoxes[nSAHBins];
+            int binCounts[nSAHBins] = {0};
+            for (int k = first; k < first + count; k++) {
+                int b = std::min((int)((centroids[k][axis] - lo) / extent * nSAHBins), nSAHBins - 1);
+                binCounts[b]++;
+                binBoxes[b].add(boxes[k]);
+            }
+
+            // sweep from the right to get the cost of all right halves, then
+            // from the left
+            double rightArea[nSAHBins];
+            int rightCount[nSAHBins];
+            AABB right;
+            int n = 0;
+            for (int b = nSAHBins - 1; b > 0; b--) {
+                right.add(binBoxes[b]);
+                n += binCounts[b];
+                rightArea[b] = right.getSurfaceArea();
+                rightCount[b] = n;
+            }
+            AABB left;
+            n = 0;
+            double area = box.getSurfaceArea();
+            for (int b = 0; b < nSAHBins - 1; b++) {
+                left.add(binBoxes[b]);
+                n += binCounts[b];
+                if (n == 0 || rightCount[b + 1] == 0)
+                    continue;
+                double cost = traversalCost + (left.getSurfaceArea() * n + rightArea[b + 1] * rightCount[b + 1]) / area;
+                if (cost < bestCost) {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = b + 1;
+                }
+            }
+        }
+    }
+
+    if (bestAxis < 0) {
+        nodes[nodeIndex].first = first;
+        nodes[nodeIndex].count = count;
+        return;
+    }
+
+    // partition the triangles by the bin of their centroid
+    double lo = centroidBox.lo[bestAxis], extent = centroidBox.hi[bestAxis] - lo;
+    int mid = first;
+    for (int k = first; k < first + count; k++) {
+        int b = std::min((int)((centroids[k][bestAxis] - lo) / extent * nSAHBins), nSAHBins - 1);
+        if (b < bestSplit) {
+            std::swap(triangles[k], triangles[mid]);
+            std::swap(boxes[k], boxes[mid]);
+            std::swap(centroids[k], centroids[mid]);
+            mid++;
+        }
+    }
+
+    buildNode(first, mid - first, depth + 1, boxes, centroids);
+    nodes[nodeIndex].secondChild = (int)nodes.size();
+    buildNode(mid, first + count - mid, depth + 1, boxes, centroids);
+}
+
+bool TriangleBVH::intersect(const Ray &ray, Hit &hit, double tMin) const {
+    if (nodes.empty())
+        return false;
+
+    V3D origin(ray.origin);
+    V3D invDir(1.0 / ray.dir.x(), 1.0 / ray.dir.y(), 1.0 / ray.dir.z());
+    bool hasHit = false;
+
+    // nodes to visit, nearest first. Every level of the tree adds at most one
+    // node to the stack
+    int stack[maxDepth + 2];
+    int stackSize = 0;
+    double tEnter;
+    if (!intersectBox(nodes[0].box.lo, nodes[0].box.hi, origin, invDir, tMin, hit.t, tEnter))
+        return false;
+    stack[stackSize++] = 0;
+
+    while (stackSize > 0) {
+        int nodeIndex = stack[--stackSize];
+        const Node &node = nodes[nodeIndex];
+
+        if (node.count > 0) {
+            // Moller-Trumbore, accepting both sides of the triangles
+            for (int k = node.first; k < node.first + node.count; k++) {
+                const Triangle &tri = triangles[k];
+                V3D p = ray.dir.cross(tri.e2);
+                double det = tri.e1.dot(p);
+                if (fabs(det) < 1e-14)
+                    continue;
+                double invDet = 1.0 / det;
+                V3D s = origin - tri.v0;
+                double u = s.dot(p) * invDet;
+                if (u < 0 || u > 1)
+                    continue;
+                V3D q = s.cross(tri.e1);
+                double v = ray.dir.dot(q) * invDet;
+                if (v < 0 || u + v > 1)
+                    continue;
+                double t = tri.e2.dot(q) * invDet;
+                if (t > tMin && t < hit.t) {
+                    hit.t = t;
+                    hit.triangle = tri.index;
+                    hit.u = u;
+                    hit.v = v;
+                    hasHit = true;
+                }
+            }
+            continue;
+        }
+
+        // push the farther child first, so the nearer one is visited first
+        int children[2] = {nodeIndex + 1, node.secondChild};
+        double tChild[2];
+        bool hitChild[2];
+        for (int c = 0; c < 2; c++)
+            hitChild[c] = intersectBox(nodes[children[c]].box.lo, nodes[children[c]].box.hi, origin, invDir, tMin, hit.t, tChild[c]);
+        if (hitChild[0] && hitChild[1]) {
+            bool firstIsNearer = tChild[0] <= tChild[1];
+            stack[stackSize++] = firstIsNearer ? children[1] : children[0];
+            stack[stackSize++] = firstIsNearer ? children[0] : children[1];
+        } else if (hitChild[0]) {
+            stack[stackSize++] = children[0];
+        } else if (hitChild[1]) {
+            stack[stackSize++] = children[1];
+        }
+    }
+
+    return hasHit;
+}
+
+int TriangleBVH::intersect(const Ray *rays, Hit *hits, int n, double tMin) const {
+    int nHits = 0;
+    for (int i = 0; i < n; i++) {
+        hits[i] = Hit();
+        if (intersect(rays[i], hits[i], tMin))
+            nHits++;
+    }
+    return nHits;
+}
+
+}  // namespace crl
@@ -0,0 +1,130 @@
+#include "crl-basic/utils/heightField.h"
+
+#include <cmath>
+#include <limits>
+
+namespace crl {
+
+void HeightField::bake(const std::vector<P3D> &vertices, const std::vector<int> &triangleIndices, double cellSize, int maxCells) {
+    clear();
+
+    // vertical triangles have no area when seen from above, so they can never
+    // be the top surface
+    double xMax = -std::numeric_limits<double>::infinity(), zMax = xMax;
+    double xMinT = std::numeric_limits<double>::infinity(), zMinT = xMinT;
+    double edgeLength = 0;
+    for (int k = 0; k + 2 < (int)triangleIndices.size(); k += 3) {
+        Triangle t;
+        t.a = vertices[triangleIndices[k]];
+        t.b = vertices[triangleIndices[k + 1]];
+        t.c = vertices[triangleIndices[k + 2]];
+        double area = (t.b.x - t.a.x) * (t.c.z - t.a.z) - (t.c.x - t.a.x) * (t.b.z - t.a.z);
+        if (fabs(area) < 1e-12)
+            continue;
+        t.oneOverArea = 1.0 / area;
+        triangles.push_back(t);
+
+        xMinT = std::min({xMinT, t.a.x, t.b.x, t.c.x});
+        xMax = std::max({xMax, t.a.x, t.b.x, t.c.x});
+        zMinT = std::min({zMinT, t.a.z, t.b.z, t.c.z});
+        zMax = std::max({zMax, t.a.z, t.b.z, t.c.z});
+        edgeLength += sqrt((t.b.x - t.a.x) * (t.b.x - t.a.x) + (t.b.z - t.a.z) * (t.b.z - t.a.z));
+        edgeLength += sqrt((t.c.x - t.b.x) * (t.c.x - t.b.x) + (t.c.z - t.b.z) * (t.c.z - t.b.z));
+        edgeLength += sqrt((t.a.x - t.c.x) * (t.a.x - t.c.x) + (t.a.z - t.c.z) * (t.a.z - t.c.z));
+    }
+    if (triangles.empty())
+        return;
+    xMin = xMinT;
+    zMin = zMinT;
+
+    // by default, cells are about as large as the triangles, so that every
+    // cell only overlaps a handful of them
+    if (cellSize <= 0)
+        cellSize = edgeLength / (3 * triangles.size());
+    cellSize = std::max(cellSize, sqrt((xMax - xMin) * (zMax - zMin) / maxCells));
+    if (!(cellSize > 0))
+        cellSize = 1;
+    this->cellSize = cellSize;
+
+    nX = std::max((int)ceil((xMax - xMin) / cellSize), 1);
+    nZ = std::max((int)ceil((zMax - zMin) / cellSize), 1);
+
+    // count the triangles that overlap every cell (based on their bounding
+    // boxes), then fill them in
+    auto getCellRange = [&](const Triangle &t, int &iStart, int &iEnd, int &jStart, int &jEnd) {
+        iStart = std::max((int)floor((std::min({t.a.x, t.b.x, t.c.x}) - xMin) / cellSize), 0);
+        iEnd = std::min((int)floor((std::max({t.a.x, t.b.x, t.c.x}) - xMin) / cellSize), nX - 1);
+        jStart = std::max((int)floor((std::min({t.a.z, t.b.z, t.c.z}) - zMin) / cellSize), 0);
+        jEnd = std::min((int)floor((std::max({t.a.z, t.b.z, t.c.z}) - zMin) / cellSize), nZ - 1);
+    };
+
+    cellStart.assign((size_t)nX * nZ + 1, 0);
+    int iStart, iEnd, jStart, jEnd;
+    for (const auto &t : triangles) {
+        getCellRange(t, iStart, iEnd, jStart, jEnd);
+        for (int j = jStart; j <= jEnd; j++)
+            for (int i = iStart; i <= iEnd; i++)
+                cellStart[j * nX + i + 1]++;
+    }
+    for (size_t c = 1; c < cellStart.size(); c++)
+        cellStart[c] += cellStart[c - 1];
+
+    cellTriangles.resize(cellStart.back());
+    std::vector<int> cellFill(cellStart.begin(), cellStart.end() - 1);
+    for (int k = 0; k < (int)triangles.size(); k++) {
+        getCellRange(triangles[k], iStart, iEnd, jStart, jEnd);
+        for (int j = jStart; j <= jEnd; j++)
+            for (int i = iStart; i <= iEnd; i++)
+                cellTriangles[cellFill[j * nX + i]++] = k;
+    }
+}
+
+void HeightField::clear() {
+    triangles.clear();
+    cellStart.clear();
+    cellTriangles.clear();
+    nX = nZ = 0;
+    version++;
+}
+
+const HeightField::Triangle *HeightField::getTopTriangle(double x, double z) const {
+    if (triangles.empty())
+        return nullptr;
+
+    // points on the far boundary of the grid belong to the last cell
+    double u = (x - xMin) / cellSize, v = (z - zMin) / cellSize;
+    if (!(u >= 0 && v >= 0 && u <= nX && v <= nZ))
+        return nullptr;
+    int cell = std::min((int)v, nZ - 1) * nX + std::min((int)u, nX - 1);
+
+    const Triangle *top = nullptr;
+    double topHeight = 0;
+    double wa, wb, wc;
+    for (int c = cellStart[cell]; c < cellStart[cell + 1]; c++) {
+        const Triangle &t = triangles[cellTriangles[c]];
+        if (!getBarycentricCoordinates(t, x, z, wa, wb, wc))
+            continue;
+        double h = wa * t.a.y + wb * t.b.y + wc * t.c.y;
+        if (top == nullptr || h > topHeight) {
+            top = &t;
+            topHeight = h;
+        }
+    }
+    return top;
+}
+
+V3D HeightField::getNormal(double x, double z) const {
+    const Triangle *t = getTopTriangle(x, z);
+    if (t == nullptr)
+        return V3D(0, 1, 0);
+
+    V3D n = V3D(t->a, t->b).cross(V3D(t->a, t->c)).normalized();
+    return n.y() < 0 ? V3D(-n) : n;
+}
+
+void HeightField::getHeights(const double *x, const double *z, double *heights, int n) const {
+    for (int k = 0; k < n; k++)
+        heights[k] = getHeight(x[k], z[k]);
+}
+
+}  // namespace crl
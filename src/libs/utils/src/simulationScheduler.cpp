@@ -0,0 +1,90 @@
+#include "crl-basic/utils/simulationScheduler.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace crl {
+
+SimulationScheduler::SimulationScheduler(double timeStep, int maxCatchUpSteps)
+    : timeStep(timeStep), maxCatchUpSteps(std::max(1, maxCatchUpSteps)), stepCount(0), lastStepTime(0) {}
+
+SimulationScheduler::~SimulationScheduler() {
+    stop();
+}
+
+void SimulationScheduler::setTimeStep(double dt) {
+    timeStep = dt;
+    accumulatedTime = 0;
+}
+
+void SimulationScheduler::setMaxCatchUpSteps(int n) {
+    maxCatchUpSteps = std::max(1, n);
+}
+
+int SimulationScheduler::advance(double elapsedTime) {
+    accumulatedTime += std::max(0.0, elapsedTime);
+    int nSteps = (int)std::floor(accumulatedTime / timeStep);
+    if (nSteps > maxCatchUpSteps) {
+        // too far behind to catch up: drop what cannot be stepped now
+        nSteps = maxCatchUpSteps;
+        accumulatedTime = 0;
+    } else {
+        accumulatedTime = std::max(0.0, accumulatedTime - nSteps * timeStep);
+    }
+    stepCount += nSteps;
+    return nSteps;
+}
+
+void SimulationScheduler::reset() {
+    accumulatedTime = 0;
+}
+
+double SimulationScheduler::getInterpolationFactor() const {
+    if (!isRunning())
+        return std::min(1.0, accumulatedTime / timeStep);
+
+    clock::duration sinceLastStep = clock::now().time_since_epoch() - clock::duration(lastStepTime.load());
+    return std::min(1.0, std::max(0.0, std::chrono::duration<double>(sinceLastStep).count() / timeStep));
+}
+
+void SimulationScheduler::start(const std::function<void()> &step) {
+    stop();
+    this->step = step;
+    stopping = false;
+    lastStepTime = clock::now().time_since_epoch().count();
+    thread = std::thread(&SimulationScheduler::threadLoop, this);
+}
+
+void SimulationScheduler::stop() {
+    if (!thread.joinable())
+        return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    stopRequested.notify_all();
+    thread.join();
+    step = nullptr;
+}
+
+void SimulationScheduler::threadLoop() {
+    const clock::duration period = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(timeStep));
+    clock::time_point next = clock::now();
+    while (true) {
+        step();
+        stepCount++;
+        lastStepTime = clock::now().time_since_epoch().count();
+
+        next += period;
+        clock::time_point now = clock::now();
+        // too far behind to catch up: carry on from now
+        if (now - next > maxCatchUpSteps * period)
+            next = now;
+
+        std::unique_lock<std::mutex> lock(mutex);
+        if (stopRequested.wait_until(lock, next, [this]() { return stopping; }))
+            return;
+    }
+}
+
+}  // namespace crl
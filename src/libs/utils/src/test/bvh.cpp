@@ -0,0 +1,126 @@
+#include <gtest/gtest.h>
+
+#include <crl-basic/utils/bvh.h>
+
+namespace crl {
+
+/**
+ * Random triangles scattered through a cube of size 10 centered at the origin.
+ */
+void makeTriangleSoup(int n, std::vector<P3D> &vertices, std::vector<int> &triangles) {
+    srand(0);
+    for (int i = 0; i < n; i++) {
+        P3D center(getRandomNumberInRange(-5, 5), getRandomNumberInRange(-5, 5), getRandomNumberInRange(-5, 5));
+        for (int k = 0; k < 3; k++) {
+            triangles.push_back((int)vertices.size());
+            vertices.push_back(center + V3D(getRandomNumberInRange(-0.5, 0.5), getRandomNumberInRange(-0.5, 0.5), getRandomNumberInRange(-0.5, 0.5)));
+        }
+    }
+}
+
+/**
+ * Closest hit of the ray, testing every triangle.
+ */
+TriangleBVH::Hit intersectBruteForce(const Ray &ray, const std::vector<P3D> &vertices, const std::vector<int> &triangles) {
+    TriangleBVH::Hit hit;
+    for (int i = 0; i < (int)triangles.size() / 3; i++) {
+        V3D v0 = V3D(vertices[triangles[3 * i]]);
+        V3D e1 = V3D(vertices[triangles[3 * i]], vertices[triangles[3 * i + 1]]);
+        V3D e2 = V3D(vertices[triangles[3 * i]], vertices[triangles[3 * i + 2]]);
+        V3D p = ray.dir.cross(e2);
+        double det = e1.dot(p);
+        if (fabs(det) < 1e-14)
+            continue;
+        V3D s = V3D(ray.origin) - v0;
+        double u = s.dot(p) / det;
+        V3D q = s.cross(e1);
+        double v = ray.dir.dot(q) / det;
+        double t = e2.dot(q) / det;
+        if (u < 0 || v < 0 || u + v > 1 || t < 1e-8 || t >= hit.t)
+            continue;
+        hit.t = t;
+        hit.triangle = i;
+        hit.u = u;
+        hit.v = v;
+    }
+    return hit;
+}
+
+Ray getRandomRay() {
+    P3D origin(getRandomNumberInRange(-8, 8), getRandomNumberInRange(-8, 8), getRandomNumberInRange(-8, 8));
+    // aim roughly at the cube, so that most rays hit something
+    P3D target(getRandomNumberInRange(-5, 5), getRandomNumberInRange(-5, 5), getRandomNumberInRange(-5, 5));
+    return Ray(origin, V3D(origin, target).normalized());
+}
+
+TEST(TriangleBVHTest, hitsMatchBruteForce) {
+    std::vector<P3D> vertices;
+    std::vector<int> triangles;
+    makeTriangleSoup(500, vertices, triangles);
+
+    TriangleBVH bvh;
+    bvh.build(vertices, triangles);
+    EXPECT_EQ(bvh.getTriangleCount(), 500);
+
+    int nHits = 0;
+    for (int k = 0; k < 1000; k++) {
+        Ray ray = getRandomRay();
+        TriangleBVH::Hit expected = intersectBruteForce(ray, vertices, triangles);
+        TriangleBVH::Hit hit;
+        bool isHit = bvh.intersect(ray, hit);
+
+        ASSERT_EQ(isHit, expected.triangle >= 0);
+        if (!isHit)
+            continue;
+        nHits++;
+        EXPECT_EQ(hit.triangle, expected.triangle);
+        EXPECT_NEAR(hit.t, expected.t, 1e-9);
+        EXPECT_NEAR(hit.u, expected.u, 1e-9);
+        EXPECT_NEAR(hit.v, expected.v, 1e-9);
+    }
+    // make sure the test is not vacuous
+    EXPECT_GT(nHits, 100);
+}
+
+TEST(TriangleBVHTest, batchedRaysMatchSingleRays) {
+    std::vector<P3D> vertices;
+    std::vector<int> triangles;
+    makeTriangleSoup(500, vertices, triangles);
+
+    TriangleBVH bvh;
+    bvh.build(vertices, triangles);
+
+    const int n = 100;
+    std::vector<Ray> rays(n);
+    for (auto &ray : rays)
+        ray = getRandomRay();
+
+    // the batched query resets the hits it is given
+    std::vector<TriangleBVH::Hit> hits(n);
+    for (auto &hit : hits)
+        hit.t = 0;
+
+    int nHits = bvh.intersect(rays.data(), hits.data(), n);
+
+    int nExpectedHits = 0;
+    for (int i = 0; i < n; i++) {
+        TriangleBVH::Hit hit;
+        if (bvh.intersect(rays[i], hit))
+            nExpectedHits++;
+        EXPECT_EQ(hits[i].triangle, hit.triangle);
+        EXPECT_EQ(hits[i].t, hit.t);
+    }
+    EXPECT_EQ(nHits, nExpectedHits);
+}
+
+TEST(TriangleBVHTest, emptyHierarchyIsNeverHit) {
+    TriangleBVH bvh;
+    bvh.build(std::vector<P3D>(), std::vector<int>());
+    EXPECT_TRUE(bvh.isEmpty());
+
+    TriangleBVH::Hit hit;
+    EXPECT_FALSE(bvh.intersect(Ray(P3D(0, 1, 0), V3D(0, -1, 0)), hit));
+    EXPECT_EQ(hit.triangle, -1);
+}
+
+}  // namespace crl
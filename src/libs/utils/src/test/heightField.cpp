@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+
+#include <crl-basic/utils/heightField.h>
+
+namespace crl {
+
+/**
+ * A grid of n by n squares of size 1, starting at the origin, each split into
+ * two triangles. The heights are random, with a step of 2 along x = n / 2.
+ */
+void makeSteppedTerrain(int n, std::vector<P3D> &vertices, std::vector<int> &triangles) {
+    srand(0);
+    for (int j = 0; j < n; j++)
+        for (int i = 0; i < n; i++) {
+            double step = i >= n / 2 ? 2.0 : 0.0;
+            int offset = (int)vertices.size();
+            vertices.push_back(P3D(i, step + getRandomNumberInRange(0, 0.1), j));
+            vertices.push_back(P3D(i + 1, step + getRandomNumberInRange(0, 0.1), j));
+            vertices.push_back(P3D(i + 1, step + getRandomNumberInRange(0, 0.1), j + 1));
+            vertices.push_back(P3D(i, step + getRandomNumberInRange(0, 0.1), j + 1));
+            for (int k : {0, 1, 2, 0, 2, 3})
+                triangles.push_back(offset + k);
+        }
+}
+
+TEST(HeightFieldTest, heightsMatchTriangles) {
+    std::vector<P3D> vertices;
+    std::vector<int> triangles;
+    makeSteppedTerrain(10, vertices, triangles);
+
+    HeightField heightField;
+    heightField.bake(vertices, triangles);
+
+    constexpr double eps{1e-9};
+    for (int k = 0; k < 1000; k++) {
+        double x = getRandomNumberInRange(0, 10), z = getRandomNumberInRange(0, 10);
+
+        // the triangle (x, z) is in, by construction of the terrain
+        int i = std::min((int)x, 9), j = std::min((int)z, 9);
+        int offset = 4 * (j * 10 + i);
+        double u = x - i, v = z - j;
+        const P3D &a = vertices[offset], &b = vertices[offset + 1], &c = vertices[offset + 2], &d = vertices[offset + 3];
+        double expected = u >= v ? a.y + u * (b.y - a.y) + v * (c.y - b.y) : a.y + v * (d.y - a.y) + u * (c.y - d.y);
+
+        EXPECT_NEAR(heightField.getHeight(x, z), expected, eps);
+
+        V3D n = heightField.getNormal(x, z);
+        V3D edge = u >= v ? V3D(a, b) : V3D(d, c);
+        EXPECT_NEAR(n.norm(), 1.0, eps);
+        EXPECT_GT(n.y(), 0);
+        EXPECT_NEAR(n.dot(edge), 0, eps);
+    }
+}
+
+TEST(HeightFieldTest, batchedHeightsMatchSingleQueries) {
+    std::vector<P3D> vertices;
+    std::vector<int> triangles;
+    makeSteppedTerrain(10, vertices, triangles);
+
+    HeightField heightField;
+    heightField.bake(vertices, triangles, 0.3);
+
+    std::vector<double> xs, zs;
+    for (int k = 0; k < 100; k++) {
+        xs.push_back(getRandomNumberInRange(-1, 11));
+        zs.push_back(getRandomNumberInRange(-1, 11));
+    }
+    std::vector<double> heights(xs.size());
+    heightField.getHeights(xs.data(), zs.data(), heights.data(), (int)xs.size());
+    for (uint k = 0; k < xs.size(); k++)
+        EXPECT_EQ(heights[k], heightField.getHeight(xs[k], zs[k]));
+}
+
+TEST(HeightFieldTest, defaultHeightWhereThereIsNoSurface) {
+    std::vector<P3D> vertices = {P3D(0, 1, 0), P3D(1, 1, 0), P3D(0, 1, 1)};
+    std::vector<int> triangles = {0, 1, 2};
+
+    HeightField heightField;
+    heightField.defaultHeight = -1;
+    heightField.bake(vertices, triangles);
+
+    EXPECT_EQ(heightField.getHeight(0.25, 0.25), 1);
+    EXPECT_EQ(heightField.getHeight(0.75, 0.75), -1);
+    EXPECT_EQ(heightField.getHeight(5, 5), -1);
+    EXPECT_EQ(heightField.getNormal(5, 5), V3D(0, 1, 0));
+
+    heightField.clear();
+    EXPECT_EQ(heightField.getHeight(0.25, 0.25), -1);
+}
+
+}  // namespace crl
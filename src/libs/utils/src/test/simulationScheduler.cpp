@@ -0,0 +1,85 @@
+#include <gtest/gtest.h>
+
+#include <crl-basic/utils/simulationScheduler.h>
+
+#include <atomic>
+#include <cmath>
+#include <thread>
+
+namespace crl {
+
+TEST(SimulationSchedulerTest, stepsDoNotDependOnTheFrameRate) {
+    const double dt = 1.0 / 60.0;
+    // 10 seconds, and half a step, so that rounding cannot cost a step
+    const double duration = 10 + dt / 2;
+
+    auto simulate = [&](double frameRate, long &nSteps) {
+        SimulationScheduler scheduler(dt, 10);
+        double x = 0.1, v = 0;
+        int nFrames = (int)std::ceil(duration * frameRate);
+        for (int k = 0; k < nFrames; k++) {
+            double frameTime = std::min(1.0 / frameRate, duration - k / frameRate);
+            for (int i = scheduler.advance(frameTime); i > 0; i--) {
+                // a pendulum
+                v -= dt * 9.81 * std::sin(x);
+                x += dt * v;
+            }
+            EXPECT_GE(scheduler.getInterpolationFactor(), 0);
+            EXPECT_LT(scheduler.getInterpolationFactor(), 1);
+        }
+        nSteps = scheduler.getStepCount();
+        return x;
+    };
+
+    long nStepsReference = 0;
+    double reference = simulate(60, nStepsReference);
+    EXPECT_EQ(nStepsReference, 600);
+    for (double frameRate : {24.0, 30.0, 59.0, 75.0, 144.0, 1000.0 / 7}) {
+        long nSteps = 0;
+        EXPECT_EQ(simulate(frameRate, nSteps), reference) << frameRate;
+        EXPECT_EQ(nSteps, nStepsReference) << frameRate;
+    }
+}
+
+TEST(SimulationSchedulerTest, catchingUpIsCapped) {
+    const double dt = 0.01;
+    SimulationScheduler scheduler(dt, 4);
+
+    EXPECT_EQ(scheduler.advance(2.5 * dt), 2);
+    EXPECT_NEAR(scheduler.getInterpolationFactor(), 0.5, 1e-9);
+
+    // a long frame (e.g. a breakpoint): the time that is left is dropped
+    EXPECT_EQ(scheduler.advance(1.0), 4);
+    EXPECT_EQ(scheduler.getInterpolationFactor(), 0);
+    EXPECT_EQ(scheduler.advance(0.5 * dt), 0);
+    EXPECT_EQ(scheduler.getStepCount(), 6);
+
+    scheduler.reset();
+    EXPECT_EQ(scheduler.getInterpolationFactor(), 0);
+    EXPECT_EQ(scheduler.advance(0.5 * dt), 0);
+}
+
+TEST(SimulationSchedulerTest, threadStepsUntilStopped) {
+    SimulationScheduler scheduler(0.001);
+    std::atomic<int> nSteps(0);
+
+    EXPECT_FALSE(scheduler.isRunning());
+    scheduler.stop();
+
+    for (int run = 0; run < 2; run++) {
+        scheduler.start([&]() { nSteps++; });
+        EXPECT_TRUE(scheduler.isRunning());
+        while (nSteps < 10 * (run + 1))
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        scheduler.stop();
+        EXPECT_FALSE(scheduler.isRunning());
+
+        // no steps once stop returned
+        int nStepsWhenStopped = nSteps;
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        EXPECT_EQ(nSteps, nStepsWhenStopped);
+        EXPECT_EQ(scheduler.getStepCount(), nStepsWhenStopped);
+    }
+}
+
+}  // namespace crl
@@ -0,0 +1,55 @@
+#include <gtest/gtest.h>
+
+#include <crl-basic/utils/threadPool.h>
+
+#include <stdexcept>
+
+namespace crl {
+
+TEST(ThreadPoolTest, everyIndexRunsOnce) {
+    ThreadPool pool(4);
+    EXPECT_EQ(pool.getThreadCount(), 4);
+
+    // loops of different sizes, one after the other on the same workers
+    for (int n : {0, 1, 3, 4, 100, 10000}) {
+        std::vector<std::atomic<int>> counts(n);
+        for (auto &c : counts)
+            c = 0;
+        pool.parallelFor(n, [&](int i) { counts[i]++; });
+        for (int i = 0; i < n; i++)
+            EXPECT_EQ(counts[i], 1) << "n = " << n << ", i = " << i;
+    }
+}
+
+TEST(ThreadPoolTest, loopsFromSeveralThreads) {
+    ThreadPool pool(3);
+    std::atomic<int> sum(0);
+
+    std::vector<std::thread> threads;
+    for (int k = 0; k < 4; k++)
+        threads.push_back(std::thread([&]() {
+            for (int j = 0; j < 50; j++)
+                pool.parallelFor(10, [&](int i) { sum += i; });
+        }));
+    for (auto &t : threads)
+        t.join();
+
+    EXPECT_EQ(sum, 4 * 50 * 45);
+}
+
+TEST(ThreadPoolTest, exceptionsReachTheCaller) {
+    ThreadPool pool(2);
+    EXPECT_THROW(pool.parallelFor(100,
+                                  [](int i) {
+                                      if (i == 42)
+                                          throw std::runtime_error("42");
+                                  }),
+                 std::runtime_error);
+
+    // and the pool still works afterwards
+    std::atomic<int> count(0);
+    pool.parallelFor(100, [&](int) { count++; });
+    EXPECT_EQ(count, 100);
+}
+
+}  // namespace crl
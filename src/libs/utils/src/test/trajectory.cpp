@@ -24,4 +24,199 @@ TEST(Trajectory1DTest, linearInterpolationWithTwoPoints) {
     EXPECT_NEAR(output, expected, eps);
 }
 
+/**
+ * Exposes how the trajectory looks up knots.
+ */
+class LookupTrajectory : public Trajectory1D {
+public:
+    bool isUniformlySpaced() const {
+        return uniformSpacing;
+    }
+};
+
+/**
+ * Linear interpolation between the knots, found by scanning all of them.
+ */
+double evaluateLinearByScan(const Trajectory1D &trajectory, double t) {
+    int size = trajectory.getKnotCount();
+    if (t <= trajectory.getKnotPosition(0))
+        return trajectory.getKnotValue(0);
+    for (int i = 1; i < size; i++) {
+        double t0 = trajectory.getKnotPosition(i - 1), t1 = trajectory.getKnotPosition(i);
+        if (t < t1) {
+            double alpha = (t - t0) / (t1 - t0);
+            return (1 - alpha) * trajectory.getKnotValue(i - 1) + alpha * trajectory.getKnotValue(i);
+        }
+    }
+    return trajectory.getKnotValue(size - 1);
+}
+
+TEST(Trajectory1DTest, uniformlySpacedKnotsAreDetected) {
+    // knots at a fixed time step, accumulated the way the planners do it
+    LookupTrajectory trajectory;
+    double t = 0;
+    for (int i = 0; i < 100; i++, t += 1.0 / 30.0)
+        trajectory.addKnot(t, i * i);
+    EXPECT_TRUE(trajectory.isUniformlySpaced());
+
+    // a knot off the grid breaks the uniform spacing, removing it restores it
+    trajectory.addKnot(0.51, 0);
+    EXPECT_FALSE(trajectory.isUniformlySpaced());
+    trajectory.removeKnot(16);
+    EXPECT_TRUE(trajectory.isUniformlySpaced());
+
+    trajectory.addKnot(t + 0.5, 0);
+    EXPECT_FALSE(trajectory.isUniformlySpaced());
+}
+
+TEST(Trajectory1DTest, uniformLookupMatchesScan) {
+    LookupTrajectory trajectory;
+    double t = -1.0;
+    for (int i = 0; i < 100; i++, t += 0.1)
+        trajectory.addKnot(t, sin(i));
+    ASSERT_TRUE(trajectory.isUniformlySpaced());
+
+    // on the knots, in between them and outside of the range, going both ways
+    constexpr double eps{1e-12};
+    for (int i = -20; i < 2020; i++) {
+        double query = -1.0 + i * 0.005;
+        EXPECT_NEAR(trajectory.evaluate_linear(query), evaluateLinearByScan(trajectory, query), eps);
+    }
+    for (int i = 2020; i > -20; i--) {
+        double query = -1.0 + i * 0.005;
+        EXPECT_NEAR(trajectory.evaluate_linear(query), evaluateLinearByScan(trajectory, query), eps);
+    }
+}
+
+TEST(Trajectory1DTest, nonUniformLookupMatchesScan) {
+    LookupTrajectory trajectory;
+    srand(0);
+    double t = 0;
+    for (int i = 0; i < 100; i++) {
+        trajectory.addKnot(t, cos(i));
+        t += getRandomNumberInRange(0.01, 0.2);
+    }
+    ASSERT_FALSE(trajectory.isUniformlySpaced());
+
+    constexpr double eps{1e-12};
+    for (int i = 0; i < 1000; i++) {
+        double query = getRandomNumberInRange(-1, t + 1);
+        EXPECT_NEAR(trajectory.evaluate_linear(query), evaluateLinearByScan(trajectory, query), eps);
+    }
+}
+
+/**
+ * Catmull-rom interpolation with the slopes estimated from the knots around
+ * the interval on every call.
+ */
+double evaluateCatmullRomBySlopeEstimates(const Trajectory1D &trajectory, double t, bool equalEndpointSlopes) {
+    int size = trajectory.getKnotCount();
+    if (t <= trajectory.getKnotPosition(0))
+        return trajectory.getKnotValue(0);
+    if (t >= trajectory.getKnotPosition(size - 1))
+        return trajectory.getKnotValue(size - 1);
+
+    int index = 1;
+    while (trajectory.getKnotPosition(index) <= t)
+        index++;
+    double t0 = trajectory.getKnotPosition(index - 1), t1 = trajectory.getKnotPosition(index);
+    double m1 = trajectory.getSlopeEstimateAtKnot(index - 1, equalEndpointSlopes) * (t1 - t0);
+    double m2 = trajectory.getSlopeEstimateAtKnot(index, equalEndpointSlopes) * (t1 - t0);
+    double p1 = trajectory.getKnotValue(index - 1), p2 = trajectory.getKnotValue(index);
+    double u = (t - t0) / (t1 - t0), u2 = u * u, u3 = u2 * u;
+    return p1 * (2 * u3 - 3 * u2 + 1) + m1 * (u3 - 2 * u2 + u) + p2 * (-2 * u3 + 3 * u2) + m2 * (u3 - u2);
+}
+
+void expectCatmullRomMatchesSlopeEstimates(const Trajectory1D &trajectory) {
+    constexpr double eps{1e-12};
+    double tMin = trajectory.getMinPosition() - 0.1, tMax = trajectory.getMaxPosition() + 0.1;
+    for (int i = 0; i <= 200; i++) {
+        double t = tMin + (tMax - tMin) * i / 200.0;
+        EXPECT_NEAR(trajectory.evaluate_catmull_rom(t), evaluateCatmullRomBySlopeEstimates(trajectory, t, false), eps);
+        EXPECT_NEAR(trajectory.evaluate_catmull_rom(t, true), evaluateCatmullRomBySlopeEstimates(trajectory, t, true), eps);
+    }
+}
+
+TEST(Trajectory1DTest, catmullRomTangentsFollowKnotEdits) {
+    Trajectory1D trajectory;
+    srand(0);
+    double t = 0;
+    for (int i = 0; i < 20; i++) {
+        trajectory.addKnot(t, getRandomNumberInRange(-1, 1));
+        t += getRandomNumberInRange(0.05, 0.2);
+    }
+    expectCatmullRomMatchesSlopeEstimates(trajectory);
+
+    // knots inserted at the front, in the middle and at the end
+    trajectory.addKnot(-0.3, 2.0);
+    trajectory.addKnot(0.55, -2.0);
+    trajectory.addKnot(t + 1.0, 0.5);
+    expectCatmullRomMatchesSlopeEstimates(trajectory);
+
+    trajectory.setKnotValue(0, 1.0);
+    trajectory.setKnotValue(10, 3.0);
+    trajectory.setKnotValue(trajectory.getKnotCount() - 1, -1.0);
+    expectCatmullRomMatchesSlopeEstimates(trajectory);
+
+    trajectory.setKnotPosition(5, 0.5 * (trajectory.getKnotPosition(4) + trajectory.getKnotPosition(5)));
+    trajectory.removeKnot(0);
+    trajectory.removeKnot(7);
+    trajectory.removeKnot(trajectory.getKnotCount() - 1);
+    expectCatmullRomMatchesSlopeEstimates(trajectory);
+
+    Trajectory1D copy(trajectory);
+    expectCatmullRomMatchesSlopeEstimates(copy);
+
+    trajectory.clear();
+    trajectory.addKnot(0, 1.0);
+    trajectory.addKnot(1, 2.0);
+    expectCatmullRomMatchesSlopeEstimates(trajectory);
+}
+
+TEST(Trajectory1DTest, removingPastKnotsKeepsTheCurrentInterval) {
+    LookupTrajectory trajectory;
+    for (int i = 0; i < 20; i++)
+        trajectory.addKnot(i * 0.1, sin(i));
+
+    // knots 0 to 4 are at or before 0.45, and only the last of them stays
+    double expected = trajectory.evaluate_linear(0.45);
+    trajectory.removeKnotsBefore(0.45);
+    EXPECT_EQ(trajectory.getKnotCount(), 16);
+    EXPECT_EQ(trajectory.getKnotPosition(0), 0.4);
+    EXPECT_NEAR(trajectory.evaluate_linear(0.45), expected, 1e-12);
+    EXPECT_TRUE(trajectory.isUniformlySpaced());
+    expectCatmullRomMatchesSlopeEstimates(trajectory);
+
+    // nothing to remove before the first knot
+    trajectory.removeKnotsBefore(0.3);
+    EXPECT_EQ(trajectory.getKnotCount(), 16);
+
+    // past the end, the last knot is kept
+    trajectory.removeKnotsBefore(10);
+    EXPECT_EQ(trajectory.getKnotCount(), 1);
+    EXPECT_EQ(trajectory.getKnotValue(0), sin(19));
+}
+
+TEST(Trajectory1DTest, batchedCatmullRomMatchesSingleQueries) {
+    Trajectory1D trajectory;
+    for (int i = 0; i < 50; i++)
+        trajectory.addKnot(i * 0.1, sin(i));
+
+    // sorted queries, with repeated times and some outside of the range
+    std::vector<double> ts;
+    for (int i = -10; i < 510; i++)
+        ts.push_back(i * 0.0101);
+    ts.push_back(ts.back());
+    std::vector<double> out(ts.size());
+    trajectory.evaluate_catmull_rom(ts.data(), out.data(), (int)ts.size());
+    for (uint i = 0; i < ts.size(); i++)
+        EXPECT_EQ(out[i], trajectory.evaluate_catmull_rom(ts[i]));
+
+    // unsorted queries still work, they just need to search again
+    std::reverse(ts.begin(), ts.end());
+    trajectory.evaluate_catmull_rom(ts.data(), out.data(), (int)ts.size(), true);
+    for (uint i = 0; i < ts.size(); i++)
+        EXPECT_EQ(out[i], trajectory.evaluate_catmull_rom(ts[i], true));
+}
+
 }
@@ -0,0 +1,64 @@
+#include <gtest/gtest.h>
+
+#include <crl-basic/utils/tripleBuffer.h>
+
+#include <thread>
+#include <vector>
+
+namespace crl {
+
+TEST(TripleBufferTest, readerSeesTheLatestValue) {
+    TripleBuffer<int> buffer;
+    EXPECT_FALSE(buffer.update());
+
+    buffer.getBackBuffer() = 1;
+    buffer.publish();
+    buffer.getBackBuffer() = 2;
+    buffer.publish();
+    EXPECT_TRUE(buffer.update());
+    EXPECT_EQ(buffer.getFrontBuffer(), 2);
+
+    // nothing new
+    EXPECT_FALSE(buffer.update());
+    EXPECT_EQ(buffer.getFrontBuffer(), 2);
+
+    buffer.getBackBuffer() = 3;
+    buffer.publish();
+    EXPECT_TRUE(buffer.update());
+    EXPECT_EQ(buffer.getFrontBuffer(), 3);
+}
+
+TEST(TripleBufferTest, valuesAreNeverTorn) {
+    // every value is a vector filled with its version, so a value that was
+    // read while being written would not be uniform
+    const int nValues = 200000;
+    TripleBuffer<std::vector<int>> buffer;
+
+    std::thread writer([&]() {
+        for (int version = 1; version <= nValues; version++) {
+            auto &v = buffer.getBackBuffer();
+            v.assign(64, version);
+            buffer.publish();
+        }
+    });
+
+    int lastVersion = 0;
+    int nTorn = 0, nBackwards = 0;
+    while (lastVersion < nValues) {
+        if (!buffer.update())
+            continue;
+        const auto &v = buffer.getFrontBuffer();
+        for (int x : v)
+            if (x != v[0])
+                nTorn++;
+        if (v[0] <= lastVersion)
+            nBackwards++;
+        lastVersion = v[0];
+    }
+    writer.join();
+
+    EXPECT_EQ(nTorn, 0);
+    EXPECT_EQ(nBackwards, 0);
+}
+
+}  // namespace crl
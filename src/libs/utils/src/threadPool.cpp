@@ -0,0 +1,91 @@
+#include "crl-basic/utils/threadPool.h"
+
+#include <algorithm>
+
+namespace crl {
+
+ThreadPool::ThreadPool(int nThreads) : nextIndex(0) {
+    if (nThreads <= 0)
+        nThreads = std::max(1, (int)std::thread::hardware_concurrency());
+    for (int i = 0; i < nThreads - 1; i++)
+        workers.push_back(std::thread(&ThreadPool::workerLoop, this));
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    loopStarted.notify_all();
+    for (auto &w : workers)
+        w.join();
+}
+
+void ThreadPool::parallelFor(int n, const std::function<void(int)> &f) {
+    if (n <= 0)
+        return;
+
+    // not worth waking up the workers for
+    if (workers.empty() || n == 1) {
+        for (int i = 0; i < n; i++)
+            f(i);
+        return;
+    }
+
+    std::lock_guard<std::mutex> loopLock(loopMutex);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        loop = &f;
+        loopSize = n;
+        nextIndex = 0;
+        nBusyWorkers = (int)workers.size();
+        exception = nullptr;
+        loopCount++;
+    }
+    loopStarted.notify_all();
+
+    runIndices();
+
+    std::exception_ptr e;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        loopDone.wait(lock, [this]() { return nBusyWorkers == 0; });
+        loop = nullptr;
+        e = exception;
+    }
+    if (e)
+        std::rethrow_exception(e);
+}
+
+void ThreadPool::runIndices() {
+    for (int i = nextIndex++; i < loopSize; i = nextIndex++) {
+        try {
+            (*loop)(i);
+        } catch (...) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!exception)
+                exception = std::current_exception();
+        }
+    }
+}
+
+void ThreadPool::workerLoop() {
+    unsigned long lastLoop = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            loopStarted.wait(lock, [&]() { return stopping || loopCount != lastLoop; });
+            if (stopping)
+                return;
+            lastLoop = loopCount;
+        }
+
+        runIndices();
+
+        std::lock_guard<std::mutex> lock(mutex);
+        if (--nBusyWorkers == 0)
+            loopDone.notify_one();
+    }
+}
+
+}  // namespace crl